@@ -76,6 +76,11 @@ UINT32 I_GetFreeMem(UINT32 *total)
   return freeKBytes << 10;
 }
 
+size_t I_GetResidentMem(void)
+{
+  return 0;
+}
+
 INT64 current_time_in_ps() {
   struct timeval t;
   gettimeofday(&t, NULL);
@@ -42,6 +42,12 @@
 #include "m_argv.h"
 #include "p_setup.h"
 #include "lzf.h"
+#ifdef HAVE_THREADS
+#include "i_threads.h"
+#endif
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
 #include "lua_script.h"
 #include "lua_hook.h"
 #include "lua_libs.h"
@@ -102,6 +108,7 @@ static boolean sendingsavegame[MAXNETNODES]; // Are we sending the savegame?
 static boolean resendingsavegame[MAXNETNODES]; // Are we resending the savegame?
 static tic_t savegameresendcooldown[MAXNETNODES]; // How long before we can resend again?
 static tic_t freezetimeout[MAXNETNODES]; // Until when can this node freeze the server before getting a timeout?
+static precise_t savegamesendstart[MAXNETNODES]; // When did we finish building the savegame we're sending?
 
 // Incremented by cv_joindelay when a client joins, decremented each tic.
 // If higher than cv_joindelay * 2 (3 joins in a short timespan), joins are temporarily disabled.
@@ -181,6 +188,12 @@ consvar_t cv_showjoinaddress = CVAR_INIT ("showjoinaddress", "Off", CV_SAVE|CV_N
 static CV_PossibleValue_t playbackspeed_cons_t[] = {{1, "MIN"}, {10, "MAX"}, {0, NULL}};
 consvar_t cv_playbackspeed = CVAR_INIT ("playbackspeed", "1", 0, playbackspeed_cons_t, NULL);
 
+// Converts a precise_t duration to milliseconds, for join timings
+static double PreciseToMS(precise_t t)
+{
+	return (double)t * 1000.0 / I_GetPrecisePrecision();
+}
+
 static inline void *G_DcpyTiccmd(void* dest, const ticcmd_t* src, const size_t n)
 {
 	const size_t d = n / sizeof(ticcmd_t);
@@ -208,6 +221,234 @@ static inline void *G_ScpyTiccmd(ticcmd_t* dest, void* src, const size_t n)
 }
 
 
+// PT_SERVERTICSDELTA cmds: for each tic and each slot, a byte saying which
+// fields differ from the same slot in the previous tic of the packet (the
+// first tic is compared to an empty cmd), followed by just those fields.
+// Turning and aiming are sent as zigzag varint deltas, buttons as a varint.
+// The packet is self-contained so losing or reordering packets is harmless.
+#define TICDELTA_FORWARD 0x01
+#define TICDELTA_SIDE    0x02
+#define TICDELTA_ANGLE   0x04
+#define TICDELTA_AIMING  0x08
+#define TICDELTA_BUTTONS 0x10
+#define TICDELTA_LATENCY 0x20
+
+// Worst case for one cmd: mask, 2 bytes, 3 varints of up to 3 bytes, latency
+#define TICDELTA_MAXCMDSIZE 13
+
+static boolean nodedeltatics[MAXNETNODES]; // Does this node understand PT_SERVERTICSDELTA?
+
+// Per-node pacing of PT_SERVERTICS(DELTA), see SV_SendTics
+#define TICSCHED_MINRATE 512 // Bytes per tic a node is never throttled below
+#define TICSCHED_RATESTEP 64 // Bytes per tic added each time the node acknowledges new tics
+
+typedef struct
+{
+	tic_t ackedtic; // Last nettics seen, every tic before it was received
+	tic_t acktime; // When ackedtic last moved or tics were last resent
+	tic_t refilltime; // When budget was last refilled
+	INT32 rate; // Estimated bytes per tic the node can take
+	INT32 budget; // Bytes that can still be sent before the node is throttled
+} ticsched_t;
+
+static ticsched_t ticsched[MAXNETNODES];
+
+static UINT8 *WriteTicVarint(UINT8 *p, UINT16 value)
+{
+	while (value >= 0x80)
+	{
+		*p++ = (UINT8)(value | 0x80);
+		value >>= 7;
+	}
+	*p++ = (UINT8)value;
+	return p;
+}
+
+static const UINT8 *ReadTicVarint(const UINT8 *p, const UINT8 *end, UINT16 *value)
+{
+	UINT32 v = 0;
+	INT32 shift;
+
+	for (shift = 0; shift < 21; shift += 7)
+	{
+		if (p >= end)
+			return NULL;
+		v |= (UINT32)(*p & 0x7F) << shift;
+		if (!(*p++ & 0x80))
+		{
+			*value = (UINT16)v;
+			return p;
+		}
+	}
+	return NULL;
+}
+
+#define ZIGZAG16(x) ((UINT16)(((UINT16)(x) << 1) ^ (UINT16)((INT16)(x) >> 15)))
+#define UNZIGZAG16(x) ((INT16)(((x) >> 1) ^ (UINT16)-(INT16)((x) & 1)))
+
+/** Delta-codes the cmds of one tic against those of the tic before it
+  *
+  * \param p Where to write the coded cmds
+  * \param end End of the space available at p
+  * \param tic Tic to code
+  * \param first Code against empty cmds instead, as for the first tic of a packet
+  * \param numslots Number of player slots per tic
+  * \return Where the coded cmds end, or NULL if they didn't fit before end
+  *
+  */
+static UINT8 *SV_DeltaCodeTic(UINT8 *p, const UINT8 *end, tic_t tic, boolean first, INT32 numslots)
+{
+	static const ticcmd_t emptycmd = {0};
+	INT32 j;
+
+	for (j = 0; j < numslots; j++)
+	{
+		const ticcmd_t *cmd = &netcmds[tic%BACKUPTICS][j];
+		const ticcmd_t *prev = first ? &emptycmd : &netcmds[(tic-1)%BACKUPTICS][j];
+		UINT8 *mask;
+
+		if (end - p < TICDELTA_MAXCMDSIZE)
+			return NULL;
+
+		mask = p++;
+		*mask = 0;
+
+		if (cmd->forwardmove != prev->forwardmove)
+		{
+			*mask |= TICDELTA_FORWARD;
+			*p++ = (UINT8)cmd->forwardmove;
+		}
+		if (cmd->sidemove != prev->sidemove)
+		{
+			*mask |= TICDELTA_SIDE;
+			*p++ = (UINT8)cmd->sidemove;
+		}
+		if (cmd->angleturn != prev->angleturn)
+		{
+			*mask |= TICDELTA_ANGLE;
+			p = WriteTicVarint(p, ZIGZAG16(cmd->angleturn - prev->angleturn));
+		}
+		if (cmd->aiming != prev->aiming)
+		{
+			*mask |= TICDELTA_AIMING;
+			p = WriteTicVarint(p, ZIGZAG16(cmd->aiming - prev->aiming));
+		}
+		if (cmd->buttons != prev->buttons)
+		{
+			*mask |= TICDELTA_BUTTONS;
+			p = WriteTicVarint(p, cmd->buttons);
+		}
+		if (cmd->latency != prev->latency)
+		{
+			*mask |= TICDELTA_LATENCY;
+			*p++ = cmd->latency;
+		}
+	}
+
+	return p;
+}
+
+/** Delta-codes the cmds for tics [first, last) into buf.
+  *
+  * \param buf Where to write the coded cmds
+  * \param first First tic to code
+  * \param last Tic to stop at
+  * \param numslots Number of player slots per tic
+  * \param maxsize Give up once the coded cmds would take more than this
+  * \return Size of the coded cmds, or 0 if they didn't fit in maxsize
+  *
+  */
+static size_t SV_DeltaCodeTics(UINT8 *buf, tic_t first, tic_t last, INT32 numslots, size_t maxsize)
+{
+	UINT8 *p = buf;
+	tic_t tic;
+
+	for (tic = first; tic < last; tic++)
+		if (!(p = SV_DeltaCodeTic(p, buf + maxsize, tic, tic == first, numslots)))
+			return 0;
+
+	return (size_t)(p - buf);
+}
+
+/** Decodes the cmds of a PT_SERVERTICSDELTA packet.
+  *
+  * \param cmds Where to put numtics * numslots cmds, in the same wire
+  *             format as PT_SERVERTICS so they can be copied the same way
+  * \param end End of the received packet
+  * \return Where the textcmds start, or NULL if the packet is malformed
+  *
+  */
+static const UINT8 *CL_DecodeDeltaTics(ticcmd_t *cmds, const UINT8 *end)
+{
+	const servertics_pak *pak = &netbuffer->u.serverpak;
+	const UINT8 *p = (const UINT8 *)&pak->cmds;
+	ticcmd_t prev[MAXPLAYERS], cmd;
+	INT32 i, j;
+	UINT16 v;
+
+	if (pak->numslots > MAXPLAYERS)
+		return NULL;
+
+	memset(prev, 0, sizeof (prev));
+
+	for (i = 0; i < pak->numtics; i++)
+	{
+		for (j = 0; j < pak->numslots; j++)
+		{
+			UINT8 mask;
+
+			if (p >= end)
+				return NULL;
+
+			mask = *p++;
+			cmd = prev[j];
+
+			if (mask & TICDELTA_FORWARD)
+			{
+				if (p >= end)
+					return NULL;
+				cmd.forwardmove = (SINT8)*p++;
+			}
+			if (mask & TICDELTA_SIDE)
+			{
+				if (p >= end)
+					return NULL;
+				cmd.sidemove = (SINT8)*p++;
+			}
+			if (mask & TICDELTA_ANGLE)
+			{
+				if (!(p = ReadTicVarint(p, end, &v)))
+					return NULL;
+				cmd.angleturn = (INT16)(cmd.angleturn + UNZIGZAG16(v));
+			}
+			if (mask & TICDELTA_AIMING)
+			{
+				if (!(p = ReadTicVarint(p, end, &v)))
+					return NULL;
+				cmd.aiming = (INT16)(cmd.aiming + UNZIGZAG16(v));
+			}
+			if (mask & TICDELTA_BUTTONS)
+			{
+				if (!(p = ReadTicVarint(p, end, &v)))
+					return NULL;
+				cmd.buttons = v;
+			}
+			if (mask & TICDELTA_LATENCY)
+			{
+				if (p >= end)
+					return NULL;
+				cmd.latency = *p++;
+			}
+
+			prev[j] = cmd;
+			G_MoveTiccmd(&cmds[i*pak->numslots + j], &cmd, 1);
+		}
+	}
+
+	return p;
+}
+
+
 
 // Some software don't support largest packet
 // (original sersetup, not exactely, but the probability of sending a packet
@@ -1282,6 +1523,9 @@ static boolean CL_SendJoin(void)
 	strncpy(netbuffer->u.clientcfg.names[0], cv_playername.zstring, MAXPLAYERNAME);
 	strncpy(netbuffer->u.clientcfg.names[1], cv_playername2.zstring, MAXPLAYERNAME);
 
+	netbuffer->u.clientcfg.mode = 0;
+	netbuffer->u.clientcfg.capabilities = CLIENTCAP_DELTATICS;
+
 	return HSendPacket(servernode, true, 0, sizeof (clientconfig_pak));
 }
 
@@ -1524,7 +1768,29 @@ static boolean SV_SendServerConfig(INT32 node)
 }
 
 #ifndef NONET
-#define SAVEGAMESIZE (768*1024)
+#define SAVEGAMESIZE (768*1024) // initial size, the buffer grows as needed
+
+// First byte of a sent savegame, followed by the decompressed length
+enum
+{
+	SAVECOMPRESS_NONE,
+	SAVECOMPRESS_LZF,
+	SAVECOMPRESS_ZLIB,
+};
+#define SAVEHEADERSIZE (sizeof(UINT8) + sizeof(UINT32))
+
+static CV_PossibleValue_t netsavecompression_cons_t[] = {
+	{SAVECOMPRESS_NONE, "None"},
+	{SAVECOMPRESS_LZF, "LZF"},
+#ifdef HAVE_ZLIB
+	{SAVECOMPRESS_ZLIB, "Zlib"},
+#endif
+	{0, NULL}};
+#ifdef HAVE_ZLIB
+consvar_t cv_netsavecompression = CVAR_INIT ("netsavecompression", "Zlib", CV_SAVE, netsavecompression_cons_t, NULL);
+#else
+consvar_t cv_netsavecompression = CVAR_INIT ("netsavecompression", "LZF", CV_SAVE, netsavecompression_cons_t, NULL);
+#endif
 
 static boolean SV_ResendingSavegameToAnyone(void)
 {
@@ -1536,72 +1802,263 @@ static boolean SV_ResendingSavegameToAnyone(void)
 	return false;
 }
 
-static void SV_SendSaveGame(INT32 node, boolean resending)
+/** Compresses a savegame payload into a new buffer with room for the header
+  *
+  * \param method     SAVECOMPRESS_LZF or SAVECOMPRESS_ZLIB
+  * \param data       Uncompressed payload
+  * \param length     Length of the payload
+  * \param outlength  Set to the length of the compressed payload
+  * \return A malloced buffer, or NULL if compression did not make it smaller
+  *
+  */
+static UINT8 *SV_CompressSaveGame(INT32 method, const UINT8 *data, size_t length, size_t *outlength)
 {
-	size_t length, compressedlen;
-	UINT8 *savebuffer;
 	UINT8 *compressedsave;
-	UINT8 *buffertosend;
 
-	// first save it in a malloced buffer
-	savebuffer = (UINT8 *)malloc(SAVEGAMESIZE);
-	if (!savebuffer)
+	// Allocate space for compressed save: one byte fewer than for the
+	// uncompressed data to ensure that the compression is worthwhile.
+	if (length < 2 || !(compressedsave = malloc(SAVEHEADERSIZE + length - 1)))
+		return NULL;
+
+	switch (method)
 	{
-		CONS_Alert(CONS_ERROR, M_GetText("No more free memory for savegame\n"));
-		return;
+		case SAVECOMPRESS_LZF:
+			*outlength = lzf_compress(data, length, compressedsave + SAVEHEADERSIZE, length - 1);
+			break;
+#ifdef HAVE_ZLIB
+		case SAVECOMPRESS_ZLIB:
+		{
+			uLongf destlen = (uLongf)(length - 1);
+			if (compress2(compressedsave + SAVEHEADERSIZE, &destlen, data, (uLong)length, Z_BEST_SPEED) == Z_OK)
+				*outlength = destlen;
+			else
+				*outlength = 0;
+			break;
+		}
+#endif
+		default:
+			*outlength = 0;
+			break;
 	}
 
-	// Leave room for the uncompressed length.
-	save_p = savebuffer + sizeof(UINT32);
+	if (!*outlength)
+	{
+		free(compressedsave);
+		return NULL;
+	}
+	return compressedsave;
+}
 
-	P_SaveNetGame(resending);
+// A savegame snapshot waiting to be encoded for one node.
+// Everything in here only touches malloced memory, so the encoding
+// step can run away from the main thread.
+typedef struct
+{
+	UINT8 *buffer; // header + payload; raw snapshot, then the buffer to send
+	size_t rawlength; // payload length before compression
+	size_t length; // payload length as sent
+	INT32 method;
+	precise_t savetime, compresstime;
+	boolean done; // encoding finished, protected by savegamejob_mutex
+	boolean cancelled; // node went away, the worker frees the job
+} savegamejob_t;
+
+static savegamejob_t *savegamejobs[MAXNETNODES];
+#ifdef HAVE_THREADS
+static I_mutex savegamejob_mutex;
+#endif
+
+/** Compresses a snapshot and writes its header, making it ready to send
+  *
+  * \param job The job to encode
+  *
+  */
+static void SV_EncodeSaveGame(savegamejob_t *job)
+{
+	UINT8 *compressedsave = NULL;
+	UINT8 *p;
+	precise_t t = I_GetPreciseTime();
+
+	if (job->method != SAVECOMPRESS_NONE)
+		compressedsave = SV_CompressSaveGame(job->method, job->buffer + SAVEHEADERSIZE, job->rawlength, &job->length);
 
-	length = save_p - savebuffer;
-	if (length > SAVEGAMESIZE)
+	if (compressedsave)
+	{
+		// Compressing succeeded; send compressed data
+		free(job->buffer);
+		job->buffer = compressedsave;
+	}
+	else
 	{
-		free(savebuffer);
-		save_p = NULL;
-		I_Error("Savegame buffer overrun");
+		// Compression failed to make it smaller; send original
+		job->method = SAVECOMPRESS_NONE;
+		job->length = job->rawlength;
 	}
 
-	// Allocate space for compressed save: one byte fewer than for the
-	// uncompressed data to ensure that the compression is worthwhile.
-	compressedsave = malloc(length - 1);
-	if (!compressedsave)
+	p = job->buffer;
+	WRITEUINT8(p, job->method);
+	WRITEUINT32(p, job->method == SAVECOMPRESS_NONE ? 0 : job->rawlength);
+
+	job->compresstime = I_GetPreciseTime() - t;
+}
+
+#ifdef HAVE_THREADS
+static void SV_SaveGameEncodeThread(void *userdata)
+{
+	savegamejob_t *job = userdata;
+	boolean cancelled;
+
+	SV_EncodeSaveGame(job);
+
+	I_lock_mutex(&savegamejob_mutex);
 	{
-		CONS_Alert(CONS_ERROR, M_GetText("No more free memory for savegame\n"));
-		return;
+		job->done = true;
+		cancelled = job->cancelled;
 	}
+	I_unlock_mutex(savegamejob_mutex);
 
-	// Attempt to compress it.
-	if((compressedlen = lzf_compress(savebuffer + sizeof(UINT32), length - sizeof(UINT32), compressedsave + sizeof(UINT32), length - sizeof(UINT32) - 1)))
+	if (cancelled)
 	{
-		// Compressing succeeded; send compressed data
+		free(job->buffer);
+		free(job);
+	}
+}
+#endif
 
-		free(savebuffer);
+/** Hands an encoded savegame over to the file transfer queue
+  *
+  * \param node The node the savegame is for
+  *
+  */
+static void SV_QueueSaveGame(INT32 node)
+{
+	savegamejob_t *job = savegamejobs[node];
+	size_t length = job->length + SAVEHEADERSIZE;
+
+	savegamejobs[node] = NULL;
 
-		// State that we're compressed.
-		buffertosend = compressedsave;
-		WRITEUINT32(compressedsave, length - sizeof(UINT32));
-		length = compressedlen + sizeof(UINT32);
+	CONS_Printf(M_GetText("Sending gamestate to node %d: %s bytes, %s %s bytes (save %.1f ms, compress %.1f ms)\n"),
+		node, sizeu1(job->rawlength), netsavecompression_cons_t[job->method].strvalue, sizeu2(job->length),
+		PreciseToMS(job->savetime), PreciseToMS(job->compresstime));
+
+	AddRamToSendQueue(node, job->buffer, length, SF_RAM, 0);
+	free(job);
+
+	// Remember when we started sending the savegame so we can handle timeouts
+	savegamesendstart[node] = I_GetPreciseTime();
+	freezetimeout[node] = I_GetTime() + jointimeout + length / 1024; // 1 extra tic for each kilobyte
+}
+
+/** Queues any savegames the encoder thread has finished with
+  */
+static void SV_PollSaveGameJobs(void)
+{
+	INT32 node;
+
+	for (node = 0; node < MAXNETNODES; node++)
+	{
+		boolean done;
+
+		if (!savegamejobs[node])
+			continue;
+
+#ifdef HAVE_THREADS
+		I_lock_mutex(&savegamejob_mutex);
+		{
+			done = savegamejobs[node]->done;
+		}
+		I_unlock_mutex(savegamejob_mutex);
+#else
+		done = savegamejobs[node]->done;
+#endif
+
+		if (done)
+			SV_QueueSaveGame(node);
 	}
-	else
+}
+
+/** Drops a savegame that is still being encoded for a node
+  *
+  * \param node The node that went away
+  *
+  */
+static void SV_CancelSaveGameJob(INT32 node)
+{
+	savegamejob_t *job = savegamejobs[node];
+	boolean done = true;
+
+	if (!job)
+		return;
+
+	savegamejobs[node] = NULL;
+
+#ifdef HAVE_THREADS
+	I_lock_mutex(&savegamejob_mutex);
 	{
-		// Compression failed to make it smaller; send original
+		done = job->done;
+		job->cancelled = true;
+	}
+	I_unlock_mutex(savegamejob_mutex);
+#endif
 
-		free(compressedsave);
+	// Otherwise the encoder thread frees it when it's finished
+	if (done)
+	{
+		free(job->buffer);
+		free(job);
+	}
+}
+
+static void SV_SendSaveGame(INT32 node, boolean resending)
+{
+	savegamejob_t *job;
+	precise_t t = I_GetPreciseTime();
+
+	SV_CancelSaveGameJob(node);
 
-		// State that we're not compressed
-		buffertosend = savebuffer;
-		WRITEUINT32(savebuffer, 0);
+	job = calloc(1, sizeof (*job));
+	if (!job)
+	{
+		CONS_Alert(CONS_ERROR, M_GetText("No more free memory for savegame\n"));
+		return;
 	}
 
-	AddRamToSendQueue(node, buffertosend, length, SF_RAM, 0);
-	save_p = NULL;
+	// first save it in a malloced buffer
+	if (!P_SaveBufferAlloc(SAVEGAMESIZE))
+	{
+		free(job);
+		CONS_Alert(CONS_ERROR, M_GetText("No more free memory for savegame\n"));
+		return;
+	}
+
+	// Leave room for the header.
+	save_p += SAVEHEADERSIZE;
+
+	// The snapshot has to be taken now, between tics, but
+	// compressing it doesn't touch the game state at all.
+	P_SaveNetGame(resending);
+
+	job->buffer = P_SaveBufferFinish(&job->rawlength);
+	job->rawlength -= SAVEHEADERSIZE;
+	job->method = cv_netsavecompression.value;
+	job->savetime = I_GetPreciseTime() - t;
+	savegamejobs[node] = job;
 
 	// Remember when we started sending the savegame so we can handle timeouts
 	sendingsavegame[node] = true;
-	freezetimeout[node] = I_GetTime() + jointimeout + length / 1024; // 1 extra tic for each kilobyte
+	freezetimeout[node] = I_GetTime() + jointimeout + job->rawlength / 1024;
+
+#ifdef HAVE_THREADS
+	if (job->method != SAVECOMPRESS_NONE)
+	{
+		I_spawn_thread("savegame-encode", SV_SaveGameEncodeThread, job);
+		return;
+	}
+#endif
+
+	SV_EncodeSaveGame(job);
+	job->done = true;
+	SV_QueueSaveGame(node);
 }
 
 #ifdef DUMPCONSISTENCY
@@ -1620,8 +2077,7 @@ static void SV_SavedGame(void)
 	sprintf(tmpsave, "%s" PATHSEP TMPSAVENAME, srb2home);
 
 	// first save it in a malloced buffer
-	save_p = savebuffer = (UINT8 *)malloc(SAVEGAMESIZE);
-	if (!save_p)
+	if (!P_SaveBufferAlloc(SAVEGAMESIZE))
 	{
 		CONS_Alert(CONS_ERROR, M_GetText("No more free memory for savegame\n"));
 		return;
@@ -1629,13 +2085,7 @@ static void SV_SavedGame(void)
 
 	P_SaveNetGame(false);
 
-	length = save_p - savebuffer;
-	if (length > SAVEGAMESIZE)
-	{
-		free(savebuffer);
-		save_p = NULL;
-		I_Error("Savegame buffer overrun");
-	}
+	savebuffer = P_SaveBufferFinish(&length);
 
 	// then save it!
 	if (!FIL_WriteFile(tmpsave, savebuffer, length))
@@ -1654,16 +2104,19 @@ static void CL_LoadReceivedSavegame(boolean reloading)
 {
 	UINT8 *savebuffer = NULL;
 	size_t length, decompressedlen;
+	UINT8 method;
 	char tmpsave[256];
+	precise_t t0, t1, t2;
 
 	FreeFileNeeded();
 
 	sprintf(tmpsave, "%s" PATHSEP TMPSAVENAME, srb2home);
 
+	t0 = I_GetPreciseTime();
 	length = FIL_ReadFile(tmpsave, &savebuffer);
 
 	CONS_Printf(M_GetText("Loading savegame length %s\n"), sizeu1(length));
-	if (!length)
+	if (length < SAVEHEADERSIZE)
 	{
 		I_Error("Can't read savegame sent");
 		return;
@@ -1672,14 +2125,39 @@ static void CL_LoadReceivedSavegame(boolean reloading)
 	save_p = savebuffer;
 
 	// Decompress saved game if necessary.
+	method = READUINT8(save_p);
 	decompressedlen = READUINT32(save_p);
-	if(decompressedlen > 0)
+	length -= SAVEHEADERSIZE;
+	if (method != SAVECOMPRESS_NONE)
 	{
 		UINT8 *decompressedbuffer = Z_Malloc(decompressedlen, PU_STATIC, NULL);
-		lzf_decompress(save_p, length - sizeof(UINT32), decompressedbuffer, decompressedlen);
+		size_t outlen = 0;
+
+		switch (method)
+		{
+			case SAVECOMPRESS_LZF:
+				outlen = lzf_decompress(save_p, length, decompressedbuffer, decompressedlen);
+				break;
+#ifdef HAVE_ZLIB
+			case SAVECOMPRESS_ZLIB:
+			{
+				uLongf destlen = (uLongf)decompressedlen;
+				if (uncompress(decompressedbuffer, &destlen, save_p, (uLong)length) == Z_OK)
+					outlen = destlen;
+				break;
+			}
+#endif
+			default:
+				break;
+		}
+
+		if (outlen != decompressedlen)
+			I_Error("Can't decompress savegame sent (method %d)", method);
+
 		Z_Free(savebuffer);
 		save_p = savebuffer = decompressedbuffer;
 	}
+	t1 = I_GetPreciseTime();
 
 	paused = false;
 	demoplayback = false;
@@ -1706,6 +2184,8 @@ static void CL_LoadReceivedSavegame(boolean reloading)
 	// done
 	Z_Free(savebuffer);
 	save_p = NULL;
+	t2 = I_GetPreciseTime();
+	CONS_Printf(M_GetText("Gamestate loaded (read %.1f ms, load %.1f ms)\n"), PreciseToMS(t1 - t0), PreciseToMS(t2 - t1));
 	if (unlink(tmpsave) == -1)
 		CONS_Alert(CONS_ERROR, M_GetText("Can't delete %s\n"), tmpsave);
 	consistancy[gametic%BACKUPTICS] = Consistancy();
@@ -3589,8 +4069,8 @@ consvar_t cv_maxsend = CVAR_INIT ("maxsend", "4096", CV_SAVE|CV_NETVAR, maxsend_
 consvar_t cv_noticedownload = CVAR_INIT ("noticedownload", "Off", CV_SAVE|CV_NETVAR, CV_OnOff, NULL);
 
 // Speed of file downloading (in packets per tic)
-static CV_PossibleValue_t downloadspeed_cons_t[] = {{1, "MIN"}, {300, "MAX"}, {0, NULL}};
-consvar_t cv_downloadspeed = CVAR_INIT ("downloadspeed", "16", CV_SAVE|CV_NETVAR, downloadspeed_cons_t, NULL);
+static CV_PossibleValue_t downloadspeed_cons_t[] = {{1, "MIN"}, {1024, "MAX"}, {0, NULL}};
+consvar_t cv_downloadspeed = CVAR_INIT ("downloadspeed", "64", CV_SAVE|CV_NETVAR, downloadspeed_cons_t, NULL);
 
 // DISCORD STUFF //
 // Discord Invitses; Here for Dedicated Servers or Something for Some Reason idk
@@ -3645,6 +4125,21 @@ void D_ClientServerInit(void)
 		SV_SpawnServer();
 }
 
+static INT32 SV_TicScheduleMaxRate(void)
+{
+	return max(net_bandwidth / TICRATE, TICSCHED_MINRATE);
+}
+
+static void SV_ResetTicSchedule(INT32 node)
+{
+	ticsched_t *sched = &ticsched[node];
+
+	sched->ackedtic = nettics[node];
+	sched->acktime = sched->refilltime = I_GetTime();
+	sched->rate = SV_TicScheduleMaxRate();
+	sched->budget = sched->rate;
+}
+
 static void ResetNode(INT32 node)
 {
 	nodeingame[node] = false;
@@ -3652,6 +4147,7 @@ static void ResetNode(INT32 node)
 
 	nettics[node] = gametic;
 	supposedtics[node] = gametic;
+	SV_ResetTicSchedule(node);
 
 	nodetoplayer[node] = -1;
 	nodetoplayer2[node] = -1;
@@ -3660,6 +4156,11 @@ static void ResetNode(INT32 node)
 	sendingsavegame[node] = false;
 	resendingsavegame[node] = false;
 	savegameresendcooldown[node] = 0;
+#ifndef NONET
+	SV_CancelSaveGameJob(node);
+#endif
+
+	nodedeltatics[node] = false;
 }
 
 void SV_ResetServer(void)
@@ -3797,6 +4298,7 @@ static inline void SV_AddNode(INT32 node)
 {
 	nettics[node] = gametic;
 	supposedtics[node] = gametic;
+	SV_ResetTicSchedule(node);
 	// little hack because the server connects to itself and puts
 	// nodeingame when connected not here
 	if (node)
@@ -4234,6 +4736,10 @@ static void HandleConnect(SINT8 node)
 
 		// client authorised to join
 		nodewaiting[node] = (UINT8)(netbuffer->u.clientcfg.localplayers - playerpernode[node]);
+
+		// Older clients send a shorter join packet without capabilities
+		nodedeltatics[node] = doomcom->datalength >= (INT32)(BASEPACKETSIZE + sizeof (clientconfig_pak))
+			&& (netbuffer->u.clientcfg.capabilities & CLIENTCAP_DELTATICS);
 		if (!nodeingame[node])
 		{
 			gamestate_t backupstate = gamestate;
@@ -4591,6 +5097,7 @@ static void HandlePacketFromAwayNode(SINT8 node)
 			break; // This is not an "unknown packet"
 
 		case PT_SERVERTICS:
+		case PT_SERVERTICSDELTA:
 			// Do not remove my own server (we have just get a out of order packet)
 			if (node == servernode)
 				break;
@@ -4617,11 +5124,13 @@ static void HandlePacketFromPlayer(SINT8 node)
 {
 	INT32 netconsole;
 	tic_t realend, realstart;
-	UINT8 *pak, *txtpak, numtxtpak;
+	UINT8 *pak, numtxtpak;
+	const UINT8 *txtpak;
 #ifndef NOMD5
 	UINT8 finalmd5[16];/* Well, it's the cool thing to do? */
 #endif
 
+	pak = NULL;
 	txtpak = NULL;
 
 	if (dedicated && node == 0)
@@ -4867,11 +5376,39 @@ static void HandlePacketFromPlayer(SINT8 node)
 				SV_HandleLuaFileSent(node);
 			break;
 		case PT_RECEIVEDGAMESTATE:
+			if (sendingsavegame[node])
+				CONS_Printf(M_GetText("Node %d received and loaded the gamestate in %.1f ms\n"),
+					node, PreciseToMS(I_GetPreciseTime() - savegamesendstart[node]));
 			sendingsavegame[node] = false;
 			resendingsavegame[node] = false;
 			savegameresendcooldown[node] = I_GetTime() + 5 * TICRATE;
 			break;
 // -------------------------------------------- CLIENT RECEIVE ----------
+		case PT_SERVERTICSDELTA:
+			// Only accept PT_SERVERTICSDELTA from the server.
+			if (node != servernode)
+			{
+				CONS_Alert(CONS_WARNING, M_GetText("%s received from non-host %d\n"), "PT_SERVERTICSDELTA", node);
+				if (server)
+					SendKick(netconsole, KICK_MSG_CON_FAIL | KICK_MSG_KEEP_BODY);
+				break;
+			}
+			else
+			{
+				static ticcmd_t deltacmds[MAXPACKETLENGTH / 2];
+
+				if ((size_t)netbuffer->u.serverpak.numtics * netbuffer->u.serverpak.numslots > sizeof (deltacmds) / sizeof (*deltacmds))
+					break;
+
+				txtpak = CL_DecodeDeltaTics(deltacmds, (UINT8 *)netbuffer + doomcom->datalength);
+				if (!txtpak)
+				{
+					DEBFILE("Bad PT_SERVERTICSDELTA packet\n");
+					break;
+				}
+				pak = (UINT8 *)deltacmds;
+			}
+			/* FALLTHRU */
 		case PT_SERVERTICS:
 			// Only accept PT_SERVERTICS from the server.
 			if (node != servernode)
@@ -4886,7 +5423,7 @@ static void HandlePacketFromPlayer(SINT8 node)
 			realend = realstart + netbuffer->u.serverpak.numtics;
 
 			if (!txtpak)
-				txtpak = (UINT8 *)&netbuffer->u.serverpak.cmds[netbuffer->u.serverpak.numslots
+				txtpak = (const UINT8 *)&netbuffer->u.serverpak.cmds[netbuffer->u.serverpak.numslots
 					* netbuffer->u.serverpak.numtics];
 
 			if (realend > gametic + CLIENTBACKUPTICS)
@@ -4896,7 +5433,8 @@ static void HandlePacketFromPlayer(SINT8 node)
 			if (realstart <= neededtic && realend > neededtic)
 			{
 				tic_t i, j;
-				pak = (UINT8 *)&netbuffer->u.serverpak.cmds;
+				if (!pak)
+					pak = (UINT8 *)&netbuffer->u.serverpak.cmds;
 
 				for (i = realstart; i < realend; i++)
 				{
@@ -5220,48 +5758,124 @@ static void CL_SendClientCmd(void)
 
 // send the server packet
 // send tic from firstticstosend to maketic-1
+/** Tics a node has not acknowledged after this long are supposed lost
+  *
+  * \param node The node the tics were sent to
+  * \return The timeout in tics, a little more than the node's round trip
+  *
+  */
+static tic_t SV_TicResendTimeout(INT32 node)
+{
+	tic_t timeout = 2;
+
+	if (nodetoplayer[node] >= 0)
+		timeout += playerpingtable[nodetoplayer[node]] * TICRATE / 1000;
+	return timeout;
+}
+
+/** Refills a node's send budget and follows its acknowledged tics
+  *
+  * The rate grows by TICSCHED_RATESTEP every time the node acknowledges
+  * new tics and is halved when tics have to be resent, so a lagging node
+  * catches up at the speed it can actually take instead of in bursts.
+  *
+  * \param node The node to update
+  * \param now  The current time
+  *
+  */
+static void SV_UpdateTicSchedule(INT32 node, tic_t now)
+{
+	ticsched_t *sched = &ticsched[node];
+	const INT32 maxrate = SV_TicScheduleMaxRate();
+
+	if (nettics[node] > sched->ackedtic)
+	{
+		sched->ackedtic = nettics[node];
+		sched->acktime = now;
+		sched->rate = min(sched->rate + TICSCHED_RATESTEP, maxrate);
+	}
+
+	if (now > sched->refilltime)
+	{
+		sched->budget += sched->rate * (INT32)min(now - sched->refilltime, 2);
+		sched->budget = min(sched->budget, 2 * sched->rate);
+		sched->refilltime = now;
+	}
+}
+
 static void SV_SendTics(void)
 {
 	tic_t realfirsttic, lasttictosend, i;
+	const tic_t now = I_GetTime();
 	UINT32 n;
 	INT32 j;
-	size_t packsize;
+	size_t packsize, sendsize, rawcmdsize, deltacmdsize;
 	UINT8 *bufpos;
 	UINT8 *ntextcmd;
 
 	// send to all client but not to me
 	// for each node create a packet with x tics and send it
-	// x is computed using supposedtics[n], max packet size and maketic
+	// x is computed using supposedtics[n], max packet size, the node's budget and maketic
 	for (n = 1; n < MAXNETNODES; n++)
 		if (nodeingame[n])
 		{
+			ticsched_t *sched = &ticsched[n];
+
+			SV_UpdateTicSchedule(n, now);
+
 			// assert supposedtics[n]>=nettics[n]
 			realfirsttic = supposedtics[n];
 			lasttictosend = min(maketic, nettics[n] + CLIENTBACKUPTICS);
 
-			if (realfirsttic >= lasttictosend)
+			// Tics sent a round trip ago that are still not acknowledged are
+			// supposed lost (this is necessary since lost packet detection work
+			// when we have received packet with firsttic > neededtic
+			// (getpacket servertics case)), so resend them in the same packet
+			// as the new tics rather than on their own
+			if (nettics[n] < min(realfirsttic, lasttictosend)
+				&& now >= sched->acktime + SV_TicResendTimeout(n))
 			{
-				// well we have sent all tics we will so use extrabandwidth
-				// to resent packet that are supposed lost (this is necessary since lost
-				// packet detection work when we have received packet with firsttic > neededtic
-				// (getpacket servertics case)
-				DEBFILE(va("Nothing to send node %u mak=%u sup=%u net=%u \n",
-					n, maketic, supposedtics[n], nettics[n]));
+				DEBFILE(va("Resend node %u from %u mak=%u sup=%u\n",
+					n, nettics[n], maketic, supposedtics[n]));
 				realfirsttic = nettics[n];
-				if (realfirsttic >= lasttictosend || (I_GetTime() + n)&3)
-					// all tic are ok
-					continue;
-				DEBFILE(va("Sent %d anyway\n", realfirsttic));
+				sched->acktime = now;
+				sched->rate = max(sched->rate / 2, TICSCHED_MINRATE);
 			}
+
+			if (realfirsttic >= lasttictosend)
+				continue; // all tic are ok
 			if (realfirsttic < firstticstosend)
 				realfirsttic = firstticstosend;
 
 			// compute the length of the packet and cut it if too large
 			packsize = BASESERVERTICSSIZE;
+			rawcmdsize = deltacmdsize = 0;
 			for (i = realfirsttic; i < lasttictosend; i++)
 			{
 				packsize += sizeof (ticcmd_t) * doomcom->numslots;
 				packsize += TotalTextCmdPerTic(i);
+				rawcmdsize += sizeof (ticcmd_t) * doomcom->numslots;
+
+				// The budget is charged what will actually be sent, so
+				// count the cmds as they will be delta-coded below
+				sendsize = packsize;
+				if (nodedeltatics[n])
+				{
+					static UINT8 ticbuf[TICDELTA_MAXCMDSIZE * MAXPLAYERS];
+					const UINT8 *ticend = SV_DeltaCodeTic(ticbuf, ticbuf + sizeof (ticbuf), i, i == realfirsttic, doomcom->numslots);
+
+					deltacmdsize += ticend ? (size_t)(ticend - ticbuf) : sizeof (ticcmd_t) * doomcom->numslots;
+					if (deltacmdsize < rawcmdsize)
+						sendsize -= rawcmdsize - deltacmdsize;
+				}
+
+				// Always send at least one tic, but keep the rest for later
+				// once the node has used up its budget
+				if (i > realfirsttic && (INT32)sendsize > sched->budget)
+				{
+					lasttictosend = i;
+					break;
+				}
 
 				if (packsize > software_MAXPACKETLENGTH)
 				{
@@ -5322,7 +5936,38 @@ static void SV_SendTics(void)
 			}
 			packsize = bufpos - (UINT8 *)&(netbuffer->u);
 
+			// Swap the raw cmds for delta-coded ones if the client can take them and they're smaller
+			{
+				const size_t numtics = lasttictosend - realfirsttic;
+				const size_t rawsize = numtics * doomcom->numslots * sizeof (ticcmd_t);
+				size_t deltasize = 0;
+
+				if (nodedeltatics[n])
+				{
+					static UINT8 deltabuf[MAXPACKETLENGTH];
+					UINT8 *cmds = (UINT8 *)&netbuffer->u.serverpak.cmds;
+
+					deltasize = SV_DeltaCodeTics(deltabuf, realfirsttic, lasttictosend, doomcom->numslots, min(rawsize, sizeof (deltabuf)));
+
+					if (deltasize && deltasize < rawsize)
+					{
+						memmove(cmds + deltasize, cmds + rawsize, bufpos - (cmds + rawsize)); // textcmds
+						M_Memcpy(cmds, deltabuf, deltasize);
+						netbuffer->packettype = PT_SERVERTICSDELTA;
+						packsize -= rawsize - deltasize;
+					}
+					else
+						deltasize = rawsize;
+				}
+				else
+					deltasize = rawsize;
+
+				ticcmdrawbytes += rawsize;
+				ticcmdsentbytes += deltasize;
+			}
+
 			HSendPacket(n, false, 0, packsize);
+			sched->budget -= (INT32)packsize;
 			// when tic are too large, only one tic is sent so don't go backward!
 			if (lasttictosend-doomcom->extratics > realfirsttic)
 				supposedtics[n] = lasttictosend-doomcom->extratics;
@@ -5332,6 +5977,10 @@ static void SV_SendTics(void)
 		}
 	// node 0 is me!
 	supposedtics[0] = maketic;
+
+	// push every node's tics out in one go
+	if (I_NetFlush)
+		I_NetFlush();
 }
 
 //
@@ -5609,6 +6258,10 @@ void NetUpdate(void)
 	nowtime = I_GetTime();
 	realtics = nowtime - gametime;
 
+	// Send anything queued up since the last update
+	if (I_NetFlush)
+		I_NetFlush();
+
 	if (realtics <= 0) // nothing new to update
 		return;
 	if (realtics > 5)
@@ -5708,6 +6361,10 @@ void NetUpdate(void)
 	// Handle timeouts to prevent definitive freezes from happenning
 	if (server)
 	{
+#ifndef NONET
+		SV_PollSaveGameJobs();
+#endif
+
 		for (i = 1; i < MAXNETNODES; i++)
 			if (nodeingame[i] && freezetimeout[i] < I_GetTime())
 				Net_ConnectionTimeout(i);
@@ -5732,6 +6389,9 @@ void NetUpdate(void)
 	}
 
 	FileSendTicker();
+
+	if (I_NetFlush)
+		I_NetFlush();
 }
 
 /** Returns the number of players playing.
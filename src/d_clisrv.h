@@ -34,7 +34,7 @@ packet versions.
 If you change the struct or the meaning of a field
 therein, increment this number.
 */
-#define PACKETVERSION 4
+#define PACKETVERSION 6
 
 // Network play related stuff.
 // There is a data struct that stores network
@@ -102,6 +102,8 @@ typedef enum
 	PT_MOREFILESNEEDED, // Server, to client: "you need these (+ more on top of those)"
 
 	PT_PING,          // Packet sent to tell clients the other client's latency to server.
+
+	PT_SERVERTICSDELTA, // PT_SERVERTICS with delta-coded cmds, only for clients with CLIENTCAP_DELTATICS.
 	NUMPACKETTYPE
 } packettype_t;
 
@@ -217,8 +219,11 @@ typedef struct
 	UINT8 localplayers;
 	UINT8 mode;
 	char names[MAXSPLITSCREENPLAYERS][MAXPLAYERNAME];
+	UINT8 capabilities; // CLIENTCAP_ flags. Older clients don't send this byte at all.
 } ATTRPACK clientconfig_pak;
 
+#define CLIENTCAP_DELTATICS 0x01 // client understands PT_SERVERTICSDELTA
+
 #define SV_DEDICATED    0x40 // server is dedicated
 #define SV_LOTSOFADDONS 0x20 // flag used to ask for full file list in d_netfil
 
@@ -416,6 +421,7 @@ extern tic_t servermaxping;
 
 extern consvar_t cv_netticbuffer, cv_allownewplayer, cv_joinnextround, cv_maxplayers, cv_joindelay, cv_rejointimeout;
 extern consvar_t cv_resynchattempts, cv_blamecfail;
+extern consvar_t cv_netsavecompression;
 extern consvar_t cv_maxsend, cv_noticedownload, cv_downloadspeed;
 
 // DISCORD STUFF: INVITATION EDITION //
@@ -719,6 +719,16 @@ static void D_Display(void)
 
 			s[sizeof s - 1] = '\0';
 
+			if (server && ticcmdpercent > 0.0f)
+			{
+				snprintf(s, sizeof s - 1, "tics %.0f%% of raw", ticcmdpercent);
+				V_DrawRightAlignedString(BASEVIDWIDTH, BASEVIDHEIGHT-ST_HEIGHT-60, menuColor[cv_menucolor.value], s);
+			}
+			if (netwaitms > 0.0f)
+				snprintf(s, sizeof s - 1, "syscalls %.1f/tic  wait %.1f ms", syscallspertic, netwaitms);
+			else
+				snprintf(s, sizeof s - 1, "syscalls %.1f/tic", syscallspertic);
+			V_DrawRightAlignedString(BASEVIDWIDTH, BASEVIDHEIGHT-ST_HEIGHT-50, menuColor[cv_menucolor.value], s);
 			snprintf(s, sizeof s - 1, "get %d b/s", getbps);
 			V_DrawRightAlignedString(BASEVIDWIDTH, BASEVIDHEIGHT-ST_HEIGHT-40, menuColor[cv_menucolor.value], s);
 			snprintf(s, sizeof s - 1, "send %d b/s", sendbps);
@@ -740,6 +750,229 @@ static void D_Display(void)
 	}
 }
 
+// Per-frame TSoURDt3rd events, add-on and server checks
+static void D_StarFrameStuff(void)
+{
+	//// STAR STUFF ////
+	// Do Event Stuff //
+#ifdef APRIL_FOOLS
+	// April Fools
+	if ((!modifiedgame || savemoddata) && (cv_ultimatemode.value))
+	{
+		CONS_Printf("You have the April Fools features enabled.\nTherefore, to prevent dumb things from happening,\nyour game has been set to modified.\n");
+		G_SetGameModified(false);
+	}
+#endif
+
+	// Easter
+	if (!eastermode && (cv_alloweasteregghunt.value || cv_easteregghuntbonuses.value || EnableEasterEggHuntBonuses))
+	{
+		CV_StealthSetValue(&cv_alloweasteregghunt, 0);
+		CV_StealthSetValue(&cv_easteregghuntbonuses, 0);
+
+		EnableEasterEggHuntBonuses = 0;
+	}
+	else if (eastermode)
+	{
+		if (currenteggs != TOTALEGGS && (cv_easteregghuntbonuses.value || EnableEasterEggHuntBonuses))
+		{
+			CV_StealthSetValue(&cv_easteregghuntbonuses, 0);
+			EnableEasterEggHuntBonuses = 0;
+		}
+		else if ((!modifiedgame || savemoddata) && (!TSoURDt3rd_NoMoreExtras) && (EnableEasterEggHuntBonuses))
+		{
+			CONS_Printf("You have the Easter Egg Hunt Bonus features enabled.\nTherefore, to prevent dumb things from happening,\nyour game has been set to modified.\n");
+			G_SetGameModified(false);
+
+			M_UpdateEasterStuff();
+		}
+	}
+
+#ifdef HAVE_CURL
+	// Do Internet Stuff //
+	// Grab the Current TSoURDt3rd Version
+	if (!TSoURDt3rd->checkedVersion && cv_tsourdt3rdupdatemessage.value)
+	{
+		// STAR NOTE: If You're Planning on Using the Internet Functions, Use This Block as an Example :) //
+		// Make Some Variables
+		const char *API = "https://raw.githubusercontent.com/StarManiaKG/The-Story-of-Uncapped-Revengence-Discord-the-3rd/";
+		char URL[256];	strcpy(URL,	 va("%s/src/STAR/star_webinfo.h", compbranch));
+		char INFO[256]; strcpy(INFO, va("#define TSOURDT3RDVERSION \"%s\"", TSOURDT3RDVERSION));
+		
+		// Check the Version, And If They Don't Match the Branch's Version, Run the Block Below
+		CONS_Printf("STAR_FindStringOnWebsite() & STAR_ReturnStringFromWebsite(): Grabbing latest TSoURDt3rd version...\n");
+		
+		if (STAR_FindStringOnWebsite(API, URL, INFO, false) == 1)
+		{
+			char RETURNINFO[256] = "#define TSOURDT3RDVERSION";
+			char RETURNEDSTRING[256] = ""; strcpy(RETURNEDSTRING, STAR_ReturnStringFromWebsite(API, URL, RETURNINFO, false));
+
+			UINT32 internalVersionNumber = STAR_ConvertStringToCompressedNumber(RETURNEDSTRING, 0, 26, true);
+
+			UINT32 displayVersionNumber = STAR_ConvertStringToCompressedNumber(RETURNEDSTRING, 0, 26, false);
+			const char *displayVersionString = STAR_ConvertNumberToString(displayVersionNumber, 0, 0, true);
+
+			if (TSoURDt3rd_CurrentVersion() < internalVersionNumber)
+				(cv_tsourdt3rdupdatemessage.value == 1 ?
+					(M_StartMessage(va("%c%s\x80\nYou're using an outdated version of TSoURDt3rd.\n\nThe newest version is: %s\nYou're using version: %s\n\nCheck the SRB2 Message Board for the latest version!\n\n(Press any key to continue)\n", ('\x80' + (menuColor[cv_menucolor.value]|V_CHARCOLORSHIFT)), "Update TSoURDt3rd, Please", displayVersionString, TSOURDT3RDVERSION),NULL,MM_NOTHING)) :
+					(CONS_Alert(CONS_WARNING, "You're using an outdated version of TSoURDt3rd.\n\nThe newest version is: %s\nYou're using version: %s\n\nCheck the SRB2 Message Board for the latest version!\n", displayVersionString, TSOURDT3RDVERSION)));
+			else if (TSoURDt3rd_CurrentVersion() > internalVersionNumber)
+				(cv_tsourdt3rdupdatemessage.value == 1 ?
+					(M_StartMessage(va("%c%s\x80\nYou're using a version of TSoURDt3rd that hasn't even released yet.\n\nYou're probably a tester or coder,\nand in that case, hello!\n\nEnjoy messing around with the build!\n\n(Press any key to continue)\n", ('\x80' + (menuColor[cv_menucolor.value]|V_CHARCOLORSHIFT)), "Hello, Tester/Coder!"),NULL,MM_NOTHING)) :
+					(CONS_Alert(CONS_NOTICE, "You're using a version of TSoURDt3rd that hasn't even released yet.\nYou're probably a tester or coder, and in that case, hello!\nEnjoy messing around with the build!\n")));
+		}
+		TSoURDt3rd->checkedVersion = true;
+	}
+#endif
+
+	// Do Extra Stuff //
+	// Lock-on the Extra PK3
+	if (TSoURDt3rd_LoadExtras)
+	{
+		if (aprilfoolsmode || eastermode || xmasmode)
+			M_StartMessage(va("%c%s\x80\nTSoURDt3rd is having a seasonal event!\n\nWould you like to load tsourdt3rdextras.pk3 to engage in it? \n\n(Press 'Y' or 'Enter' for 'Yes'; 'N' or any other key for 'No')\n", ('\x80' + (menuColor[cv_menucolor.value]|V_CHARCOLORSHIFT)), "A TSoURDt3rd Event is Occuring"),TSoURDt3rd_EventMessage,MM_YESNO);
+		else
+			COM_BufAddText("addfile tsourdt3rdextras.pk3\n");
+	}
+
+	// Check What Extra Add-ons we Have Currently Loaded
+	if (!TSoURDt3rd_checkedExtraWads)
+	{
+		INT32 i = numwadfiles;
+		char *tempname;
+
+		extrawads = 0;
+		for (i--; i >= 1; i--)
+		{
+			nameonly(tempname = va("%s", wadfiles[i]->filename));
+			if ((strcmp(tempname, "music.dta") == 0)
+				|| (strcmp(tempname, "jukebox.pk3") == 0)
+				|| (strcmp(tempname, "patch_music.pk3") == 0)
+				|| (strcmp(tempname, "tsourdt3rdextras.pk3") == 0))
+			{
+				if (strcmp(tempname, "tsourdt3rdextras.pk3") == 0)
+				{
+					if (!TSoURDt3rd_LoadedExtras)
+					{
+						TSoURDt3rd_LoadedExtras = true;
+						TSoURDt3rd_TouchyModifiedGame = true;
+					}
+					M_UpdateEasterStuff();
+				}
+				
+				extrawads++;
+				continue;
+			}
+		}
+		TSoURDt3rd_checkedExtraWads = true;
+	}
+
+	// Do Server Stuff //
+	// Find Current Server Infractions
+	if ((Playing() && netgame) || dedicated)
+		STAR_FindServerInfractions();
+	
+	//// THAT'S THE END :P ////
+}
+
+// Dedicated server tick stats, printed and reset by the tickstats command
+static precise_t dedicatedbusytime, dedicatedmaxbusytime;
+static UINT32 dedicatedtics;
+static precise_t dedicatedstatstart;
+static clock_t dedicatedcpustart;
+
+void Command_Tickstats_f(void)
+{
+	const precise_t now = I_GetPreciseTime();
+	const clock_t cpu = clock();
+	const UINT64 precision = I_GetPrecisePrecision();
+	const double wallsecs = (double)(now - dedicatedstatstart) / precision;
+	const size_t rss = I_GetResidentMem();
+
+	if (!dedicated)
+	{
+		CONS_Printf(M_GetText("Tick stats are only collected by dedicated servers.\n"));
+		return;
+	}
+
+	CONS_Printf(M_GetText("%u tics in %.1f s\n"), dedicatedtics, wallsecs);
+	if (dedicatedtics)
+		CONS_Printf(M_GetText("Tic time: avg %.3f ms, max %.3f ms\n"),
+			(double)dedicatedbusytime * 1000.0 / precision / dedicatedtics,
+			(double)dedicatedmaxbusytime * 1000.0 / precision);
+	if (wallsecs > 0.0 && cpu != (clock_t)-1)
+		CONS_Printf(M_GetText("CPU: %.1f%%\n"),
+			100.0 * (double)(cpu - dedicatedcpustart) / CLOCKS_PER_SEC / wallsecs);
+	if (rss)
+		CONS_Printf(M_GetText("Resident memory: %s KB\n"), sizeu1(rss >> 10));
+
+	dedicatedbusytime = dedicatedmaxbusytime = 0;
+	dedicatedtics = 0;
+	dedicatedstatstart = now;
+	dedicatedcpustart = cpu;
+}
+
+static void D_DedicatedLoop(void) FUNCNORETURN;
+
+/** Main loop of a dedicated server
+  *
+  * Only runs game tics and the network: nothing is drawn, no sound is
+  * played and there is no view to interpolate. Between tics, it sleeps
+  * until the next one is due rather than until a frame cap.
+  */
+static void D_DedicatedLoop(void)
+{
+	tic_t entertic, oldentertics, realtics;
+
+	I_UpdateTime(cv_timescale.value);
+	oldentertics = I_GetTime();
+	dedicatedstatstart = I_GetPreciseTime();
+	dedicatedcpustart = clock();
+
+	for (;;)
+	{
+		I_UpdateTime(cv_timescale.value);
+
+		if (lastwipetic)
+		{
+			oldentertics = lastwipetic;
+			lastwipetic = 0;
+		}
+
+		// get real tics
+		entertic = I_GetTime();
+		realtics = entertic - oldentertics;
+		oldentertics = entertic;
+
+		refreshdirmenu = 0; // not sure where to put this, here as good as any?
+
+		if (realtics > 0 || singletics)
+		{
+			const precise_t tickstart = I_GetPreciseTime();
+			precise_t busy;
+
+			// don't skip more than 10 frames at a time
+			if (realtics > 8)
+				realtics = 1;
+
+			// process tics (but maybe not if realtic == 0)
+			TryRunTics(realtics);
+
+			busy = I_GetPreciseTime() - tickstart;
+			dedicatedbusytime += busy;
+			dedicatedmaxbusytime = max(dedicatedmaxbusytime, busy);
+			dedicatedtics++;
+		}
+
+		LUA_Step();
+
+		D_StarFrameStuff();
+
+		if (!singletics)
+			I_SleepDuration(I_GetTimeToNextTic());
+	}
+}
+
 // =========================================================================
 // D_SRB2Loop
 // =========================================================================
@@ -791,6 +1024,10 @@ void D_SRB2Loop(void)
 	// hack to start on a nice clear console screen.
 	COM_ImmedExecute("cls;version");
 
+	// Nothing below is needed without a screen
+	if (dedicated)
+		D_DedicatedLoop();
+
 	I_FinishUpdate(); // page flip or blit buffer
 	/*
 	LMFAO this was showing garbage under OpenGL
@@ -957,126 +1194,7 @@ void D_SRB2Loop(void)
 		// END THIS PLEASE //
 #endif
 
-		//// STAR STUFF ////
-		// Do Event Stuff //
-#ifdef APRIL_FOOLS
-		// April Fools
-		if ((!modifiedgame || savemoddata) && (cv_ultimatemode.value))
-		{
-			CONS_Printf("You have the April Fools features enabled.\nTherefore, to prevent dumb things from happening,\nyour game has been set to modified.\n");
-			G_SetGameModified(false);
-		}
-#endif
-
-		// Easter
-		if (!eastermode && (cv_alloweasteregghunt.value || cv_easteregghuntbonuses.value || EnableEasterEggHuntBonuses))
-		{
-			CV_StealthSetValue(&cv_alloweasteregghunt, 0);
-			CV_StealthSetValue(&cv_easteregghuntbonuses, 0);
-
-			EnableEasterEggHuntBonuses = 0;
-		}
-		else if (eastermode)
-		{
-			if (currenteggs != TOTALEGGS && (cv_easteregghuntbonuses.value || EnableEasterEggHuntBonuses))
-			{
-				CV_StealthSetValue(&cv_easteregghuntbonuses, 0);
-				EnableEasterEggHuntBonuses = 0;
-			}
-			else if ((!modifiedgame || savemoddata) && (!TSoURDt3rd_NoMoreExtras) && (EnableEasterEggHuntBonuses))
-			{
-				CONS_Printf("You have the Easter Egg Hunt Bonus features enabled.\nTherefore, to prevent dumb things from happening,\nyour game has been set to modified.\n");
-				G_SetGameModified(false);
-
-				M_UpdateEasterStuff();
-			}
-		}
-
-#ifdef HAVE_CURL
-		// Do Internet Stuff //
-		// Grab the Current TSoURDt3rd Version
-		if (!TSoURDt3rd->checkedVersion && cv_tsourdt3rdupdatemessage.value)
-		{
-			// STAR NOTE: If You're Planning on Using the Internet Functions, Use This Block as an Example :) //
-			// Make Some Variables
-			const char *API = "https://raw.githubusercontent.com/StarManiaKG/The-Story-of-Uncapped-Revengence-Discord-the-3rd/";
-			char URL[256];	strcpy(URL,	 va("%s/src/STAR/star_webinfo.h", compbranch));
-			char INFO[256]; strcpy(INFO, va("#define TSOURDT3RDVERSION \"%s\"", TSOURDT3RDVERSION));
-			
-			// Check the Version, And If They Don't Match the Branch's Version, Run the Block Below
-			CONS_Printf("STAR_FindStringOnWebsite() & STAR_ReturnStringFromWebsite(): Grabbing latest TSoURDt3rd version...\n");
-			
-			if (STAR_FindStringOnWebsite(API, URL, INFO, false) == 1)
-			{
-				char RETURNINFO[256] = "#define TSOURDT3RDVERSION";
-				char RETURNEDSTRING[256] = ""; strcpy(RETURNEDSTRING, STAR_ReturnStringFromWebsite(API, URL, RETURNINFO, false));
-
-				UINT32 internalVersionNumber = STAR_ConvertStringToCompressedNumber(RETURNEDSTRING, 0, 26, true);
-
-				UINT32 displayVersionNumber = STAR_ConvertStringToCompressedNumber(RETURNEDSTRING, 0, 26, false);
-				const char *displayVersionString = STAR_ConvertNumberToString(displayVersionNumber, 0, 0, true);
-
-				if (TSoURDt3rd_CurrentVersion() < internalVersionNumber)
-					(cv_tsourdt3rdupdatemessage.value == 1 ?
-						(M_StartMessage(va("%c%s\x80\nYou're using an outdated version of TSoURDt3rd.\n\nThe newest version is: %s\nYou're using version: %s\n\nCheck the SRB2 Message Board for the latest version!\n\n(Press any key to continue)\n", ('\x80' + (menuColor[cv_menucolor.value]|V_CHARCOLORSHIFT)), "Update TSoURDt3rd, Please", displayVersionString, TSOURDT3RDVERSION),NULL,MM_NOTHING)) :
-						(CONS_Alert(CONS_WARNING, "You're using an outdated version of TSoURDt3rd.\n\nThe newest version is: %s\nYou're using version: %s\n\nCheck the SRB2 Message Board for the latest version!\n", displayVersionString, TSOURDT3RDVERSION)));
-				else if (TSoURDt3rd_CurrentVersion() > internalVersionNumber)
-					(cv_tsourdt3rdupdatemessage.value == 1 ?
-						(M_StartMessage(va("%c%s\x80\nYou're using a version of TSoURDt3rd that hasn't even released yet.\n\nYou're probably a tester or coder,\nand in that case, hello!\n\nEnjoy messing around with the build!\n\n(Press any key to continue)\n", ('\x80' + (menuColor[cv_menucolor.value]|V_CHARCOLORSHIFT)), "Hello, Tester/Coder!"),NULL,MM_NOTHING)) :
-						(CONS_Alert(CONS_NOTICE, "You're using a version of TSoURDt3rd that hasn't even released yet.\nYou're probably a tester or coder, and in that case, hello!\nEnjoy messing around with the build!\n")));
-			}
-			TSoURDt3rd->checkedVersion = true;
-		}
-#endif
-
-		// Do Extra Stuff //
-		// Lock-on the Extra PK3
-		if (TSoURDt3rd_LoadExtras)
-		{
-			if (aprilfoolsmode || eastermode || xmasmode)
-				M_StartMessage(va("%c%s\x80\nTSoURDt3rd is having a seasonal event!\n\nWould you like to load tsourdt3rdextras.pk3 to engage in it? \n\n(Press 'Y' or 'Enter' for 'Yes'; 'N' or any other key for 'No')\n", ('\x80' + (menuColor[cv_menucolor.value]|V_CHARCOLORSHIFT)), "A TSoURDt3rd Event is Occuring"),TSoURDt3rd_EventMessage,MM_YESNO);
-			else
-				COM_BufAddText("addfile tsourdt3rdextras.pk3\n");
-		}
-
-		// Check What Extra Add-ons we Have Currently Loaded
-		if (!TSoURDt3rd_checkedExtraWads)
-		{
-			INT32 i = numwadfiles;
-			char *tempname;
-
-			extrawads = 0;
-			for (i--; i >= 1; i--)
-			{
-				nameonly(tempname = va("%s", wadfiles[i]->filename));
-				if ((strcmp(tempname, "music.dta") == 0)
-					|| (strcmp(tempname, "jukebox.pk3") == 0)
-					|| (strcmp(tempname, "patch_music.pk3") == 0)
-					|| (strcmp(tempname, "tsourdt3rdextras.pk3") == 0))
-				{
-					if (strcmp(tempname, "tsourdt3rdextras.pk3") == 0)
-					{
-						if (!TSoURDt3rd_LoadedExtras)
-						{
-							TSoURDt3rd_LoadedExtras = true;
-							TSoURDt3rd_TouchyModifiedGame = true;
-						}
-						M_UpdateEasterStuff();
-					}
-					
-					extrawads++;
-					continue;
-				}
-			}
-			TSoURDt3rd_checkedExtraWads = true;
-		}
-
-		// Do Server Stuff //
-		// Find Current Server Infractions
-		if ((Playing() && netgame) || dedicated)
-			STAR_FindServerInfractions();
-		
-		//// THAT'S THE END :P ////
+		D_StarFrameStuff();
 
 		// Fully completed frame made.
 		finishprecise = I_GetPreciseTime();
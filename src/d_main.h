@@ -30,6 +30,9 @@ extern char srb2path[256]; //Alam: SRB2's Home
 // the infinite loop of D_SRB2Loop() called from win_main for windows version
 void D_SRB2Loop(void) FUNCNORETURN;
 
+// Prints and resets the dedicated server's tic time, CPU and memory stats
+void Command_Tickstats_f(void);
+
 //
 // D_SRB2Main()
 // Not a globally visible function, just included for source reference,
@@ -14,7 +14,8 @@
 ///        Implement a Sliding window protocol without receiver window
 ///        (out of order reception)
 ///        This protocol uses a mix of "goback n" and "selective repeat" implementation
-///        The NOTHING packet is sent when connection is idle to acknowledge packets
+///        The NOTHING packet is sent when connection is idle to acknowledge packets,
+///        it carries the out of order packets received as ranges (selective ack)
 
 #include "doomdef.h"
 #include "g_game.h"
@@ -74,6 +75,7 @@ boolean (*I_NetGet)(void) = NULL;
 void (*I_NetSend)(void) = NULL;
 boolean (*I_NetCanSend)(void) = NULL;
 boolean (*I_NetCanGet)(void) = NULL;
+void (*I_NetFlush)(void) = NULL;
 void (*I_NetCloseSocket)(void) = NULL;
 void (*I_NetFreeNodenum)(INT32 nodenum) = NULL;
 SINT8 (*I_NetMakeNodewPort)(const char *address, const char* port) = NULL;
@@ -95,6 +97,11 @@ boolean *bannednode = NULL;
 static tic_t statstarttic;
 INT32 getbytes = 0;
 INT64 sendbytes = 0;
+INT32 netsyscalls = 0;
+precise_t netpacketarrival = 0;
+static precise_t netwaittime = 0;
+static INT32 netwaitpackets = 0;
+INT64 ticcmdrawbytes = 0, ticcmdsentbytes = 0;
 static INT32 retransmit = 0, duppacket = 0;
 static INT32 sendackpacket = 0, getackpacket = 0;
 INT32 ticruned = 0, ticmiss = 0;
@@ -102,6 +109,9 @@ INT32 ticruned = 0, ticmiss = 0;
 // globals
 INT32 getbps, sendbps;
 float lostpercent, duppercent, gamelostpercent;
+float syscallspertic;
+float netwaitms;
+float ticcmdpercent;
 INT32 packetheaderlength;
 
 boolean Net_GetNetStat(void)
@@ -126,10 +136,23 @@ boolean Net_GetNetStat(void)
 			gamelostpercent = 100.0f*(float)ticmiss/(float)ticruned;
 		else
 			gamelostpercent = 0.0f;
+		syscallspertic = (float)netsyscalls/(float)df;
+		if (netwaitpackets)
+			netwaitms = (float)((double)netwaittime * 1000.0 / I_GetPrecisePrecision() / netwaitpackets);
+		else
+			netwaitms = 0.0f;
+		if (ticcmdrawbytes)
+			ticcmdpercent = 100.0f*(float)ticcmdsentbytes/(float)ticcmdrawbytes;
+		else
+			ticcmdpercent = 0.0f;
 
 		ticmiss = ticruned = 0;
 		oldsendbyte = sendbytes;
 		getbytes = 0;
+		netsyscalls = 0;
+		netwaittime = 0;
+		netwaitpackets = 0;
+		ticcmdrawbytes = ticcmdsentbytes = 0;
 		sendackpacket = getackpacket = duppacket = retransmit = 0;
 		statstarttic = t;
 
@@ -141,10 +164,12 @@ boolean Net_GetNetStat(void)
 // -----------------------------------------------------------------
 // Some structs and functions for acknowledgement of packets
 // -----------------------------------------------------------------
-#define MAXACKPACKETS 96 // Minimum number of nodes (wat)
-#define MAXACKTOSEND 96
+#define MAXACKPACKETS 1024 // Shared by all nodes, each one is limited by MAXACKTOSEND
+#define MAXACKTOSEND 120 // Send window of a node, must stay below half of the acknum space
+#define MAXSACKRANGES (MAXACKTOSEND/2) // Worst case: every other packet was lost
 #define URGENTFREESLOTNUM 10
 #define ACKTOSENDTIMEOUT (TICRATE/11)
+#define NOACKSLOT -1
 
 #ifndef NONET
 typedef struct
@@ -170,7 +195,10 @@ typedef enum
 
 #ifndef NONET
 // Table of packets that were not acknowleged can be resent (the sender window)
+// Slots are handed out to any node from a stack of free ones
 static ackpak_t ackpak[MAXACKPACKETS];
+static INT16 freeackpak[MAXACKPACKETS];
+static INT32 numfreeackpak;
 #endif
 
 typedef struct
@@ -179,10 +207,9 @@ typedef struct
 	UINT8 firstacktosend;
 
 	// when no consecutive packets are received we keep in mind what packets
-	// we already received in a queue
-	UINT8 acktosend_head;
-	UINT8 acktosend_tail;
-	UINT8 acktosend[MAXACKTOSEND];
+	// we already received after firstacktosend, one bit per acknum
+	UINT8 acktosend[256/8];
+	UINT8 numacktosend;
 
 	// automatically send keep alive packet when not enough trafic
 	tic_t lasttimeacktosend_sent;
@@ -193,6 +220,10 @@ typedef struct
 	UINT8 remotefirstack;
 	UINT8 nextacknum;
 
+	// ackpak slot of every acknum still waiting for its ack return
+	INT16 ackslot[256];
+	INT16 numacks;
+
 	UINT8 flags;
 } node_t;
 
@@ -213,6 +244,47 @@ FUNCMATH static INT32 cmpack(UINT8 a, UINT8 b)
 	return d;
 }
 
+// Acknum 0 means "no ack", so it is skipped when counting
+FUNCMATH static UINT8 NextAck(UINT8 ack)
+{
+	ack++;
+	return ack ? ack : 1;
+}
+
+FUNCMATH static UINT8 PrevAck(UINT8 ack)
+{
+	ack--;
+	return ack ? ack : UINT8_MAX;
+}
+
+// Number of NextAck steps from a forward to b, 0 to 254.
+// An ack of 0 counts as the one just before 1, like a fresh firstacktosend.
+FUNCMATH static INT32 AckDistance(UINT8 a, UINT8 b)
+{
+	const INT32 ia = a ? a - 1 : UINT8_MAX - 1;
+	const INT32 ib = b ? b - 1 : UINT8_MAX - 1;
+	return (ib - ia + UINT8_MAX) % UINT8_MAX;
+}
+
+static boolean AckReceived(const node_t *node, UINT8 ack)
+{
+	return (node->acktosend[ack >> 3] & (1 << (ack & 7))) != 0;
+}
+
+static void SetAckReceived(node_t *node, UINT8 ack, boolean received)
+{
+	if (received)
+	{
+		node->acktosend[ack >> 3] |= (UINT8)(1 << (ack & 7));
+		node->numacktosend++;
+	}
+	else
+	{
+		node->acktosend[ack >> 3] &= (UINT8)~(1 << (ack & 7));
+		node->numacktosend--;
+	}
+}
+
 /** Sets freeack to a free acknum and copies the netbuffer in the ackpak table
   *
   * \param freeack  The address to store the free acknum at
@@ -222,7 +294,8 @@ FUNCMATH static INT32 cmpack(UINT8 a, UINT8 b)
 static boolean GetFreeAcknum(UINT8 *freeack, boolean lowtimer)
 {
 	node_t *node = &nodes[doomcom->remotenode];
-	INT32 i, numfreeslot = 0;
+	ackpak_t *pak;
+	INT32 i;
 
 	if (cmpack((UINT8)((node->remotefirstack + MAXACKTOSEND) % 256), node->nextacknum) < 0)
 	{
@@ -230,49 +303,45 @@ static boolean GetFreeAcknum(UINT8 *freeack, boolean lowtimer)
 		return false;
 	}
 
-	for (i = 0; i < MAXACKPACKETS; i++)
-		if (!ackpak[i].acknum)
-		{
-			// For low priority packets, make sure to let freeslots so urgent packets can be sent
-			if (netbuffer->packettype >= PT_CANFAIL)
-			{
-				numfreeslot++;
-				if (numfreeslot <= URGENTFREESLOTNUM)
-					continue;
-			}
+	// For low priority packets, make sure to let freeslots so urgent packets can be sent
+	if (numfreeackpak <= (netbuffer->packettype >= PT_CANFAIL ? URGENTFREESLOTNUM : 0))
+	{
+#ifdef PARANOIA
+		CONS_Debug(DBG_NETPLAY, "No more free ackpacket\n");
+#endif
+		if (netbuffer->packettype < PT_CANFAIL)
+			I_Error("Connection lost\n");
+		return false;
+	}
 
-			ackpak[i].acknum = node->nextacknum;
-			ackpak[i].nextacknum = node->nextacknum;
-			node->nextacknum++;
-			if (!node->nextacknum)
-				node->nextacknum++;
-			ackpak[i].destinationnode = (UINT8)(node - nodes);
-			ackpak[i].length = doomcom->datalength;
-			if (lowtimer)
-			{
-				// Lowtime means can't be sent now so try it as soon as possible
-				ackpak[i].senttime = 0;
-				ackpak[i].resentnum = 1;
-			}
-			else
-			{
-				ackpak[i].senttime = I_GetTime();
-				ackpak[i].resentnum = 0;
-			}
-			M_Memcpy(ackpak[i].pak.raw, netbuffer, ackpak[i].length);
+	i = freeackpak[--numfreeackpak];
+	pak = &ackpak[i];
+
+	pak->acknum = node->nextacknum;
+	pak->nextacknum = node->nextacknum;
+	node->ackslot[pak->acknum] = (INT16)i;
+	node->numacks++;
+	node->nextacknum = NextAck(node->nextacknum);
+	pak->destinationnode = (UINT8)(node - nodes);
+	pak->length = doomcom->datalength;
+	if (lowtimer)
+	{
+		// Lowtime means can't be sent now so try it as soon as possible
+		pak->senttime = 0;
+		pak->resentnum = 1;
+	}
+	else
+	{
+		pak->senttime = I_GetTime();
+		pak->resentnum = 0;
+	}
+	M_Memcpy(pak->pak.raw, netbuffer, pak->length);
 
-			*freeack = ackpak[i].acknum;
+	*freeack = pak->acknum;
 
-			sendackpacket++; // For stat
+	sendackpacket++; // For stat
 
-			return true;
-		}
-#ifdef PARANOIA
-	CONS_Debug(DBG_NETPLAY, "No more free ackpacket\n");
-#endif
-	if (netbuffer->packettype < PT_CANFAIL)
-		I_Error("Connection lost\n");
-	return false;
+	return true;
 }
 
 /** Counts how many acks are free
@@ -287,24 +356,10 @@ static boolean GetFreeAcknum(UINT8 *freeack, boolean lowtimer)
   */
 INT32 Net_GetFreeAcks(boolean urgent)
 {
-	INT32 i, numfreeslot = 0;
-	INT32 n = 0; // Number of free acks found
-
-	for (i = 0; i < MAXACKPACKETS; i++)
-		if (!ackpak[i].acknum)
-		{
-			// For low priority packets, make sure to let freeslots so urgent packets can be sent
-			if (!urgent)
-			{
-				numfreeslot++;
-				if (numfreeslot <= URGENTFREESLOTNUM)
-					continue;
-			}
-
-			n++;
-		}
-
-	return n;
+	// For low priority packets, make sure to let freeslots so urgent packets can be sent
+	if (urgent)
+		return numfreeackpak;
+	return max(numfreeackpak - URGENTFREESLOTNUM, 0);
 }
 
 // Get a ack to send in the queue of this node
@@ -314,11 +369,22 @@ static UINT8 GetAcktosend(INT32 node)
 	return nodes[node].firstacktosend;
 }
 
+// Gives the slot back without touching the connection
+static void FreeAckpak(INT32 i)
+{
+	node_t *node = &nodes[ackpak[i].destinationnode];
+
+	node->ackslot[ackpak[i].acknum] = NOACKSLOT;
+	node->numacks--;
+	ackpak[i].acknum = 0;
+	freeackpak[numfreeackpak++] = (INT16)i;
+}
+
 static void RemoveAck(INT32 i)
 {
 	INT32 node = ackpak[i].destinationnode;
 	DEBFILE(va("Remove ack %d\n",ackpak[i].acknum));
-	ackpak[i].acknum = 0;
+	FreeAckpak(i);
 	if (nodes[node].flags & NF_CLOSE)
 		Net_CloseConnection(node);
 }
@@ -326,21 +392,21 @@ static void RemoveAck(INT32 i)
 // We have got a packet, proceed the ack request and ack return
 static boolean Processackpak(void)
 {
-	INT32 i;
 	boolean goodpacket = true;
 	node_t *node = &nodes[doomcom->remotenode];
 
-	// Received an ack return, so remove the ack in the list
+	// Received an ack return, so remove the acks up to it from the list
 	if (netbuffer->ackreturn && cmpack(node->remotefirstack, netbuffer->ackreturn) < 0)
 	{
+		UINT8 ack = node->remotefirstack;
+
 		node->remotefirstack = netbuffer->ackreturn;
-		// Search the ackbuffer and free it
-		for (i = 0; i < MAXACKPACKETS; i++)
-			if (ackpak[i].acknum && ackpak[i].destinationnode == node - nodes
-				&& cmpack(ackpak[i].acknum, netbuffer->ackreturn) <= 0)
-			{
-				RemoveAck(i);
-			}
+		do
+		{
+			ack = NextAck(ack);
+			if (node->ackslot[ack] != NOACKSLOT)
+				RemoveAck(node->ackslot[ack]);
+		} while (ack != netbuffer->ackreturn);
 	}
 
 	// Received a packet with ack, queue it to send the ack back
@@ -348,128 +414,129 @@ static boolean Processackpak(void)
 	{
 		UINT8 ack = netbuffer->ack;
 		getackpacket++;
-		if (cmpack(ack, node->firstacktosend) <= 0)
+		if (cmpack(ack, node->firstacktosend) <= 0 || AckReceived(node, ack))
 		{
-			DEBFILE(va("Discard(1) ack %d (duplicated)\n", ack));
+			DEBFILE(va("Discard ack %d (duplicated)\n", ack));
 			duppacket++;
 			goodpacket = false; // Discard packet (duplicate)
 		}
-		else
+		else if (ack == NextAck(node->firstacktosend))
 		{
-			// Check if it is not already in the queue
-			for (i = node->acktosend_tail; i != node->acktosend_head; i = (i+1) % MAXACKTOSEND)
-				if (node->acktosend[i] == ack)
-				{
-					DEBFILE(va("Discard(2) ack %d (duplicated)\n", ack));
-					duppacket++;
-					goodpacket = false; // Discard packet (duplicate)
-					break;
-				}
-			if (goodpacket)
+			// Is a good packet so increment the acknowledge number,
+			// then take in the out of order packets that were waiting for it
+			node->firstacktosend = ack;
+			for (ack = NextAck(ack); node->numacktosend && AckReceived(node, ack); ack = NextAck(ack))
 			{
-				// Is a good packet so increment the acknowledge number,
-				// Then search for a "hole" in the queue
-				UINT8 nextfirstack = (UINT8)(node->firstacktosend + 1);
-				if (!nextfirstack)
-					nextfirstack = 1;
-
-				if (ack == nextfirstack)
-				{
-					UINT8 hm1; // head - 1
-					boolean change = true;
-
-					node->firstacktosend = nextfirstack++;
-					if (!nextfirstack)
-						nextfirstack = 1;
-					hm1 = (UINT8)((node->acktosend_head-1+MAXACKTOSEND) % MAXACKTOSEND);
-					while (change)
-					{
-						change = false;
-						for (i = node->acktosend_tail; i != node->acktosend_head;
-							i = (i+1) % MAXACKTOSEND)
-						{
-							if (cmpack(node->acktosend[i], nextfirstack) <= 0)
-							{
-								if (node->acktosend[i] == nextfirstack)
-								{
-									node->firstacktosend = nextfirstack++;
-									if (!nextfirstack)
-										nextfirstack = 1;
-									change = true;
-								}
-								if (i == node->acktosend_tail)
-								{
-									node->acktosend[node->acktosend_tail] = 0;
-									node->acktosend_tail = (UINT8)((i+1) % MAXACKTOSEND);
-								}
-								else if (i == hm1)
-								{
-									node->acktosend[hm1] = 0;
-									node->acktosend_head = hm1;
-									hm1 = (UINT8)((hm1-1+MAXACKTOSEND) % MAXACKTOSEND);
-								}
-							}
-						}
-					}
-				}
-				else // Out of order packet
-				{
-					// Don't increment firsacktosend, put it in asktosend queue
-					// Will be incremented when the nextfirstack comes (code above)
-					UINT8 newhead = (UINT8)((node->acktosend_head+1) % MAXACKTOSEND);
-					DEBFILE(va("out of order packet (%d expected)\n", nextfirstack));
-					if (newhead != node->acktosend_tail)
-					{
-						node->acktosend[node->acktosend_head] = ack;
-						node->acktosend_head = newhead;
-					}
-					else // Buffer full discard packet, sender will resend it
-					{ // We can admit the packet but we will not detect the duplication after :(
-						DEBFILE("no more freeackret\n");
-						goodpacket = false;
-					}
-				}
+				SetAckReceived(node, ack, false);
+				node->firstacktosend = ack;
 			}
 		}
+		else if (AckDistance(node->firstacktosend, ack) <= MAXACKTOSEND + 1) // Out of order packet
+		{
+			// Don't increment firsacktosend, remember it in the acktosend bitmap
+			// Will be taken in when the missing packets come (code above)
+			DEBFILE(va("out of order packet (%d expected)\n", NextAck(node->firstacktosend)));
+			SetAckReceived(node, ack, true);
+		}
+		else // Beyond the send window, discard packet, sender will resend it
+		{
+			DEBFILE("no more freeackret\n");
+			goodpacket = false;
+		}
 	}
 	return goodpacket;
 }
 #endif
 
 // send special packet with only ack on it
+// The out of order packets received after firstacktosend are listed as
+// ranges of consecutive acknums: count, then (first, last) pairs
 void Net_SendAcks(INT32 node)
 {
 #ifdef NONET
 	(void)node;
 #else
+	const node_t *n = &nodes[node];
+	UINT8 *range = NULL;
+	UINT8 numranges = 0;
+	UINT8 ack = n->firstacktosend;
+	INT32 left = n->numacktosend;
+	INT32 i;
+
+	for (i = 0; left && i <= MAXACKTOSEND; i++)
+	{
+		ack = NextAck(ack);
+		if (!AckReceived(n, ack))
+		{
+			range = NULL;
+			continue;
+		}
+
+		left--;
+		if (range)
+			range[1] = ack;
+		else if (numranges < MAXSACKRANGES)
+		{
+			range = &netbuffer->u.textcmd[1 + numranges*2];
+			range[0] = range[1] = ack;
+			numranges++;
+		}
+		else
+			break;
+	}
+
 	netbuffer->packettype = PT_NOTHING;
-	M_Memcpy(netbuffer->u.textcmd, nodes[node].acktosend, MAXACKTOSEND);
-	HSendPacket(node, false, 0, MAXACKTOSEND);
+	netbuffer->u.textcmd[0] = numranges;
+	HSendPacket(node, false, 0, 1 + numranges*2);
 #endif
 }
 
 #ifndef NONET
 static void GotAcks(void)
 {
-	INT32 i, j;
-
-	for (j = 0; j < MAXACKTOSEND; j++)
-		if (netbuffer->u.textcmd[j])
-			for (i = 0; i < MAXACKPACKETS; i++)
-				if (ackpak[i].acknum && ackpak[i].destinationnode == doomcom->remotenode)
-				{
-					if (ackpak[i].acknum == netbuffer->u.textcmd[j])
-						RemoveAck(i);
-					// nextacknum is first equal to acknum, then when receiving bigger ack
-					// there is big chance the packet is lost
-					// When resent, nextacknum = nodes[node].nextacknum
-					// will redo the same but with different value
-					else if (cmpack(ackpak[i].nextacknum, netbuffer->u.textcmd[j]) <= 0
-							&& ackpak[i].senttime > 0)
-						{
-							ackpak[i].senttime--; // hurry up
-						}
-				}
+	node_t *node = &nodes[doomcom->remotenode];
+	const UINT8 *range = netbuffer->u.textcmd + 1;
+	const UINT8 numranges = netbuffer->u.textcmd[0];
+	UINT8 highest = 0;
+	UINT8 ack;
+	INT32 i;
+
+	if (numranges > MAXSACKRANGES || doomcom->datalength < (INT32)(BASEPACKETSIZE + 1 + numranges*2))
+		return;
+
+	for (i = 0; i < numranges; i++, range += 2)
+	{
+		if (!range[0] || !range[1] || AckDistance(range[0], range[1]) > MAXACKTOSEND)
+			continue;
+
+		for (ack = range[0];; ack = NextAck(ack))
+		{
+			if (node->ackslot[ack] != NOACKSLOT)
+				RemoveAck(node->ackslot[ack]);
+			if (ack == range[1])
+				break;
+		}
+
+		if (!highest || cmpack(range[1], highest) > 0)
+			highest = range[1];
+	}
+
+	if (!highest)
+		return;
+
+	// nextacknum is first equal to acknum, then when receiving bigger ack
+	// there is big chance the packet is lost
+	// When resent, nextacknum = nodes[node].nextacknum
+	// will redo the same but with different value
+	for (ack = NextAck(node->remotefirstack); ack != node->nextacknum && node->numacks; ack = NextAck(ack))
+	{
+		const INT32 slot = node->ackslot[ack];
+		if (slot != NOACKSLOT && cmpack(ackpak[slot].nextacknum, highest) <= 0
+			&& ackpak[slot].senttime > 0)
+		{
+			ackpak[slot].senttime--; // hurry up
+		}
+	}
 }
 #endif
 
@@ -499,31 +566,36 @@ void Net_AckTicker(void)
 {
 #ifndef NONET
 	INT32 i;
+	UINT8 ack;
 
-	for (i = 0; i < MAXACKPACKETS; i++)
+	// Walk each node's window in acknum order, the slots are found by acknum
+	for (i = 0; i < MAXNETNODES; i++)
 	{
-		const INT32 nodei = ackpak[i].destinationnode;
-		node_t *node = &nodes[nodei];
-		if (ackpak[i].acknum && ackpak[i].senttime + NODETIMEOUT < I_GetTime())
+		node_t *node = &nodes[i];
+
+		for (ack = NextAck(node->remotefirstack); ack != node->nextacknum && node->numacks; ack = NextAck(ack))
 		{
-			if (ackpak[i].resentnum > 20 && (node->flags & NF_CLOSE))
-			{
-				DEBFILE(va("ack %d sent 20 times so connection is supposed lost: node %d\n",
-					i, nodei));
-				Net_CloseConnection(nodei | FORCECLOSE);
+			const INT32 slot = node->ackslot[ack];
 
-				ackpak[i].acknum = 0;
+			if (slot == NOACKSLOT || ackpak[slot].senttime + NODETIMEOUT >= I_GetTime())
 				continue;
+
+			if (ackpak[slot].resentnum > 20 && (node->flags & NF_CLOSE))
+			{
+				DEBFILE(va("ack %d sent 20 times so connection is supposed lost: node %d\n",
+					ack, i));
+				Net_CloseConnection(i | FORCECLOSE); // Also frees the rest of its acks
+				break;
 			}
-			DEBFILE(va("Resend ack %d, %u<%d at %u\n", ackpak[i].acknum, ackpak[i].senttime,
+			DEBFILE(va("Resend ack %d, %u<%d at %u\n", ackpak[slot].acknum, ackpak[slot].senttime,
 				NODETIMEOUT, I_GetTime()));
-			M_Memcpy(netbuffer, ackpak[i].pak.raw, ackpak[i].length);
-			ackpak[i].senttime = I_GetTime();
-			ackpak[i].resentnum++;
-			ackpak[i].nextacknum = node->nextacknum;
+			M_Memcpy(netbuffer, ackpak[slot].pak.raw, ackpak[slot].length);
+			ackpak[slot].senttime = I_GetTime();
+			ackpak[slot].resentnum++;
+			ackpak[slot].nextacknum = node->nextacknum;
 			retransmit++; // For stat
-			HSendPacket((INT32)(node - nodes), false, ackpak[i].acknum,
-				(size_t)(ackpak[i].length - BASEPACKETSIZE));
+			HSendPacket(i, false, ackpak[slot].acknum,
+				(size_t)(ackpak[slot].length - BASEPACKETSIZE));
 		}
 	}
 
@@ -554,36 +626,23 @@ void Net_UnAcknowledgePacket(INT32 node)
 #ifdef NONET
 	(void)node;
 #else
-	INT32 hm1 = (nodes[node].acktosend_head-1+MAXACKTOSEND) % MAXACKTOSEND;
+	node_t *n = &nodes[node];
+	const UINT8 ack = netbuffer->ack;
 	DEBFILE(va("UnAcknowledge node %d\n", node));
 	if (!node)
 		return;
-	if (nodes[node].acktosend[hm1] == netbuffer->ack)
-	{
-		nodes[node].acktosend[hm1] = 0;
-		nodes[node].acktosend_head = (UINT8)hm1;
-	}
-	else if (nodes[node].firstacktosend == netbuffer->ack)
+	if (AckReceived(n, ack))
+		SetAckReceived(n, ack, false);
+	else if (cmpack(ack, n->firstacktosend) <= 0)
 	{
-		nodes[node].firstacktosend--;
-		if (!nodes[node].firstacktosend)
-			nodes[node].firstacktosend = UINT8_MAX;
-	}
-	else
-	{
-		while (nodes[node].firstacktosend != netbuffer->ack)
+		// The packet was taken in order, step back before it and
+		// put the ones that followed it back in the out of order bitmap
+		while (n->firstacktosend != ack)
 		{
-			nodes[node].acktosend_tail = (UINT8)
-				((nodes[node].acktosend_tail-1+MAXACKTOSEND) % MAXACKTOSEND);
-			nodes[node].acktosend[nodes[node].acktosend_tail] = nodes[node].firstacktosend;
-
-			nodes[node].firstacktosend--;
-			if (!nodes[node].firstacktosend)
-				nodes[node].firstacktosend = UINT8_MAX;
+			SetAckReceived(n, n->firstacktosend, true);
+			n->firstacktosend = PrevAck(n->firstacktosend);
 		}
-		nodes[node].firstacktosend++;
-		if (!nodes[node].firstacktosend)
-			nodes[node].firstacktosend = 1;
+		n->firstacktosend = PrevAck(ack);
 	}
 #endif
 }
@@ -596,13 +655,7 @@ void Net_UnAcknowledgePacket(INT32 node)
   */
 static boolean Net_AllAcksReceived(void)
 {
-	INT32 i;
-
-	for (i = 0; i < MAXACKPACKETS; i++)
-		if (ackpak[i].acknum)
-			return false;
-
-	return true;
+	return numfreeackpak == MAXACKPACKETS;
 }
 #endif
 
@@ -636,10 +689,16 @@ void Net_WaitAllAckReceived(UINT32 timeout)
 
 static void InitNode(node_t *node)
 {
-	node->acktosend_head = node->acktosend_tail = 0;
+	INT32 i;
+
+	memset(node->acktosend, 0, sizeof (node->acktosend));
+	node->numacktosend = 0;
 	node->firstacktosend = 0;
 	node->nextacknum = 1;
 	node->remotefirstack = 0;
+	for (i = 0; i < 256; i++)
+		node->ackslot[i] = NOACKSLOT;
+	node->numacks = 0;
 	node->flags = 0;
 }
 
@@ -648,8 +707,13 @@ static void InitAck(void)
 	INT32 i;
 
 #ifndef NONET
+	// Hand the slots out in order, the stack pops from the end
 	for (i = 0; i < MAXACKPACKETS; i++)
+	{
 		ackpak[i].acknum = 0;
+		freeackpak[i] = (INT16)(MAXACKPACKETS - 1 - i);
+	}
+	numfreeackpak = MAXACKPACKETS;
 #endif
 
 	for (i = 0; i < MAXNETNODES; i++)
@@ -671,7 +735,7 @@ void Net_AbortPacketType(UINT8 packettype)
 		if (ackpak[i].acknum && (ackpak[i].pak.data.packettype == packettype
 			|| packettype == UINT8_MAX))
 		{
-			ackpak[i].acknum = 0;
+			FreeAckpak(i);
 		}
 #endif
 }
@@ -716,14 +780,15 @@ void Net_CloseConnection(INT32 node)
 	}
 
 	// check if we are waiting for an ack from this node
-	for (i = 0; i < MAXACKPACKETS; i++)
-		if (ackpak[i].acknum && ackpak[i].destinationnode == node)
-		{
-			if (!forceclose)
-				return; // connection will be closed when ack is returned
-			else
-				ackpak[i].acknum = 0;
-		}
+	if (nodes[node].numacks)
+	{
+		if (!forceclose)
+			return; // connection will be closed when ack is returned
+
+		for (i = 0; i < MAXACKPACKETS; i++)
+			if (ackpak[i].acknum && ackpak[i].destinationnode == node)
+				FreeAckpak(i);
+	}
 
 	InitNode(&nodes[node]);
 	SV_AbortSendFiles(node);
@@ -829,7 +894,9 @@ static const char *packettypename[NUMPACKETTYPE] =
 	"LOGIN",
 	"TELLFILESNEEDED",
 	"MOREFILESNEEDED",
-	"PING"
+	"PING",
+
+	"SERVERTICSDELTA"
 };
 
 static void DebugPrintpacket(const char *header)
@@ -848,6 +915,10 @@ static void DebugPrintpacket(const char *header)
 			fprintf(debugfile, "    number %d mode %d\n", netbuffer->u.clientcfg.localplayers,
 				netbuffer->u.clientcfg.mode);
 			break;
+		case PT_SERVERTICSDELTA:
+			fprintf(debugfile, "    firsttic %u ply %d tics %d\n",
+				(UINT32)netbuffer->u.serverpak.starttic, netbuffer->u.serverpak.numslots, netbuffer->u.serverpak.numtics);
+			break;
 		case PT_SERVERTICS:
 		{
 			servertics_pak *serverpak = &netbuffer->u.serverpak;
@@ -1138,12 +1209,18 @@ boolean HGetPacket(void)
 	while(true)
 	{
 		//nodejustjoined = I_NetGet();
+		netpacketarrival = 0;
 		I_NetGet();
 
 		if (doomcom->remotenode == -1) // No packet received
 			return false;
 
 		getbytes += packetheaderlength + doomcom->datalength; // For stat
+		if (netpacketarrival)
+		{
+			netwaittime += I_GetPreciseTime() - netpacketarrival;
+			netwaitpackets++;
+		}
 
 		if (doomcom->remotenode >= MAXNETNODES)
 		{
@@ -1267,6 +1344,7 @@ boolean D_CheckNetGame(void)
 	I_NetGet = Internal_Get;
 	I_NetSend = Internal_Send;
 	I_NetCanSend = NULL;
+	I_NetFlush = NULL;
 	I_NetCloseSocket = NULL;
 	I_NetFreeNodenum = Internal_FreeNodenum;
 	I_NetMakeNodewPort = NULL;
@@ -1462,6 +1540,7 @@ void D_CloseConnection(void)
 		I_NetGet = Internal_Get;
 		I_NetSend = Internal_Send;
 		I_NetCanSend = NULL;
+		I_NetFlush = NULL;
 		I_NetCloseSocket = NULL;
 		I_NetFreeNodenum = Internal_FreeNodenum;
 		I_NetMakeNodewPort = NULL;
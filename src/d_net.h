@@ -32,10 +32,16 @@
 extern INT32 ticruned, ticmiss;
 extern INT32 getbps, sendbps;
 extern float lostpercent, duppercent, gamelostpercent;
+extern float syscallspertic;
+extern float netwaitms; // Average time packets waited between arrival and processing
+extern float ticcmdpercent; // Size of the ticcmds sent in PT_SERVERTICS(DELTA) compared to sending them raw
 extern INT32 packetheaderlength;
 boolean Net_GetNetStat(void);
 extern INT32 getbytes;
 extern INT64 sendbytes; // Realtime updated
+extern INT32 netsyscalls; // Socket syscalls made by the network driver, realtime updated
+extern precise_t netpacketarrival; // When the packet in doomcom arrived, if the driver read it ahead
+extern INT64 ticcmdrawbytes, ticcmdsentbytes; // Realtime updated
 
 extern SINT8 nodetoplayer[MAXNETNODES];
 extern SINT8 nodetoplayer2[MAXNETNODES]; // Say the numplayer for this node if any (splitscreen)
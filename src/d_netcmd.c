@@ -43,12 +43,15 @@
 #include "filesrch.h"
 #include "mserv.h"
 #include "z_zone.h"
+#include "p_saveg.h" // archivetest
 #include "lua_script.h"
+#include "lua_profile.h"
 #include "lua_hook.h"
 #include "m_cond.h"
 #include "m_anigif.h"
 #include "md5.h"
 #include "m_perfstats.h"
+#include "m_parallel.h"
 #include "hardware/u_list.h" // TODO: this should be a standard utility class
 
 // STAR NOTE: HI! THIS CAN CAUSE NETGAME RESYNCS, IF YOU ENABLE THE DEFINITION OF COURSE, SO BE CAREFUL!
@@ -408,6 +411,15 @@ static CV_PossibleValue_t ps_descriptor_cons_t[] = {
 	{1, "Average"}, {2, "SD"}, {3, "Minimum"}, {4, "Maximum"}, {0, NULL}};
 consvar_t cv_ps_descriptor = CVAR_INIT ("ps_descriptor", "Average", 0, ps_descriptor_cons_t, NULL);
 
+// Lua garbage collector scheduling, see LUA_Step
+static CV_PossibleValue_t luagcbudget_cons_t[] = {{0, "MIN"}, {20000, "MAX"}, {0, NULL}};
+consvar_t cv_luagcbudget = CVAR_INIT ("luagc_budget", "1000", CV_SAVE, luagcbudget_cons_t, NULL);
+static CV_PossibleValue_t luagcstepsize_cons_t[] = {{1, "MIN"}, {256, "MAX"}, {0, NULL}};
+consvar_t cv_luagcstepsize = CVAR_INIT ("luagc_stepsize", "4", CV_SAVE, luagcstepsize_cons_t, NULL);
+static CV_PossibleValue_t luagctuning_cons_t[] = {{100, "MIN"}, {1000, "MAX"}, {0, NULL}};
+consvar_t cv_luagcpause = CVAR_INIT ("luagc_pause", "200", CV_SAVE|CV_CALL, luagctuning_cons_t, LUA_GCTuning_OnChange);
+consvar_t cv_luagcstepmul = CVAR_INIT ("luagc_stepmul", "200", CV_SAVE|CV_CALL, luagctuning_cons_t, LUA_GCTuning_OnChange);
+
 consvar_t cv_freedemocamera = CVAR_INIT("freedemocamera", "Off", CV_SAVE, CV_OnOff, NULL);
 
 char timedemo_name[256];
@@ -623,9 +635,12 @@ void D_RegisterServerCommands(void)
 	CV_RegisterVar(&cv_joinnextround);
 	CV_RegisterVar(&cv_showjoinaddress);
 	CV_RegisterVar(&cv_blamecfail);
+	CV_RegisterVar(&cv_netsavecompression);
 #endif
 
 	COM_AddCommand("ping", Command_Ping_f, COM_LUA);
+	COM_AddCommand("tickstats", Command_Tickstats_f, 0);
+	COM_AddCommand("luaprofile", Command_LuaProfile_f, 0);
 	CV_RegisterVar(&cv_nettimeout);
 	CV_RegisterVar(&cv_jointimeout);
 
@@ -918,6 +933,15 @@ void D_RegisterClientCommands(void)
 	CV_RegisterVar(&cv_ps_samplesize);
 	CV_RegisterVar(&cv_ps_descriptor);
 
+	CV_RegisterVar(&cv_luagcbudget);
+	CV_RegisterVar(&cv_luagcstepsize);
+	CV_RegisterVar(&cv_luagcpause);
+	CV_RegisterVar(&cv_luagcstepmul);
+
+	// m_parallel.c
+	CV_RegisterVar(&cv_workerthreads);
+	CV_RegisterVar(&cv_parallelcheck);
+
 	// ingame object placing
 	COM_AddCommand("objectplace", Command_ObjectPlace_f, COM_LUA);
 	//COM_AddCommand("writethings", Command_Writethings_f);
@@ -4869,11 +4893,12 @@ static void Command_Togglemodified_f(void)
 	modifiedgame = !modifiedgame;
 }
 
-extern UINT8 *save_p;
 static void Command_Archivetest_f(void)
 {
 	UINT8 *buf;
 	UINT32 i, wrote;
+	size_t length;
+	precise_t start, archivetime, unarchivetime;
 	thinker_t *th;
 	if (gamestate != GS_LEVEL)
 	{
@@ -4888,13 +4913,21 @@ static void Command_Archivetest_f(void)
 			((mobj_t *)th)->mobjnum = i++;
 
 	// allocate buffer
-	buf = save_p = ZZ_Alloc(1024);
+	if (!P_SaveBufferAlloc(1024))
+	{
+		CONS_Printf("Out of memory.\n");
+		return;
+	}
 
 	// test archive
 	CONS_Printf("LUA_Archive...\n");
+	start = I_GetPreciseTime();
 	LUA_Archive();
+	archivetime = I_GetPreciseTime() - start;
+	P_SaveBufferReserve(1);
 	WRITEUINT8(save_p, 0x7F);
-	wrote = (UINT32)(save_p-buf);
+	buf = P_SaveBufferFinish(&length);
+	wrote = (UINT32)length;
 
 	// clear Lua state, so we can really see what happens!
 	CONS_Printf("Clearing state!\n");
@@ -4903,13 +4936,20 @@ static void Command_Archivetest_f(void)
 	// test unarchive
 	save_p = buf;
 	CONS_Printf("LUA_UnArchive...\n");
-	LUA_UnArchive();
+	start = I_GetPreciseTime();
+	if (!LUA_UnArchive())
+		CONS_Printf("Archive rejected.\n");
+	unarchivetime = I_GetPreciseTime() - start;
 	i = READUINT8(save_p);
 	if (i != 0x7F || wrote != (UINT32)(save_p-buf))
 		CONS_Printf("Savegame corrupted. (write %u, read %u)\n", wrote, (UINT32)(save_p-buf));
 
+	CONS_Printf("%u bytes, archived in %.3f ms, unarchived in %.3f ms\n", wrote,
+		(double)archivetime * 1000.0 / I_GetPrecisePrecision(),
+		(double)unarchivetime * 1000.0 / I_GetPrecisePrecision());
+
 	// free buffer
-	Z_Free(buf);
+	free(buf);
 	CONS_Printf("Done. No crash.\n");
 }
 #endif
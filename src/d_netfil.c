@@ -49,6 +49,7 @@
 #include "m_menu.h"
 #include "md5.h"
 #include "filesrch.h"
+#include "m_parallel.h"
 
 #include <errno.h>
 
@@ -69,17 +70,51 @@ typedef struct filetx_s
 	struct filetx_s *next; // Next file in the list
 } filetx_t;
 
+// State of each fragment of the file being sent
+enum
+{
+	FRAG_UNSENT, // Not sent yet, or lost
+	FRAG_INFLIGHT, // Sent, waiting for an ack
+	FRAG_ACKED,
+};
+
+// A sent fragment, kept in send order until it is acked or lost
+typedef struct
+{
+	UINT32 fragment;
+	precise_t senttime;
+} inflightfrag_t;
+
+#define MAXFILEWINDOW 1024 // Max fragments in flight per node
+#define INITFILEWINDOW 4
+
 // Current transfers (one for each node)
 typedef struct filetran_s
 {
 	filetx_t *txlist; // Linked list of all files for the node
 	UINT8 iteration;
-	UINT8 ackediteration;
 	UINT32 position; // The current position in the file
-	boolean *ackedfragments;
+	UINT8 *fragmentstate; // FRAG_* for each fragment
+	UINT32 numfragments;
+	UINT32 ackedfragments;
 	UINT32 ackedsize;
 	FILE *currentfile; // The file currently being sent/received
-	tic_t dontsenduntil;
+
+	// AIMD congestion window, in fragments
+	inflightfrag_t *inflight; // Ring buffer of MAXFILEWINDOW, oldest first
+	UINT32 inflighthead, inflightcount; // Ring entries, acked ones are dropped lazily
+	UINT32 numinflight; // Fragments actually in flight
+	UINT32 cwnd, ssthresh, cwndacks;
+	precise_t recoverytime; // Losses of fragments sent before this don't shrink the window again
+
+	// Round trip time, sampled on one fragment at a time
+	precise_t srtt, rttvar;
+	UINT32 rttprobe;
+	precise_t rttprobetime;
+
+	// Statistics for the current file
+	precise_t starttime;
+	UINT32 sentfragments, lostfragments;
 } filetran_t;
 static filetran_t transfer[MAXNETNODES];
 
@@ -92,16 +127,10 @@ fileneeded_t *fileneeded; // List of needed files
 static tic_t lasttimeackpacketsent = 0;
 char downloaddir[512] = "DOWNLOAD";
 
-// For resuming failed downloads
-typedef struct
-{
-	char filename[MAX_WADPATH];
-	UINT8 md5sum[16];
-	boolean *receivedfragments;
-	UINT32 fragmentsize;
-	UINT32 currentsize;
-} pauseddownload_t;
-static pauseddownload_t *pauseddownload = NULL;
+// Interrupted downloads are kept next to a "<file>.part" file
+// that records which fragments were already received
+#define PARTIALMAGIC "SRB2PART"
+#define PARTIALHEADERSIZE (8 + 3*sizeof(UINT32))
 
 #ifndef NONET
 // for cl loading screen
@@ -333,29 +362,118 @@ boolean CL_CheckDownloadable(void)
 	return false;
 }
 
-/** Returns true if a needed file transfer can be resumed
+/** Builds the path of a needed file in the download cache. Files are
+  * stored as DOWNLOAD/<md5>/<name>, so an addon downloaded from one server
+  * is found again when joining any other server that uses it.
   *
-  * \param file The needed file to resume the transfer for
-  * \return True if the transfer can be resumed
+  * \param path Buffer of MAX_WADPATH characters to store the path in
+  * \param file The needed file
+  * \return False if the path doesn't fit in MAX_WADPATH
   *
   */
-static boolean CL_CanResumeDownload(fileneeded_t *file)
+static boolean CL_GetCachePath(char *path, const fileneeded_t *file)
 {
-	return pauseddownload
-		&& !strcmp(pauseddownload->filename, file->filename) // Same name
-		&& !memcmp(pauseddownload->md5sum, file->md5sum, 16) // Same checksum
-		&& pauseddownload->fragmentsize == file->fragmentsize; // Same fragment size
+	char md5tmp[33];
+	char name[MAX_WADPATH];
+	INT32 j;
+
+	for (j = 0; j < 16; j++)
+		sprintf(&md5tmp[j*2], "%02x", file->md5sum[j]);
+
+	strlcpy(name, file->filename, sizeof name);
+	nameonly(name);
+
+	return snprintf(path, MAX_WADPATH, "%s/%s/%s", downloaddir, md5tmp, name) < MAX_WADPATH;
 }
 
-void CL_AbortDownloadResume(void)
+/** Saves which fragments of an interrupted download were received,
+  * so the download can be resumed later
+  *
+  * \param file The needed file being downloaded
+  *
+  */
+static void CL_SavePartialDownload(const fileneeded_t *file)
 {
-	if (!pauseddownload)
+	UINT32 numfragments = file->totalsize / file->fragmentsize + 1;
+	size_t length = PARTIALHEADERSIZE + (numfragments + 7) / 8;
+	UINT8 *buffer = calloc(1, length);
+	UINT8 *p = buffer;
+	UINT32 i;
+
+	if (!buffer)
 		return;
 
-	free(pauseddownload->receivedfragments);
-	remove(pauseddownload->filename);
-	free(pauseddownload);
-	pauseddownload = NULL;
+	WRITEMEM(p, PARTIALMAGIC, 8);
+	WRITEUINT32(p, file->fragmentsize);
+	WRITEUINT32(p, file->totalsize);
+	WRITEUINT32(p, file->currentsize);
+	for (i = 0; i < numfragments; i++)
+		if (file->receivedfragments[i])
+			p[i / 8] |= 1 << (i % 8);
+
+	if (!FIL_WriteFile(va("%s.part", file->filename), buffer, length))
+		remove(file->filename); // Can't resume it, don't leave garbage around
+
+	free(buffer);
+}
+
+/** Reopens an interrupted download, if its fragment list was saved
+  * and matches the transfer the server is starting
+  *
+  * \param file The needed file to resume the download for
+  * \return True if the download was resumed
+  *
+  */
+static boolean CL_ResumePartialDownload(fileneeded_t *file)
+{
+	UINT32 numfragments = file->totalsize / file->fragmentsize + 1;
+	UINT32 fragmentsize, totalsize, i;
+	UINT8 *buffer = NULL;
+	UINT8 *p;
+	size_t length;
+
+	if (file->type != FILENEEDED_WAD)
+		return false;
+
+	length = FIL_ReadFile(va("%s.part", file->filename), &buffer);
+	if (!length)
+		return false;
+
+	p = buffer;
+	if (length != PARTIALHEADERSIZE + (numfragments + 7) / 8 || memcmp(p, PARTIALMAGIC, 8))
+	{
+		Z_Free(buffer);
+		return false;
+	}
+	p += 8;
+
+	fragmentsize = READUINT32(p);
+	totalsize = READUINT32(p);
+	if (fragmentsize != file->fragmentsize || totalsize != file->totalsize)
+	{
+		Z_Free(buffer);
+		return false;
+	}
+
+	file->file = fopen(file->filename, "r+b");
+	file->receivedfragments = calloc(numfragments, sizeof(*file->receivedfragments));
+	if (!file->file || !file->receivedfragments)
+	{
+		if (file->file)
+			fclose(file->file);
+		free(file->receivedfragments);
+		file->file = NULL;
+		file->receivedfragments = NULL;
+		Z_Free(buffer);
+		return false;
+	}
+
+	file->currentsize = READUINT32(p);
+	for (i = 0; i < numfragments; i++)
+		file->receivedfragments[i] = (p[i / 8] >> (i % 8)) & 1;
+
+	Z_Free(buffer);
+	return true;
 }
 
 /** Sends requests for files in the ::fileneeded table with a status of
@@ -368,6 +486,7 @@ void CL_AbortDownloadResume(void)
 boolean CL_SendFileRequest(void)
 {
 	char *p;
+	char cachepath[MAX_WADPATH];
 	INT32 i;
 	INT64 totalfreespaceneeded = 0, availablefreespace;
 
@@ -392,9 +511,18 @@ boolean CL_SendFileRequest(void)
 
 			WRITEUINT8(p, i); // fileid
 
-			// put it in download dir
-			nameonly(fileneeded[i].filename);
-			strcatbf(fileneeded[i].filename, downloaddir, "/");
+			// put it in the download cache, or straight in the
+			// download dir if the cache path would be too long
+			if (CL_GetCachePath(cachepath, &fileneeded[i]))
+			{
+				strcpy(fileneeded[i].filename, cachepath);
+				MakePathDirs(fileneeded[i].filename);
+			}
+			else
+			{
+				nameonly(fileneeded[i].filename);
+				strcatbf(fileneeded[i].filename, downloaddir, "/");
+			}
 
 			fileneeded[i].status = FS_REQUESTED;
 		}
@@ -435,6 +563,45 @@ boolean PT_RequestFile(INT32 node)
 	return true; // no problems with any files
 }
 
+/** Looks for a needed file in the download cache, then everywhere else
+  * Runs on worker threads: only touches the file's own entry
+  *
+  * \param file The needed file
+  * \return The status of the file
+  *
+  */
+static filestatus_t CL_FindNeededFile(fileneeded_t *file)
+{
+	char path[MAX_WADPATH];
+	char partpath[MAX_WADPATH + 5];
+
+	if (CL_GetCachePath(path, file))
+	{
+		snprintf(partpath, sizeof partpath, "%s.part", path);
+
+		// The file can still disappear before it is hashed, so use
+		// the check that reports that instead of erroring out
+		if (!FIL_FileExists(partpath) && trycheckfilemd5(path, file->md5sum) == FS_FOUND)
+		{
+			strcpy(file->filename, path);
+			return FS_FOUND;
+		}
+	}
+
+	return findfile(file->filename, file->md5sum, true);
+}
+
+static void CL_FindNeededFiles(void *userdata, size_t start, size_t end)
+{
+	const INT32 *tosearch = userdata;
+
+	for (; start < end; start++)
+	{
+		fileneeded_t *file = &fileneeded[tosearch[start]];
+		file->status = CL_FindNeededFile(file);
+	}
+}
+
 /** Checks if the files needed aren't already loaded or on the disk
   *
   * \return 0 if some files are missing
@@ -453,6 +620,9 @@ INT32 CL_CheckFiles(void)
 	char wadfilename[MAX_WADPATH];
 	size_t filestoload = 0;
 	boolean downloadrequired = false;
+	INT32 tosearch[4 * (MAXWORKERTHREADS + 1)];
+	INT32 numtosearch = 0, maxtosearch = 4 * M_ParallelThreads();
+	boolean checking = false;
 
 	// Modified game handling -- check for an identical file list
 	// must be identical in files loaded AND in order
@@ -504,7 +674,14 @@ INT32 CL_CheckFiles(void)
 		if (fileneeded[i].status != FS_NOTCHECKED) //since we're running this over multiple tics now, its possible for us to come across files checked in previous tics
 			continue;
 
-		CONS_Debug(DBG_NETPLAY, "searching for '%s' ", fileneeded[i].filename);
+		if (numtosearch >= maxtosearch)
+		{
+			checking = true;
+			continue;
+		}
+
+		checking = true;
+		CONS_Debug(DBG_NETPLAY, "searching for '%s'\n", fileneeded[i].filename);
 
 		// Check in already loaded files
 		for (j = mainwads; wadfiles[j]; j++)
@@ -513,21 +690,36 @@ INT32 CL_CheckFiles(void)
 			if (!stricmp(wadfilename, fileneeded[i].filename) &&
 				!memcmp(wadfiles[j]->md5sum, fileneeded[i].md5sum, 16))
 			{
-				CONS_Debug(DBG_NETPLAY, "already loaded\n");
+				CONS_Debug(DBG_NETPLAY, "'%s' already loaded\n", fileneeded[i].filename);
 				fileneeded[i].status = FS_OPEN;
-				return 4;
+				break;
 			}
 		}
 
+		if (fileneeded[i].status == FS_OPEN)
+			continue;
+
 		if (fileneeded[i].folder)
+		{
 			fileneeded[i].status = findfolder(fileneeded[i].filename);
+			CONS_Debug(DBG_NETPLAY, "'%s' found %d\n", fileneeded[i].filename, fileneeded[i].status);
+		}
 		else
-			fileneeded[i].status = findfile(fileneeded[i].filename, fileneeded[i].md5sum, true);
+			tosearch[numtosearch++] = i;
+	}
 
-		CONS_Debug(DBG_NETPLAY, "found %d\n", fileneeded[i].status);
-		return 4;
+	if (numtosearch)
+	{
+		// Hashing files is what takes time, do a few at once
+		M_ParallelFor(numtosearch, 2, CL_FindNeededFiles, tosearch);
+
+		for (j = 0; j < numtosearch; j++)
+			CONS_Debug(DBG_NETPLAY, "'%s' found %d\n", fileneeded[tosearch[j]].filename, fileneeded[tosearch[j]].status);
 	}
 
+	if (checking)
+		return 4;
+
 	//now making it here means we've checked the entire list and no FS_NOTCHECKED files remain
 	if (numwadfiles+filestoload > MAX_WADFILES)
 		return 3;
@@ -956,6 +1148,7 @@ boolean AddLuaFileToSendQueue(INT32 node, const char *filename)
 static void SV_EndFileSend(INT32 node)
 {
 	filetx_t *p = transfer[node].txlist;
+	filetran_t *trans = &transfer[node];
 
 	// Free the file request according to the freemethod
 	// parameter used with AddFileToSendQueue/AddRamToSendQueue
@@ -963,7 +1156,18 @@ static void SV_EndFileSend(INT32 node)
 	{
 		case SF_FILE: // It's a file, close it and free its filename
 			if (cv_noticedownload.value)
+			{
 				CONS_Printf("Ending file transfer for node %d\n", node);
+				if (trans->fragmentstate)
+				{
+					double seconds = (double)(I_GetPreciseTime() - trans->starttime) / I_GetPrecisePrecision();
+					CONS_Printf("%s of %s bytes in %.2f s (%.1f KB/s), %u of %u fragments lost, window %u, rtt %.0f ms\n",
+						sizeu1(trans->ackedsize), sizeu2(p->size), seconds,
+						seconds > 0 ? trans->ackedsize / 1024.0 / seconds : 0.0,
+						trans->lostfragments, trans->sentfragments, trans->cwnd,
+						(double)trans->srtt * 1000.0 / I_GetPrecisePrecision());
+				}
+			}
 			if (transfer[node].currentfile)
 				fclose(transfer[node].currentfile);
 			free(p->id.filename);
@@ -982,26 +1186,277 @@ static void SV_EndFileSend(INT32 node)
 	free(p);
 
 	// Indicate that the transmission is over
-	transfer[node].currentfile = NULL;
-	if (transfer[node].ackedfragments)
-		free(transfer[node].ackedfragments);
-	transfer[node].ackedfragments = NULL;
+	trans->currentfile = NULL;
+	if (trans->fragmentstate)
+		free(trans->fragmentstate);
+	trans->fragmentstate = NULL;
+	if (trans->inflight)
+		free(trans->inflight);
+	trans->inflight = NULL;
+
+	// Forget the round trip time once the node has nothing left to download
+	if (!trans->txlist)
+		trans->srtt = trans->rttvar = 0;
 
 	filestosend--;
 }
 
 #define FILEFRAGMENTSIZE (software_MAXPACKETLENGTH - (FILETXHEADER + BASEPACKETSIZE))
 
+/** Returns how long to wait for an ack before a fragment is considered lost
+  *
+  * \param trans The transfer
+  *
+  */
+static precise_t SV_FileRetransmitTimeout(const filetran_t *trans)
+{
+	const precise_t second = I_GetPrecisePrecision();
+	precise_t rto;
+
+	if (!trans->srtt) // No sample yet
+		return second;
+
+	// Clients only ack once per tic, so never go below a few tics
+	rto = trans->srtt + 4 * trans->rttvar;
+	return min(max(rto, 3 * second / TICRATE), 2 * second);
+}
+
+/** Shrinks the congestion window after a loss, at most once per round trip
+  *
+  * \param trans    The transfer
+  * \param senttime When the lost fragment was sent
+  *
+  */
+static void SV_FileWindowLoss(filetran_t *trans, precise_t senttime)
+{
+	trans->lostfragments++;
+
+	if (senttime < trans->recoverytime)
+		return;
+
+	trans->ssthresh = max(trans->cwnd / 2, 2);
+	trans->cwnd = trans->ssthresh;
+	trans->cwndacks = 0;
+	trans->recoverytime = I_GetPreciseTime();
+}
+
+/** Grows the congestion window after a fragment in flight was acked
+  *
+  * \param trans The transfer
+  *
+  */
+static void SV_FileWindowAck(filetran_t *trans)
+{
+	if (trans->cwnd >= MAXFILEWINDOW)
+		return;
+
+	if (trans->cwnd < trans->ssthresh) // Slow start
+		trans->cwnd++;
+	else if (++trans->cwndacks >= trans->cwnd) // Congestion avoidance
+	{
+		trans->cwnd++;
+		trans->cwndacks = 0;
+	}
+}
+
+/** Drops acked fragments from the front of the in-flight list,
+  * and marks those that have waited too long as lost
+  *
+  * \param trans The transfer
+  *
+  */
+static void SV_FileExpireInflight(filetran_t *trans)
+{
+	const precise_t now = I_GetPreciseTime();
+	const precise_t rto = SV_FileRetransmitTimeout(trans);
+
+	while (trans->inflightcount)
+	{
+		inflightfrag_t *f = &trans->inflight[trans->inflighthead];
+
+		if (trans->fragmentstate[f->fragment] == FRAG_INFLIGHT)
+		{
+			if (now - f->senttime < rto)
+				break;
+
+			// Lost, send it again
+			trans->fragmentstate[f->fragment] = FRAG_UNSENT;
+			trans->numinflight--;
+			if (trans->rttprobe == f->fragment)
+				trans->rttprobe = UINT32_MAX;
+			SV_FileWindowLoss(trans, f->senttime);
+		}
+
+		trans->inflighthead = (trans->inflighthead + 1) % MAXFILEWINDOW;
+		trans->inflightcount--;
+	}
+}
+
+/** Initialises the congestion state for a new file
+  *
+  * \param node The destination
+  *
+  */
+static void SV_FileWindowInit(INT32 node)
+{
+	filetran_t *trans = &transfer[node];
+
+	trans->inflighthead = trans->inflightcount = trans->numinflight = 0;
+	trans->cwnd = INITFILEWINDOW;
+	trans->ssthresh = MAXFILEWINDOW;
+	trans->cwndacks = 0;
+	trans->recoverytime = 0;
+	trans->rttprobe = UINT32_MAX;
+
+	// Seed the round trip time with the node's ping if it's in game already
+	if (!trans->srtt && nodetoplayer[node] >= 0 && playerpingtable[nodetoplayer[node]])
+	{
+		trans->srtt = (precise_t)playerpingtable[nodetoplayer[node]] * I_GetPrecisePrecision() / 1000;
+		trans->rttvar = trans->srtt / 2;
+	}
+
+	trans->starttime = I_GetPreciseTime();
+	trans->sentfragments = trans->lostfragments = 0;
+}
+
+/** Opens the file at the front of a node's queue and starts tracking its fragments
+  *
+  * \param node The destination
+  *
+  */
+static void SV_StartFileSend(INT32 node)
+{
+	filetran_t *trans = &transfer[node];
+	filetx_t *f = trans->txlist;
+
+	if (!f->ram) // Sending a file
+	{
+		long filesize;
+
+		trans->currentfile =
+			fopen(f->id.filename, "rb");
+
+		if (!trans->currentfile)
+			I_Error("File %s does not exist",
+				f->id.filename);
+
+		fseek(trans->currentfile, 0, SEEK_END);
+		filesize = ftell(trans->currentfile);
+
+		// Nobody wants to transfer a file bigger
+		// than 4GB!
+		if (filesize >= LONG_MAX)
+			I_Error("filesize of %s is too large", f->id.filename);
+		if (filesize == -1)
+			I_Error("Error getting filesize of %s", f->id.filename);
+
+		f->size = (UINT32)filesize;
+		fseek(trans->currentfile, 0, SEEK_SET);
+	}
+	else // Sending RAM
+		trans->currentfile = (FILE *)1; // Set currentfile to a non-null value to indicate that it is open
+
+	trans->iteration = 1;
+	trans->position = 0;
+	trans->ackedsize = 0;
+	trans->ackedfragments = 0;
+
+	trans->numfragments = max((f->size + FILEFRAGMENTSIZE - 1) / FILEFRAGMENTSIZE, 1);
+	trans->fragmentstate = calloc(trans->numfragments, sizeof(*trans->fragmentstate));
+	trans->inflight = malloc(MAXFILEWINDOW * sizeof(*trans->inflight));
+	if (!trans->fragmentstate || !trans->inflight)
+		I_Error("FileSendTicker: No more memory\n");
+
+	SV_FileWindowInit(node);
+}
+
+/** Sends the next unacknowledged fragment to a node, if its window allows it
+  *
+  * \param node The destination
+  * \return 1 if a fragment was sent, 0 if the window is full, -1 if sending failed
+  *
+  */
+static INT32 SV_SendFileFragment(INT32 node)
+{
+	filetran_t *trans = &transfer[node];
+	filetx_t *f = trans->txlist;
+	filetx_pak *p;
+	size_t fragmentsize;
+	UINT32 fragment;
+	inflightfrag_t *slot;
+
+	if (trans->numinflight >= trans->cwnd
+		|| trans->inflightcount >= MAXFILEWINDOW
+		|| trans->ackedfragments + trans->numinflight >= trans->numfragments)
+		return 0;
+
+	// Find the first fragment that is neither acknowledged nor in flight
+	while (trans->fragmentstate[trans->position / FILEFRAGMENTSIZE] != FRAG_UNSENT)
+	{
+		trans->position += FILEFRAGMENTSIZE;
+		if (trans->position >= f->size)
+		{
+			trans->position = 0;
+			trans->iteration++;
+		}
+	}
+	fragment = trans->position / FILEFRAGMENTSIZE;
+
+	// Build a packet containing a file fragment
+	p = &netbuffer->u.filetxpak;
+	fragmentsize = FILEFRAGMENTSIZE;
+	if (f->size-trans->position < fragmentsize)
+		fragmentsize = f->size-trans->position;
+	if (f->ram)
+		M_Memcpy(p->data, &f->id.ram[trans->position], fragmentsize);
+	else
+	{
+		fseek(trans->currentfile, trans->position, SEEK_SET);
+
+		if (fread(p->data, 1, fragmentsize, trans->currentfile) != fragmentsize)
+			I_Error("FileSendTicker: can't read %s byte on %s at %d because %s", sizeu1(fragmentsize), f->id.filename, trans->position, M_FileError(trans->currentfile));
+	}
+	p->iteration = trans->iteration;
+	p->position = LONG(trans->position);
+	p->fileid = f->fileid;
+	p->filesize = LONG(f->size);
+	p->size = SHORT((UINT16)FILEFRAGMENTSIZE);
+
+	// Send the packet
+	if (!HSendPacket(node, false, 0, FILETXHEADER + fragmentsize)) // Don't use the default acknowledgement system
+		return -1;
+
+	slot = &trans->inflight[(trans->inflighthead + trans->inflightcount) % MAXFILEWINDOW];
+	slot->fragment = fragment;
+	slot->senttime = I_GetPreciseTime();
+	trans->inflightcount++;
+	trans->numinflight++;
+	trans->fragmentstate[fragment] = FRAG_INFLIGHT;
+	trans->sentfragments++;
+
+	if (trans->rttprobe == UINT32_MAX)
+	{
+		trans->rttprobe = fragment;
+		trans->rttprobetime = slot->senttime;
+	}
+
+	trans->position = (UINT32)(trans->position + fragmentsize);
+	if (trans->position >= f->size)
+	{
+		trans->position = 0;
+		trans->iteration++;
+	}
+
+	return 1;
+}
+
 /** Handles file transmission
   *
   */
 void FileSendTicker(void)
 {
 	static INT32 currentnode = 0;
-	filetx_pak *p;
-	size_t fragmentsize;
-	filetx_t *f;
-	INT32 packetsent, ram, i, j;
+	INT32 packetsent, i, idle;
 
 	// If someone is taking too long to download, kick them with a timeout
 	// to prevent blocking the rest of the server...
@@ -1022,127 +1477,69 @@ void FileSendTicker(void)
 	if (!filestosend) // No file to send
 		return;
 
+	// Find lost fragments first so they can be resent right away
+	for (i = 0; i < MAXNETNODES; i++)
+		if (transfer[i].txlist && transfer[i].currentfile)
+			SV_FileExpireInflight(&transfer[i]);
+
+	// Each node sends as much as its congestion window allows,
+	// within the server-wide per-tic limit
 	packetsent = cv_downloadspeed.value;
+	idle = 0;
 
 	netbuffer->packettype = PT_FILEFRAGMENT;
 
-	// (((sendbytes-nowsentbyte)*TICRATE)/(I_GetTime()-starttime)<(UINT32)net_bandwidth)
-	while (packetsent-- && filestosend != 0)
+	while (packetsent && filestosend != 0 && idle < MAXNETNODES)
 	{
-		for (i = currentnode, j = 0; j < MAXNETNODES;
-			i = (i+1) % MAXNETNODES, j++)
-		{
-			if (transfer[i].txlist)
-				break;
-		}
-		// no transfer to do
-		if (j >= MAXNETNODES)
-			I_Error("filestosend=%d but no file to send found\n", filestosend);
+		INT32 sent;
 
+		i = currentnode;
 		currentnode = (i+1) % MAXNETNODES;
-		f = transfer[i].txlist;
-		ram = f->ram;
 
-		// Open the file if it isn't open yet, or
-		if (!transfer[i].currentfile)
+		if (!transfer[i].txlist)
 		{
-			if (!ram) // Sending a file
-			{
-				long filesize;
-
-				transfer[i].currentfile =
-					fopen(f->id.filename, "rb");
-
-				if (!transfer[i].currentfile)
-					I_Error("File %s does not exist",
-						f->id.filename);
-
-				fseek(transfer[i].currentfile, 0, SEEK_END);
-				filesize = ftell(transfer[i].currentfile);
-
-				// Nobody wants to transfer a file bigger
-				// than 4GB!
-				if (filesize >= LONG_MAX)
-					I_Error("filesize of %s is too large", f->id.filename);
-				if (filesize == -1)
-					I_Error("Error getting filesize of %s", f->id.filename);
-
-				f->size = (UINT32)filesize;
-				fseek(transfer[i].currentfile, 0, SEEK_SET);
-			}
-			else // Sending RAM
-				transfer[i].currentfile = (FILE *)1; // Set currentfile to a non-null value to indicate that it is open
-
-			transfer[i].iteration = 1;
-			transfer[i].ackediteration = 0;
-			transfer[i].position = 0;
-			transfer[i].ackedsize = 0;
-
-			transfer[i].ackedfragments = calloc(f->size / FILEFRAGMENTSIZE + 1, sizeof(*transfer[i].ackedfragments));
-			if (!transfer[i].ackedfragments)
-				I_Error("FileSendTicker: No more memory\n");
-
-			transfer[i].dontsenduntil = 0;
-		}
-
-		// If the client hasn't acknowledged any fragment from the previous iteration,
-		// it is most likely because their acks haven't had enough time to reach the server
-		// yet, due to latency. In that case, we wait a little to avoid useless resend.
-		if (I_GetTime() < transfer[i].dontsenduntil)
+			idle++;
 			continue;
-
-		// Find the first non-acknowledged fragment
-		while (transfer[i].ackedfragments[transfer[i].position / FILEFRAGMENTSIZE])
-		{
-			transfer[i].position += FILEFRAGMENTSIZE;
-			if (transfer[i].position >= f->size)
-			{
-				if (transfer[i].ackediteration < transfer[i].iteration)
-					transfer[i].dontsenduntil = I_GetTime() + TICRATE / 2;
-
-				transfer[i].position = 0;
-				transfer[i].iteration++;
-			}
 		}
 
-		// Build a packet containing a file fragment
-		p = &netbuffer->u.filetxpak;
-		fragmentsize = FILEFRAGMENTSIZE;
-		if (f->size-transfer[i].position < fragmentsize)
-			fragmentsize = f->size-transfer[i].position;
-		if (ram)
-			M_Memcpy(p->data, &f->id.ram[transfer[i].position], fragmentsize);
-		else
-		{
-			fseek(transfer[i].currentfile, transfer[i].position, SEEK_SET);
-
-			if (fread(p->data, 1, fragmentsize, transfer[i].currentfile) != fragmentsize)
-				I_Error("FileSendTicker: can't read %s byte on %s at %d because %s", sizeu1(fragmentsize), f->id.filename, transfer[i].position, M_FileError(transfer[i].currentfile));
-		}
-		p->iteration = transfer[i].iteration;
-		p->position = LONG(transfer[i].position);
-		p->fileid = f->fileid;
-		p->filesize = LONG(f->size);
-		p->size = SHORT((UINT16)FILEFRAGMENTSIZE);
-
-		// Send the packet
-		if (HSendPacket(i, false, 0, FILETXHEADER + fragmentsize)) // Don't use the default acknowledgement system
-		{ // Success
-			transfer[i].position = (UINT32)(transfer[i].position + fragmentsize);
-			if (transfer[i].position >= f->size)
-			{
-				if (transfer[i].ackediteration < transfer[i].iteration)
-					transfer[i].dontsenduntil = I_GetTime() + TICRATE / 2;
+		// Open the file if it isn't open yet
+		if (!transfer[i].currentfile)
+			SV_StartFileSend(i);
 
-				transfer[i].position = 0;
-				transfer[i].iteration++;
-			}
-		}
-		else
+		sent = SV_SendFileFragment(i);
+		if (sent < 0)
 		{ // Not sent for some odd reason, retry at next call
 			// Exit the while (can't send this one so why should i send the next?)
 			break;
 		}
+		else if (sent)
+		{
+			packetsent--;
+			idle = 0;
+		}
+		else
+			idle++;
+	}
+}
+
+/** Updates the round trip time estimate with a new sample
+  *
+  * \param trans The transfer
+  * \param rtt   Time between sending a fragment and receiving its ack
+  *
+  */
+static void SV_FileRTTSample(filetran_t *trans, precise_t rtt)
+{
+	if (!trans->srtt)
+	{
+		trans->srtt = rtt;
+		trans->rttvar = rtt / 2;
+	}
+	else
+	{
+		precise_t err = rtt > trans->srtt ? rtt - trans->srtt : trans->srtt - rtt;
+		trans->rttvar = (3 * trans->rttvar + err) / 4;
+		trans->srtt = (7 * trans->srtt + rtt) / 8;
 	}
 }
 
@@ -1154,7 +1551,7 @@ void PT_FileAck(void)
 	INT32 i, j;
 
 	// Wrong file id? Ignore it, it's probably a late packet
-	if (!(trans->txlist && packet->fileid == trans->txlist->fileid))
+	if (!(trans->txlist && packet->fileid == trans->txlist->fileid && trans->fragmentstate))
 		return;
 
 	if (packet->numsegments * sizeof(*packet->segments) != doomcom->datalength - BASEPACKETSIZE - sizeof(*packet))
@@ -1163,13 +1560,6 @@ void PT_FileAck(void)
 		return;
 	}
 
-	if (packet->iteration > trans->ackediteration)
-	{
-		trans->ackediteration = packet->iteration;
-		if (trans->ackediteration >= trans->iteration - 1)
-			trans->dontsenduntil = 0;
-	}
-
 	for (i = 0; i < packet->numsegments; i++)
 	{
 		fileacksegment_t *segment = &packet->segments[i];
@@ -1177,19 +1567,35 @@ void PT_FileAck(void)
 		for (j = 0; j < 32; j++)
 			if (LONG(segment->acks) & (1 << j))
 			{
-				if (LONG(segment->start) * FILEFRAGMENTSIZE >= trans->txlist->size)
+				UINT32 fragment = (UINT32)LONG(segment->start) + j;
+
+				if (fragment >= trans->numfragments)
 				{
 					Net_CloseConnection(node);
 					return;
 				}
 
-				if (!trans->ackedfragments[LONG(segment->start) + j])
+				if (trans->fragmentstate[fragment] != FRAG_ACKED)
 				{
-					trans->ackedfragments[LONG(segment->start) + j] = true;
-					trans->ackedsize += FILEFRAGMENTSIZE;
+					if (trans->fragmentstate[fragment] == FRAG_INFLIGHT)
+					{
+						trans->numinflight--;
+						SV_FileWindowAck(trans);
+
+						if (fragment == trans->rttprobe)
+						{
+							SV_FileRTTSample(trans, I_GetPreciseTime() - trans->rttprobetime);
+							trans->rttprobe = UINT32_MAX;
+						}
+					}
+
+					trans->fragmentstate[fragment] = FRAG_ACKED;
+					trans->ackedfragments++;
+					// the last fragment is usually shorter
+					trans->ackedsize += min(FILEFRAGMENTSIZE, trans->txlist->size - fragment * FILEFRAGMENTSIZE);
 
 					// If the last missing fragment was acked, finish!
-					if (trans->ackedsize == trans->txlist->size)
+					if (trans->ackedfragments == trans->numfragments)
 					{
 						SV_EndFileSend(node);
 						return;
@@ -1336,24 +1742,19 @@ void PT_FileFragment(void)
 		if (!file->ackpacket)
 			I_Error("FileSendTicker: No more memory\n");
 
-		if (CL_CanResumeDownload(file))
+		file->totalsize = LONG(netbuffer->u.filetxpak.filesize);
+
+		if (CL_ResumePartialDownload(file))
 		{
-			file->file = fopen(filename, "r+b");
-			if (!file->file)
-				I_Error("Can't reopen file %s: %s", filename, strerror(errno));
 			CONS_Printf("\r%s...\n", filename);
 
 			CONS_Printf("Resuming download...\n");
-			file->currentsize = pauseddownload->currentsize;
-			file->receivedfragments = pauseddownload->receivedfragments;
 			file->ackresendposition = 0;
-
-			free(pauseddownload);
-			pauseddownload = NULL;
 		}
 		else
 		{
-			CL_AbortDownloadResume();
+			if (file->type == FILENEEDED_WAD)
+				remove(va("%s.part", filename));
 
 			file->file = fopen(filename, "wb");
 			if (!file->file)
@@ -1362,7 +1763,6 @@ void PT_FileFragment(void)
 			CONS_Printf("\r%s...\n",filename);
 
 			file->currentsize = 0;
-			file->totalsize = LONG(netbuffer->u.filetxpak.filesize);
 			file->ackresendposition = UINT32_MAX; // Only used for resumed downloads
 
 			file->receivedfragments = calloc(file->totalsize / fragmentsize + 1, sizeof(*file->receivedfragments));
@@ -1399,6 +1799,8 @@ void PT_FileFragment(void)
 				file->file = NULL;
 				free(file->receivedfragments);
 				free(file->ackpacket);
+				if (file->type == FILENEEDED_WAD)
+					remove(va("%s.part", filename));
 				file->status = FS_FOUND;
 				file->justdownloaded = true;
 				CONS_Printf(M_GetText("Downloading %s...(done)\n"),
@@ -1493,25 +1895,17 @@ void CloseNetFile(void)
 				fclose(fileneeded[i].file);
 				free(fileneeded[i].ackpacket);
 
-				if (!pauseddownload && (fileneeded[i].type == FILENEEDED_WAD || i != 0)) // 0 is the gamestate...
+				if (fileneeded[i].type == FILENEEDED_WAD)
 				{
 					// Don't remove the file, save it for later in case we resume the download
-					pauseddownload = malloc(sizeof(*pauseddownload));
-					if (!pauseddownload)
-						I_Error("CloseNetFile: No more memory\n");
-
-					strcpy(pauseddownload->filename, fileneeded[i].filename);
-					memcpy(pauseddownload->md5sum, fileneeded[i].md5sum, 16);
-					pauseddownload->currentsize = fileneeded[i].currentsize;
-					pauseddownload->receivedfragments = fileneeded[i].receivedfragments;
-					pauseddownload->fragmentsize = fileneeded[i].fragmentsize;
+					CL_SavePartialDownload(&fileneeded[i]);
 				}
 				else
 				{
 					// File is not complete, delete it.
-					free(fileneeded[i].receivedfragments);
 					remove(fileneeded[i].filename);
 				}
+				free(fileneeded[i].receivedfragments);
 			}
 	}
 
@@ -1589,7 +1983,9 @@ size_t nameonlylength(const char *s)
 #define O_BINARY 0
 #endif
 
-filestatus_t checkfilemd5(char *filename, const UINT8 *wantedmd5sum)
+// Same as checkfilemd5, but returns FS_NOTFOUND if the file can't be
+// opened. Safe to call from worker threads.
+filestatus_t trycheckfilemd5(const char *filename, const UINT8 *wantedmd5sum)
 {
 #if defined (NOMD5)
 	(void)wantedmd5sum;
@@ -1602,18 +1998,24 @@ filestatus_t checkfilemd5(char *filename, const UINT8 *wantedmd5sum)
 		return FS_FOUND;
 
 	fhandle = fopen(filename, "rb");
-	if (fhandle)
-	{
-		md5_stream(fhandle,md5sum);
-		fclose(fhandle);
-		if (!memcmp(wantedmd5sum, md5sum, 16))
-			return FS_FOUND;
-		return FS_MD5SUMBAD;
-	}
+	if (!fhandle)
+		return FS_NOTFOUND;
 
-	I_Error("Couldn't open %s for md5 check", filename);
+	md5_stream(fhandle,md5sum);
+	fclose(fhandle);
+	if (memcmp(wantedmd5sum, md5sum, 16))
+		return FS_MD5SUMBAD;
 #endif
-	return FS_FOUND; // will never happen, but makes the compiler shut up
+	return FS_FOUND;
+}
+
+filestatus_t checkfilemd5(char *filename, const UINT8 *wantedmd5sum)
+{
+	filestatus_t status = trycheckfilemd5(filename, wantedmd5sum);
+
+	if (status == FS_NOTFOUND)
+		I_Error("Couldn't open %s for md5 check", filename);
+	return status;
 }
 
 // Rewritten by Monster Iestyn to be less stupid
@@ -142,7 +142,6 @@ void MakePathDirs(char *path);
 
 void SV_AbortSendFiles(INT32 node);
 void CloseNetFile(void);
-void CL_AbortDownloadResume(void);
 
 void Command_Downloads_f(void);
 
@@ -152,6 +151,7 @@ boolean fileexist(char *filename, time_t ptime);
 filestatus_t findfile(char *filename, const UINT8 *wantedmd5sum,
 	boolean completepath);
 filestatus_t checkfilemd5(char *filename, const UINT8 *wantedmd5sum);
+filestatus_t trycheckfilemd5(const char *filename, const UINT8 *wantedmd5sum);
 
 // Searches for a folder
 filestatus_t findfolder(const char *path);
@@ -574,6 +574,8 @@ typedef struct player_s
 #ifdef HWRENDER
 	fixed_t fovadd; // adjust FOV for hw rendering
 #endif
+
+	INT32 luaref; // Registry reference to this player's Lua userdata, 0 if none (not synced)
 } player_t;
 
 // Values for dashmode
@@ -14,6 +14,11 @@ UINT32 I_GetFreeMem(UINT32 *total)
 	return 0;
 }
 
+size_t I_GetResidentMem(void)
+{
+	return 0;
+}
+
 void I_Sleep(UINT32 ms){}
 
 precise_t I_GetPreciseTime(void) {
@@ -451,7 +451,9 @@ filestatus_t filesearch(char *filename, const char *startpath, const UINT8 *want
 		}
 		else if (!strcasecmp(searchname, dent->d_name))
 		{
-			switch (checkfilemd5(searchpath, wantedmd5sum))
+			// may run on a worker thread, so a file that vanished
+			// since the stat is just skipped
+			switch (trycheckfilemd5(searchpath, wantedmd5sum))
 			{
 				case FS_FOUND:
 					if (completepath)
@@ -42,6 +42,12 @@ extern UINT8 keyboard_started;
 */
 UINT32 I_GetFreeMem(UINT32 *total);
 
+/**	\brief	The I_GetResidentMem function
+
+	\return	memory used by the game that is currently in RAM, 0 if unknown
+*/
+size_t I_GetResidentMem(void);
+
 /**	\brief	Returns precise time value for performance measurement. The precise
             time should be a monotonically increasing counter, and will wrap.
 			precise_t is internally represented as an unsigned integer and
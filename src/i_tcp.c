@@ -12,6 +12,10 @@
 ///        This is not really OS-dependent because all OSes have the same socket API.
 ///        Just use ifdef for OS-dependent parts.
 
+#if defined (__linux__) && !defined (_GNU_SOURCE)
+#define _GNU_SOURCE // recvmmsg, sendmmsg
+#endif
+
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
@@ -116,6 +120,11 @@
 	#endif
 	} mysockaddr_t;
 
+	// Linux can move a whole batch of datagrams per syscall
+	#if defined (__linux__) && !defined (USE_WINSOCK)
+		#define HAVE_MMSG
+	#endif
+
 	#ifdef HAVE_MINIUPNPC
 		#ifdef STATIC_MINIUPNPC
 			#define STATICLIB
@@ -161,6 +170,9 @@
 #endif
 
 #include "i_addrinfo.h"
+#ifdef HAVE_THREADS
+#include "i_threads.h"
+#endif
 #define SELECTTEST
 #define DEFAULTPORT "5029"
 
@@ -195,6 +207,55 @@
 	/* See ../doc/Holepunch-Protocol.txt */
 	static const INT32 hole_punch_magic = MSBF_LONG (0x52eb11);
 	// END THE MAGIC HERE //
+
+	#ifdef HAVE_MMSG
+		#define MMSGBATCH 32
+
+		typedef struct
+		{
+			char data[MAXPACKETLENGTH];
+			ssize_t length;
+			mysockaddr_t addr;
+			socklen_t addrlen;
+			SOCKET_TYPE socket;
+			INT32 node; // node to report send errors for, or -1
+		} mmsgpacket_t;
+
+		// Packets read ahead by recvmmsg, handed out one at a time by SOCK_Get
+		static mmsgpacket_t recvqueue[MMSGBATCH];
+		static size_t recvqueuehead = 0, recvqueuelen = 0;
+
+		// Packets held back by SOCK_Send until the next SOCK_FlushSend
+		static mmsgpacket_t sendqueue[MMSGBATCH];
+		static size_t sendqueuelen = 0;
+		static boolean sendblocked = false;
+
+		static boolean usemmsg = true;
+	#endif
+
+	#if defined (HAVE_THREADS) && defined (__GNUC__)
+		#define HAVE_NETTHREAD
+		#define NETRINGSIZE 256 // must be a power of two
+
+		typedef struct
+		{
+			char data[MAXPACKETLENGTH];
+			ssize_t length;
+			mysockaddr_t addr;
+			socklen_t addrlen;
+			SOCKET_TYPE socket;
+			precise_t arrival;
+		} netringpacket_t;
+
+		// Single producer, single consumer ring filled by SOCK_ReceiveThread.
+		// Only the receive thread writes netringhead and only the main
+		// thread writes netringtail; a slot belongs to whoever owns it
+		// according to those two counters, so no lock is needed.
+		static netringpacket_t *netring = NULL;
+		static UINT32 netringhead = 0, netringtail = 0;
+		static INT32 netthreadrunning = 0; // cleared to ask the thread to stop
+		static INT32 netthreadexited = 1;
+	#endif
 #endif
 
 static size_t numbans = 0;
@@ -674,74 +735,205 @@ static void SOCK_RegisterHolePunch(void)
 }
 // I NEED A HOLEPUNCHER //
 
+// Works out which node a packet that was just read into doomcom came from.
+// Returns 1 if doomcom now holds a packet for the game, with *newnode set
+// if it came from a node we didn't know about; 0 if the packet was dropped;
+// or -1 if it was eaten by STUN or hole punching and reading should stop.
+static INT32 SOCK_IdentifyPacket(ssize_t c, mysockaddr_t *fromaddress, socklen_t fromlen,
+	SOCKET_TYPE sock, boolean *newnode)
+{
+	size_t i;
+	int j;
+
+	*newnode = false;
+
+#ifdef USE_STUN
+	if (STUN_got_response(doomcom->data, c))
+	{
+		return -1;
+	}
+#endif
+
+	if (hole_punch(c))
+	{
+		return -1;
+	}
+
+	// find remote node number
+	for (j = 1; j <= MAXNETNODES; j++) //include LAN
+	{
+		if (SOCK_cmpaddr(fromaddress, &clientaddress[j], 0))
+		{
+			doomcom->remotenode = (INT16)j; // good packet from a game player
+			doomcom->datalength = (INT16)c;
+			nodesocket[j] = sock;
+			return 1;
+		}
+	}
+	// not found
+
+	// find a free slot
+	j = getfreenode();
+	if (j > 0)
+	{
+		M_Memcpy(&clientaddress[j], fromaddress, fromlen);
+		nodesocket[j] = sock;
+		DEBFILE(va("New node detected: node:%d address:%s\n", j,
+				SOCK_GetNodeAddress(j)));
+		doomcom->remotenode = (INT16)j; // good packet from a game player
+		doomcom->datalength = (INT16)c;
+
+		// check if it's a banned dude so we can send a refusal later
+		for (i = 0; i < numbans; i++)
+		{
+			if (SOCK_cmpaddr(fromaddress, &banned[i], bannedmask[i]))
+			{
+				SOCK_bannednode[j] = true;
+				DEBFILE("This dude has been banned\n");
+				break;
+			}
+		}
+		if (i == numbans)
+			SOCK_bannednode[j] = false;
+		*newnode = true;
+		return 1;
+	}
+	else
+		DEBFILE("New node detected: No more free slots\n");
+
+	return 0;
+}
+
+#ifdef HAVE_MMSG
+static void SOCK_FlushSend(void);
+
+// Reads whatever is waiting on every socket into recvqueue, one recvmmsg
+// per socket. Returns false if nothing was read.
+static boolean SOCK_FillRecvQueue(void)
+{
+	struct mmsghdr msgs[MMSGBATCH];
+	struct iovec iov[MMSGBATCH];
+	size_t i, n;
+	int c;
+
+	recvqueuehead = recvqueuelen = 0;
+
+	for (n = 0; n < mysocketses && recvqueuelen < MMSGBATCH; n++)
+	{
+		const size_t room = MMSGBATCH - recvqueuelen;
+
+		for (i = 0; i < room; i++)
+		{
+			mmsgpacket_t *packet = &recvqueue[recvqueuelen + i];
+
+			iov[i].iov_base = packet->data;
+			iov[i].iov_len = MAXPACKETLENGTH;
+			memset(&msgs[i], 0, sizeof (msgs[i]));
+			msgs[i].msg_hdr.msg_name = &packet->addr;
+			msgs[i].msg_hdr.msg_namelen = (socklen_t)sizeof (packet->addr);
+			msgs[i].msg_hdr.msg_iov = &iov[i];
+			msgs[i].msg_hdr.msg_iovlen = 1;
+		}
+
+		c = recvmmsg(mysockets[n], msgs, (unsigned int)room, MSG_DONTWAIT, NULL);
+		netsyscalls++;
+
+		if (c == ERRSOCKET)
+		{
+			if (errno == ENOSYS)
+			{
+				// Old kernel, go back to one recvfrom per packet
+				usemmsg = false;
+				return false;
+			}
+			continue;
+		}
+
+		for (i = 0; i < (size_t)c; i++)
+		{
+			mmsgpacket_t *packet = &recvqueue[recvqueuelen + i];
+
+			packet->length = (ssize_t)msgs[i].msg_len;
+			packet->addrlen = msgs[i].msg_hdr.msg_namelen;
+			packet->socket = mysockets[n];
+		}
+
+		recvqueuelen += c;
+	}
+
+	return recvqueuelen > 0;
+}
+
+static boolean SOCK_GetBatched(void)
+{
+	boolean newnode;
+	INT32 result;
+
+	// Anything we were holding back should go out before we wait on replies
+	SOCK_FlushSend();
+
+	do
+	{
+		while (recvqueuehead < recvqueuelen)
+		{
+			mmsgpacket_t *packet = &recvqueue[recvqueuehead++];
+
+			M_Memcpy(doomcom->data, packet->data, packet->length);
+			result = SOCK_IdentifyPacket(packet->length, &packet->addr, packet->addrlen, packet->socket, &newnode);
+
+			if (result > 0)
+				return newnode;
+			if (result < 0)
+			{
+				doomcom->remotenode = -1; // no packet
+				return false;
+			}
+		}
+	} while (usemmsg && SOCK_FillRecvQueue());
+
+	doomcom->remotenode = -1; // no packet
+	return false;
+}
+#endif
+
+#ifdef HAVE_NETTHREAD
+static boolean SOCK_GetThreaded(void);
+#endif
+
 // Returns true if a packet was received from a new node, false in all other cases
 static boolean SOCK_Get(void)
 {
-	size_t i, n;
-	int j;
+	size_t n;
 	ssize_t c;
 	mysockaddr_t fromaddress;
 	socklen_t fromlen;
+	boolean newnode;
+	INT32 result;
+
+#ifdef HAVE_NETTHREAD
+	if (netthreadrunning)
+		return SOCK_GetThreaded();
+#endif
+
+#ifdef HAVE_MMSG
+	if (usemmsg)
+		return SOCK_GetBatched();
+#endif
 
 	for (n = 0; n < mysocketses; n++)
 	{
 		fromlen = (socklen_t)sizeof(fromaddress);
 		c = recvfrom(mysockets[n], (char *)&doomcom->data, MAXPACKETLENGTH, 0,
 			(void *)&fromaddress, &fromlen);
+		netsyscalls++;
 		if (c != ERRSOCKET)
 		{
-#ifdef USE_STUN
-			if (STUN_got_response(doomcom->data, c))
-			{
-				break;
-			}
-#endif
+			result = SOCK_IdentifyPacket(c, &fromaddress, fromlen, mysockets[n], &newnode);
 
-			if (hole_punch(c))
-			{
+			if (result > 0)
+				return newnode;
+			if (result < 0)
 				break;
-			}
-
-			// find remote node number
-			for (j = 1; j <= MAXNETNODES; j++) //include LAN
-			{
-				if (SOCK_cmpaddr(&fromaddress, &clientaddress[j], 0))
-				{
-					doomcom->remotenode = (INT16)j; // good packet from a game player
-					doomcom->datalength = (INT16)c;
-					nodesocket[j] = mysockets[n];
-					return false;
-				}
-			}
-			// not found
-
-			// find a free slot
-			j = getfreenode();
-			if (j > 0)
-			{
-				M_Memcpy(&clientaddress[j], &fromaddress, fromlen);
-				nodesocket[j] = mysockets[n];
-				DEBFILE(va("New node detected: node:%d address:%s\n", j,
-						SOCK_GetNodeAddress(j)));
-				doomcom->remotenode = (INT16)j; // good packet from a game player
-				doomcom->datalength = (INT16)c;
-
-				// check if it's a banned dude so we can send a refusal later
-				for (i = 0; i < numbans; i++)
-				{
-					if (SOCK_cmpaddr(&fromaddress, &banned[i], bannedmask[i]))
-					{
-						SOCK_bannednode[j] = true;
-						DEBFILE("This dude has been banned\n");
-						break;
-					}
-				}
-				if (i == numbans)
-					SOCK_bannednode[j] = false;
-				return true;
-			}
-			else
-				DEBFILE("New node detected: No more free slots\n");
 		}
 	}
 
@@ -779,9 +971,16 @@ static boolean SOCK_CanSend(void)
 	fd_set tset;
 	int wselect;
 
+#ifdef HAVE_MMSG
+	// Sends are queued anyway, so go by how the last flush went
+	if (usemmsg)
+		return !sendblocked;
+#endif
+
 	if(!FD_CPY(&masterset, &tset, mysockets, mysocketses))
 		return false;
 	wselect = select(255, NULL, &tset, NULL, &timeval_for_select);
+	netsyscalls++;
 	if (wselect >= 1)
 		return true;
 	return false;
@@ -796,6 +995,7 @@ static boolean SOCK_CanGet(void)
 	if(!FD_CPY(&masterset, &tset, mysockets, mysocketses))
 		return false;
 	rselect = select(255, &tset, NULL, NULL, &timeval_for_select);
+	netsyscalls++;
 	if (rselect >= 1)
 		return true;
 	return false;
@@ -803,25 +1003,262 @@ static boolean SOCK_CanGet(void)
 #endif
 #endif
 
-#ifndef NONET
-static inline ssize_t SOCK_SendToAddr(SOCKET_TYPE socket, mysockaddr_t *sockaddr)
+#ifdef HAVE_NETTHREAD
+// Drains every socket into netring as soon as packets arrive, so they
+// are timestamped and out of the kernel buffer even during a long frame.
+static void SOCK_ReceiveThread(void *userdata)
 {
-	socklen_t d4 = (socklen_t)sizeof(struct sockaddr_in);
-#ifdef HAVE_IPV6
-	socklen_t d6 = (socklen_t)sizeof(struct sockaddr_in6);
+	(void)userdata;
+
+	while (__atomic_load_n(&netthreadrunning, __ATOMIC_ACQUIRE) && !I_thread_is_stopped())
+	{
+		struct timeval timeout = {0, 10000}; // check for a stop request every 10 ms
+		fd_set tset;
+		size_t n;
+
+		if (!FD_CPY(&masterset, &tset, mysockets, mysocketses))
+			break;
+		if (select(255, &tset, NULL, NULL, &timeout) < 1)
+			continue;
+
+		for (n = 0; n < mysocketses; n++)
+		{
+			for (;;)
+			{
+				const UINT32 head = netringhead;
+				netringpacket_t *packet;
+
+				// Ring full: leave the rest in the kernel buffer until the game catches up
+				if (head - __atomic_load_n(&netringtail, __ATOMIC_ACQUIRE) >= NETRINGSIZE)
+				{
+					I_Sleep(1);
+					break;
+				}
+
+				packet = &netring[head & (NETRINGSIZE - 1)];
+				packet->addrlen = (socklen_t)sizeof (packet->addr);
+				packet->length = recvfrom(mysockets[n], packet->data, MAXPACKETLENGTH, 0,
+					(void *)&packet->addr, &packet->addrlen);
+				if (packet->length == ERRSOCKET)
+					break;
+
+				packet->socket = mysockets[n];
+				packet->arrival = I_GetPreciseTime();
+				__atomic_store_n(&netringhead, head + 1, __ATOMIC_RELEASE);
+			}
+		}
+	}
+
+	__atomic_store_n(&netthreadexited, 1, __ATOMIC_RELEASE);
+}
+
+static void SOCK_StartReceiveThread(void)
+{
+	if (!netring)
+		netring = malloc(NETRINGSIZE * sizeof (*netring));
+	if (!netring)
+		return;
+
+	netringhead = netringtail = 0;
+	netthreadexited = 0;
+	__atomic_store_n(&netthreadrunning, 1, __ATOMIC_RELEASE);
+	I_spawn_thread("net-receive", SOCK_ReceiveThread, NULL);
+}
+
+static void SOCK_StopReceiveThread(void)
+{
+	if (!__atomic_load_n(&netthreadrunning, __ATOMIC_ACQUIRE))
+		return;
+
+	__atomic_store_n(&netthreadrunning, 0, __ATOMIC_RELEASE);
+	while (!__atomic_load_n(&netthreadexited, __ATOMIC_ACQUIRE))
+		I_Sleep(1);
+
+	netringhead = netringtail = 0;
+}
+
+static boolean SOCK_GetThreaded(void)
+{
+	UINT32 tail = netringtail;
+	boolean newnode;
+	INT32 result;
+
+#ifdef HAVE_MMSG
+	// Anything we were holding back should go out before we wait on replies
+	SOCK_FlushSend();
+#endif
+
+	while (tail != __atomic_load_n(&netringhead, __ATOMIC_ACQUIRE))
+	{
+		netringpacket_t *packet = &netring[tail & (NETRINGSIZE - 1)];
+
+		M_Memcpy(doomcom->data, packet->data, packet->length);
+		netpacketarrival = packet->arrival;
+		result = SOCK_IdentifyPacket(packet->length, &packet->addr, packet->addrlen, packet->socket, &newnode);
+
+		// Hand the slot back to the receive thread
+		__atomic_store_n(&netringtail, ++tail, __ATOMIC_RELEASE);
+
+		if (result > 0)
+			return newnode;
+		if (result < 0)
+			break;
+	}
+
+	doomcom->remotenode = -1; // no packet
+	return false;
+}
 #endif
-	socklen_t d, da = (socklen_t)sizeof(mysockaddr_t);
 
+#ifndef NONET
+static socklen_t SOCK_AddrLen(mysockaddr_t *sockaddr)
+{
 	switch (sockaddr->any.sa_family)
 	{
-		case AF_INET:  d = d4; break;
+		case AF_INET:  return (socklen_t)sizeof(struct sockaddr_in);
 #ifdef HAVE_IPV6
-		case AF_INET6: d = d6; break;
+		case AF_INET6: return (socklen_t)sizeof(struct sockaddr_in6);
+#endif
+		default:       return (socklen_t)sizeof(mysockaddr_t);
+	}
+}
+
+static void SOCK_SendError(INT32 node, int e)
+{
+	(void)node;
+
+	if (e != ECONNREFUSED && e != EWOULDBLOCK)
+	{
+		// DO STAR STUFF //
+		/*I_Error("SOCK_Send, error sending to node %d (%s) #%u: %s", node,
+			SOCK_GetNodeAddress(node), e, strerror(e));*/
+
+		TSoURDt3rdInfo.reachedSockSendErrorLimit++;
+
+		if (TSoURDt3rdInfo.reachedSockSendErrorLimit >= cv_socksendlimit.value)
+		{
+			PT_WillResendGamestate();
+			TSoURDt3rdInfo.reachedSockSendErrorLimit = 0;
+		}
+		NetUpdate(); // Check for new console commands and update the client
+
+		CONS_Alert(CONS_NOTICE, "SOCK_Send() - Error Prevented :)\n");
+		return;
+		// DID STAR STUFF //
+	}
+}
+
+#ifdef HAVE_MMSG
+//
+// SOCK_FlushSend
+//
+// Sends everything SOCK_Send queued up, one sendmmsg per run of packets
+// going out the same socket. Errors are only reported once the queue is
+// empty again, since reporting them can end up sending more packets.
+//
+static void SOCK_FlushSend(void)
+{
+	struct mmsghdr msgs[MMSGBATCH];
+	struct iovec iov[MMSGBATCH];
+	INT32 errnode[MMSGBATCH];
+	int errcode[MMSGBATCH];
+	size_t numerrors = 0;
+	size_t i, start, end;
+	const size_t count = sendqueuelen;
+	int c;
+
+	if (!count)
+		return;
+
+	sendblocked = false;
+
+	for (i = 0; i < count; i++)
+	{
+		iov[i].iov_base = sendqueue[i].data;
+		iov[i].iov_len = (size_t)sendqueue[i].length;
+		memset(&msgs[i], 0, sizeof (msgs[i]));
+		msgs[i].msg_hdr.msg_name = &sendqueue[i].addr;
+		msgs[i].msg_hdr.msg_namelen = sendqueue[i].addrlen;
+		msgs[i].msg_hdr.msg_iov = &iov[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+	}
+
+	for (start = 0; start < count; start = end)
+	{
+		for (end = start + 1; end < count && sendqueue[end].socket == sendqueue[start].socket; end++)
+			;
+
+		while (start < end)
+		{
+			if (usemmsg)
+				c = sendmmsg(sendqueue[start].socket, &msgs[start], (unsigned int)(end - start), 0);
+			else
+				c = (int)sendto(sendqueue[start].socket, sendqueue[start].data, sendqueue[start].length, 0,
+					&sendqueue[start].addr.any, sendqueue[start].addrlen) != ERRSOCKET;
+			netsyscalls++;
+
+			if (c > 0)
+			{
+				start += c;
+				continue;
+			}
+
+			// The packet at start failed, the rest of the run is still queued
+			if (usemmsg && errno == ENOSYS)
+			{
+				usemmsg = false; // old kernel, finish up with sendto
+				continue;
+			}
+
+			if (errno == EWOULDBLOCK
+#if EAGAIN != EWOULDBLOCK
+				|| errno == EAGAIN
 #endif
-		default:       d = da; break;
+				)
+				sendblocked = true;
+
+			if (sendqueue[start].node >= 0)
+			{
+				errnode[numerrors] = sendqueue[start].node;
+				errcode[numerrors] = errno;
+				numerrors++;
+			}
+			start++;
+		}
 	}
 
-	return sendto(socket, (char *)&doomcom->data, doomcom->datalength, 0, &sockaddr->any, d);
+	sendqueuelen = 0;
+
+	for (i = 0; i < numerrors; i++)
+		SOCK_SendError(errnode[i], errcode[i]);
+}
+#endif
+
+static inline ssize_t SOCK_SendToAddr(SOCKET_TYPE socket, mysockaddr_t *sockaddr, INT32 node)
+{
+#ifdef HAVE_MMSG
+	if (usemmsg)
+	{
+		mmsgpacket_t *packet;
+
+		while (sendqueuelen == MMSGBATCH)
+			SOCK_FlushSend();
+
+		packet = &sendqueue[sendqueuelen++];
+		M_Memcpy(packet->data, doomcom->data, doomcom->datalength);
+		packet->length = doomcom->datalength;
+		M_Memcpy(&packet->addr, sockaddr, sizeof (*sockaddr));
+		packet->addrlen = SOCK_AddrLen(sockaddr);
+		packet->socket = socket;
+		packet->node = node;
+
+		return doomcom->datalength;
+	}
+#endif
+
+	(void)node;
+	netsyscalls++;
+	return sendto(socket, (char *)&doomcom->data, doomcom->datalength, 0, &sockaddr->any, SOCK_AddrLen(sockaddr));
 }
 
 static void SOCK_Send(void)
@@ -839,7 +1276,7 @@ static void SOCK_Send(void)
 			for (j = 0; j < broadcastaddresses; j++)
 			{
 				if (myfamily[i] == broadcastaddress[j].any.sa_family)
-					SOCK_SendToAddr(mysockets[i], &broadcastaddress[j]);
+					SOCK_SendToAddr(mysockets[i], &broadcastaddress[j], -1);
 			}
 		}
 		return;
@@ -849,37 +1286,19 @@ static void SOCK_Send(void)
 		for (i = 0; i < mysocketses; i++)
 		{
 			if (myfamily[i] == clientaddress[doomcom->remotenode].any.sa_family)
-				SOCK_SendToAddr(mysockets[i], &clientaddress[doomcom->remotenode]);
+				SOCK_SendToAddr(mysockets[i], &clientaddress[doomcom->remotenode], -1);
 		}
 		return;
 	}
 	else
 	{
-		c = SOCK_SendToAddr(nodesocket[doomcom->remotenode], &clientaddress[doomcom->remotenode]);
+		c = SOCK_SendToAddr(nodesocket[doomcom->remotenode], &clientaddress[doomcom->remotenode], doomcom->remotenode);
 	}
 
 	if (c == ERRSOCKET)
 	{
 		int e = errno; // save error code so it can't be modified later
-		if (e != ECONNREFUSED && e != EWOULDBLOCK)
-		{
-			// DO STAR STUFF //
-			/*I_Error("SOCK_Send, error sending to node %d (%s) #%u: %s", doomcom->remotenode,
-				SOCK_GetNodeAddress(doomcom->remotenode), e, strerror(e));*/
-
-			TSoURDt3rdInfo.reachedSockSendErrorLimit++;
-
-			if (TSoURDt3rdInfo.reachedSockSendErrorLimit >= cv_socksendlimit.value)
-			{
-				PT_WillResendGamestate();
-				TSoURDt3rdInfo.reachedSockSendErrorLimit = 0;
-			}
-			NetUpdate(); // Check for new console commands and update the client
-
-			CONS_Alert(CONS_NOTICE, "SOCK_Send() - Error Prevented :)\n");
-			return;
-			// DID STAR STUFF //
-		}
+		SOCK_SendError(doomcom->remotenode, e);
 	}
 }
 #endif
@@ -1303,6 +1722,18 @@ boolean I_InitTcpDriver(void)
 static void SOCK_CloseSocket(void)
 {
 	size_t i;
+
+#ifdef HAVE_NETTHREAD
+	// The receive thread reads from the sockets, stop it before closing them
+	SOCK_StopReceiveThread();
+#endif
+
+#ifdef HAVE_MMSG
+	// Don't lose whatever was said last, like a server shutdown notice
+	SOCK_FlushSend();
+	recvqueuehead = recvqueuelen = 0;
+#endif
+
 	for (i=0; i < MAXNETNODES+1; i++)
 	{
 		if (mysockets[i] != (SOCKET_TYPE)ERRSOCKET
@@ -1394,6 +1825,10 @@ static boolean SOCK_OpenSocket(void)
 	I_NetFreeNodenum = SOCK_FreeNodenum;
 	I_NetMakeNodewPort = SOCK_NetMakeNodewPort;
 
+#ifdef HAVE_MMSG
+	I_NetFlush = SOCK_FlushSend;
+#endif
+
 #ifdef SELECTTEST
 	// seem like not work with libsocket : (
 	I_NetCanSend = SOCK_CanSend;
@@ -1407,7 +1842,14 @@ static boolean SOCK_OpenSocket(void)
 
 	// build the socket but close it first
 	SOCK_CloseSocket();
-	return UDP_Socket();
+	if (!UDP_Socket())
+		return false;
+
+#ifdef HAVE_NETTHREAD
+	if (M_CheckParm("-netthread"))
+		SOCK_StartReceiveThread();
+#endif
+	return true;
 #else
 	return false;
 #endif
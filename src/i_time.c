@@ -29,6 +29,7 @@ consvar_t cv_timescale = CVAR_INIT ("timescale", "1.0", CV_NETVAR|CV_CHEAT|CV_FL
 static precise_t enterprecise, oldenterprecise;
 static fixed_t entertic, oldentertics;
 static double tictimer;
+static double ticlength; // Seconds per tic at the last timescale
 
 // A little more than the minimum sleep duration on Windows.
 // May be incorrect for other platforms, but we don't currently have a way to
@@ -57,6 +58,7 @@ void I_InitializeTime(void)
 	entertic = 0;
 	oldentertics = 0;
 	tictimer = 0.0;
+	ticlength = 1.0/TICRATE;
 }
 
 void I_UpdateTime(fixed_t timescale)
@@ -67,6 +69,7 @@ void I_UpdateTime(fixed_t timescale)
 
 	// get real tics
 	ticratescaled = (double)TICRATE * FIXED_TO_FLOAT(timescale);
+	ticlength = 1.0/ticratescaled;
 
 	enterprecise = I_GetPreciseTime();
 	elapsedseconds = (double)(enterprecise - oldenterprecise) / I_GetPrecisePrecision();
@@ -89,6 +92,17 @@ void I_UpdateTime(fixed_t timescale)
 	}
 }
 
+precise_t I_GetTimeToNextTic(void)
+{
+	const UINT64 precision = I_GetPrecisePrecision();
+	const double elapsedseconds = (double)(I_GetPreciseTime() - enterprecise) / precision;
+	const double left = ticlength - tictimer - elapsedseconds;
+
+	if (left <= 0.0)
+		return 0;
+	return (precise_t)(left * precision);
+}
+
 void I_SleepDuration(precise_t duration)
 {
 	UINT64 precision = I_GetPrecisePrecision();
@@ -47,6 +47,11 @@ void I_UpdateTime(fixed_t timescale);
 */
 void I_SleepDuration(precise_t duration);
 
+/** \brief  Returns how long until the next game tic is due, as of the last
+            call to I_UpdateTime. 0 if it is already late.
+*/
+precise_t I_GetTimeToNextTic(void);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
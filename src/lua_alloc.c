@@ -0,0 +1,153 @@
+// SONIC ROBO BLAST 2
+//-----------------------------------------------------------------------------
+// Copyright (C) 2023 by Sonic Team Junior.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  lua_alloc.c
+/// \brief Size-class pool allocator for the Lua heap
+///
+///        Lua creates and frees huge numbers of tiny tables, strings and
+///        closures. Small blocks are rounded up to a multiple of
+///        LUA_POOLGRAIN and served from a free list per size, refilled by
+///        carving large chunks obtained from malloc. Lua always tells us the
+///        old size of a block, so no per-block header is needed. Chunks are
+///        never returned to the system; freed blocks are simply reused.
+
+#include "doomdef.h"
+#include "lua_alloc.h"
+
+#define LUA_POOLGRAIN 16
+#define LUA_POOLMAXSIZE 512
+#define LUA_POOLCLASSES (LUA_POOLMAXSIZE / LUA_POOLGRAIN)
+#define LUA_POOLCHUNKSIZE (64 << 10)
+
+#define SIZECLASS(size) (((size) - 1) / LUA_POOLGRAIN)
+#define CLASSSIZE(cls) (((cls) + 1) * LUA_POOLGRAIN)
+
+typedef struct poolblock_s
+{
+	struct poolblock_s *next;
+} poolblock_t;
+
+lua_allocstats_t lua_allocstats;
+
+static poolblock_t *freelists[LUA_POOLCLASSES];
+
+// Unused tail of the most recent chunk
+static UINT8 *chunkpos;
+static UINT8 *chunkend;
+
+static void LUA_PoolPut(void *ptr, size_t cls)
+{
+	poolblock_t *block = ptr;
+	block->next = freelists[cls];
+	freelists[cls] = block;
+}
+
+static void *LUA_PoolGet(size_t cls)
+{
+	const size_t size = CLASSSIZE(cls);
+	poolblock_t *block = freelists[cls];
+
+	if (block)
+	{
+		freelists[cls] = block->next;
+		return block;
+	}
+
+	if ((size_t)(chunkend - chunkpos) < size)
+	{
+		UINT8 *chunk;
+
+		// Hand whatever is left of the old chunk to a smaller free list
+		// so it isn't wasted. It is always less than LUA_POOLMAXSIZE.
+		if ((size_t)(chunkend - chunkpos) >= LUA_POOLGRAIN)
+			LUA_PoolPut(chunkpos, (size_t)(chunkend - chunkpos) / LUA_POOLGRAIN - 1);
+		chunkpos = chunkend = NULL;
+
+		chunk = malloc(LUA_POOLCHUNKSIZE);
+		if (!chunk)
+			return NULL;
+		lua_allocstats.poolsize += LUA_POOLCHUNKSIZE;
+
+		chunkpos = chunk;
+		chunkend = chunk + LUA_POOLCHUNKSIZE;
+	}
+
+	block = (poolblock_t *)chunkpos;
+	chunkpos += size;
+	return block;
+}
+
+void *LUA_Alloc(void *ud, void *ptr, size_t osize, size_t nsize)
+{
+	void *newptr;
+	(void)ud;
+
+	if (nsize == 0)
+	{
+		if (osize != 0)
+		{
+			if (osize <= LUA_POOLMAXSIZE)
+				LUA_PoolPut(ptr, SIZECLASS(osize));
+			else
+				free(ptr);
+			lua_allocstats.heapsize -= osize;
+			lua_allocstats.frees++;
+		}
+		return NULL;
+	}
+
+	if (osize == 0)
+	{
+		if (nsize <= LUA_POOLMAXSIZE)
+			newptr = LUA_PoolGet(SIZECLASS(nsize));
+		else
+			newptr = malloc(nsize);
+
+		if (newptr)
+		{
+			lua_allocstats.heapsize += nsize;
+			lua_allocstats.allocs++;
+			lua_allocstats.allocbytes += nsize;
+		}
+		return newptr;
+	}
+
+	// Resizing an existing block
+	if (osize <= LUA_POOLMAXSIZE && nsize <= LUA_POOLMAXSIZE
+		&& SIZECLASS(osize) == SIZECLASS(nsize))
+		newptr = ptr;
+	else if (osize > LUA_POOLMAXSIZE && nsize > LUA_POOLMAXSIZE)
+		newptr = realloc(ptr, nsize);
+	else
+	{
+		if (nsize <= LUA_POOLMAXSIZE)
+			newptr = LUA_PoolGet(SIZECLASS(nsize));
+		else
+			newptr = malloc(nsize);
+
+		if (newptr)
+		{
+			M_Memcpy(newptr, ptr, min(osize, nsize));
+			if (osize <= LUA_POOLMAXSIZE)
+				LUA_PoolPut(ptr, SIZECLASS(osize));
+			else
+				free(ptr);
+		}
+	}
+
+	if (newptr)
+		lua_allocstats.heapsize += nsize - osize;
+	return newptr;
+}
+
+void LUA_ResetAllocCounters(void)
+{
+	lua_allocstats.allocs = 0;
+	lua_allocstats.frees = 0;
+	lua_allocstats.allocbytes = 0;
+}
@@ -0,0 +1,36 @@
+// SONIC ROBO BLAST 2
+//-----------------------------------------------------------------------------
+// Copyright (C) 2023 by Sonic Team Junior.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  lua_alloc.h
+/// \brief Size-class pool allocator for the Lua heap
+
+#ifndef __LUA_ALLOC_H__
+#define __LUA_ALLOC_H__
+
+#include "doomtype.h"
+
+typedef struct
+{
+	size_t heapsize; // bytes currently handed out to Lua
+	size_t poolsize; // bytes reserved by pool chunks, used or not
+	UINT32 allocs; // blocks created since the last LUA_ResetAllocCounters
+	UINT32 frees; // blocks released since the last LUA_ResetAllocCounters
+	size_t allocbytes; // bytes requested by those new blocks
+} lua_allocstats_t;
+
+extern lua_allocstats_t lua_allocstats;
+
+/// lua_Alloc function used for every Lua state.
+/// Blocks up to LUA_POOLMAXSIZE bytes come from per-size free lists,
+/// anything bigger goes straight to the C allocator.
+void *LUA_Alloc(void *ud, void *ptr, size_t osize, size_t nsize);
+
+/// Clears the per-tic counters in lua_allocstats.
+void LUA_ResetAllocCounters(void);
+
+#endif
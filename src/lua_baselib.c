@@ -630,7 +630,7 @@ static int lib_pSpawnMobj(lua_State *L)
 	INLEVEL
 	if (type >= NUMMOBJTYPES)
 		return luaL_error(L, "mobj type %d out of range (0 - %d)", type, NUMMOBJTYPES-1);
-	LUA_PushUserdata(L, P_SpawnMobj(x, y, z, type), META_MOBJ);
+	LUA_PushMobj(L, P_SpawnMobj(x, y, z, type));
 	return 1;
 }
 
@@ -647,7 +647,7 @@ static int lib_pSpawnMobjFromMobj(lua_State *L)
 		return LUA_ErrInvalid(L, "mobj_t");
 	if (type >= NUMMOBJTYPES)
 		return luaL_error(L, "mobj type %d out of range (0 - %d)", type, NUMMOBJTYPES-1);
-	LUA_PushUserdata(L, P_SpawnMobjFromMobj(actor, x, y, z, type), META_MOBJ);
+	LUA_PushMobj(L, P_SpawnMobjFromMobj(actor, x, y, z, type));
 	return 1;
 }
 
@@ -714,7 +714,7 @@ static int lib_pSpawnMissile(lua_State *L)
 		return LUA_ErrInvalid(L, "mobj_t");
 	if (type >= NUMMOBJTYPES)
 		return luaL_error(L, "mobj type %d out of range (0 - %d)", type, NUMMOBJTYPES-1);
-	LUA_PushUserdata(L, P_SpawnMissile(source, dest, type), META_MOBJ);
+	LUA_PushMobj(L, P_SpawnMissile(source, dest, type));
 	return 1;
 }
 
@@ -732,7 +732,7 @@ static int lib_pSpawnXYZMissile(lua_State *L)
 		return LUA_ErrInvalid(L, "mobj_t");
 	if (type >= NUMMOBJTYPES)
 		return luaL_error(L, "mobj type %d out of range (0 - %d)", type, NUMMOBJTYPES-1);
-	LUA_PushUserdata(L, P_SpawnXYZMissile(source, dest, type, x, y, z), META_MOBJ);
+	LUA_PushMobj(L, P_SpawnXYZMissile(source, dest, type, x, y, z));
 	return 1;
 }
 
@@ -752,7 +752,7 @@ static int lib_pSpawnPointMissile(lua_State *L)
 		return LUA_ErrInvalid(L, "mobj_t");
 	if (type >= NUMMOBJTYPES)
 		return luaL_error(L, "mobj type %d out of range (0 - %d)", type, NUMMOBJTYPES-1);
-	LUA_PushUserdata(L, P_SpawnPointMissile(source, xa, ya, za, type, x, y, z), META_MOBJ);
+	LUA_PushMobj(L, P_SpawnPointMissile(source, xa, ya, za, type, x, y, z));
 	return 1;
 }
 
@@ -770,7 +770,7 @@ static int lib_pSpawnAlteredDirectionMissile(lua_State *L)
 		return LUA_ErrInvalid(L, "mobj_t");
 	if (type >= NUMMOBJTYPES)
 		return luaL_error(L, "mobj type %d out of range (0 - %d)", type, NUMMOBJTYPES-1);
-	LUA_PushUserdata(L, P_SpawnAlteredDirectionMissile(source, type, x, y, z, shiftingAngle), META_MOBJ);
+	LUA_PushMobj(L, P_SpawnAlteredDirectionMissile(source, type, x, y, z, shiftingAngle));
 	return 1;
 }
 
@@ -801,7 +801,7 @@ static int lib_pSPMAngle(lua_State *L)
 		return LUA_ErrInvalid(L, "mobj_t");
 	if (type >= NUMMOBJTYPES)
 		return luaL_error(L, "mobj type %d out of range (0 - %d)", type, NUMMOBJTYPES-1);
-	LUA_PushUserdata(L, P_SPMAngle(source, type, angle, allowaim, flags2), META_MOBJ);
+	LUA_PushMobj(L, P_SPMAngle(source, type, angle, allowaim, flags2));
 	return 1;
 }
 
@@ -816,7 +816,7 @@ static int lib_pSpawnPlayerMissile(lua_State *L)
 		return LUA_ErrInvalid(L, "mobj_t");
 	if (type >= NUMMOBJTYPES)
 		return luaL_error(L, "mobj type %d out of range (0 - %d)", type, NUMMOBJTYPES-1);
-	LUA_PushUserdata(L, P_SpawnPlayerMissile(source, type, flags2), META_MOBJ);
+	LUA_PushMobj(L, P_SpawnPlayerMissile(source, type, flags2));
 	return 1;
 }
 
@@ -872,7 +872,7 @@ static int lib_pGetClosestAxis(lua_State *L)
 	INLEVEL
 	if (!source)
 		return LUA_ErrInvalid(L, "mobj_t");
-	LUA_PushUserdata(L, P_GetClosestAxis(source), META_MOBJ);
+	LUA_PushMobj(L, P_GetClosestAxis(source));
 	return 1;
 }
 
@@ -1410,7 +1410,7 @@ static int lib_pSpawnGhostMobj(lua_State *L)
 	INLEVEL
 	if (!mobj)
 		return LUA_ErrInvalid(L, "mobj_t");
-	LUA_PushUserdata(L, P_SpawnGhostMobj(mobj), META_MOBJ);
+	LUA_PushMobj(L, P_SpawnGhostMobj(mobj));
 	return 1;
 }
 
@@ -1603,7 +1603,7 @@ static int lib_pLookForEnemies(lua_State *L)
 	INLEVEL
 	if (!player)
 		return LUA_ErrInvalid(L, "player_t");
-	LUA_PushUserdata(L, P_LookForEnemies(player, nonenemies, bullet), META_MOBJ);
+	LUA_PushMobj(L, P_LookForEnemies(player, nonenemies, bullet));
 	return 1;
 }
 
@@ -1752,7 +1752,7 @@ static int lib_pCheckPosition(lua_State *L)
 	if (!thing)
 		return LUA_ErrInvalid(L, "mobj_t");
 	lua_pushboolean(L, P_CheckPosition(thing, x, y));
-	LUA_PushUserdata(L, tmthing, META_MOBJ);
+	LUA_PushMobj(L, tmthing);
 	P_SetTarget(&tmthing, ptmthing);
 	return 2;
 }
@@ -1769,7 +1769,7 @@ static int lib_pTryMove(lua_State *L)
 	if (!thing)
 		return LUA_ErrInvalid(L, "mobj_t");
 	lua_pushboolean(L, P_TryMove(thing, x, y, allowdropoff));
-	LUA_PushUserdata(L, tmthing, META_MOBJ);
+	LUA_PushMobj(L, tmthing);
 	P_SetTarget(&tmthing, ptmthing);
 	return 2;
 }
@@ -1784,7 +1784,7 @@ static int lib_pMove(lua_State *L)
 	if (!actor)
 		return LUA_ErrInvalid(L, "mobj_t");
 	lua_pushboolean(L, P_Move(actor, speed));
-	LUA_PushUserdata(L, tmthing, META_MOBJ);
+	LUA_PushMobj(L, tmthing);
 	P_SetTarget(&tmthing, ptmthing);
 	return 2;
 }
@@ -1802,7 +1802,7 @@ static int lib_pTeleportMove(lua_State *L)
 		return LUA_ErrInvalid(L, "mobj_t");
 	LUA_Deprecated(L, "P_TeleportMove", "P_SetOrigin\" or \"P_MoveOrigin");
 	lua_pushboolean(L, P_MoveOrigin(thing, x, y, z));
-	LUA_PushUserdata(L, tmthing, META_MOBJ);
+	LUA_PushMobj(L, tmthing);
 	P_SetTarget(&tmthing, ptmthing);
 	return 2;
 }
@@ -1819,7 +1819,7 @@ static int lib_pSetOrigin(lua_State *L)
 	if (!thing)
 		return LUA_ErrInvalid(L, "mobj_t");
 	lua_pushboolean(L, P_SetOrigin(thing, x, y, z));
-	LUA_PushUserdata(L, tmthing, META_MOBJ);
+	LUA_PushMobj(L, tmthing);
 	P_SetTarget(&tmthing, ptmthing);
 	return 2;
 }
@@ -1836,7 +1836,7 @@ static int lib_pMoveOrigin(lua_State *L)
 	if (!thing)
 		return LUA_ErrInvalid(L, "mobj_t");
 	lua_pushboolean(L, P_MoveOrigin(thing, x, y, z));
-	LUA_PushUserdata(L, tmthing, META_MOBJ);
+	LUA_PushMobj(L, tmthing);
 	P_SetTarget(&tmthing, ptmthing);
 	return 2;
 }
@@ -2263,7 +2263,7 @@ static int lib_pMobjTouchingSectorSpecial(lua_State *L)
 	INLEVEL
 	if (!mo)
 		return LUA_ErrInvalid(L, "mobj_t");
-	LUA_PushUserdata(L, P_MobjTouchingSectorSpecial(mo, section, number), META_SECTOR);
+	LUA_PushSector(L, P_MobjTouchingSectorSpecial(mo, section, number));
 	return 1;
 }
 
@@ -2275,7 +2275,7 @@ static int lib_pThingOnSpecial3DFloor(lua_State *L)
 	if (!mo)
 		return LUA_ErrInvalid(L, "mobj_t");
 	LUA_Deprecated(L, "P_ThingOnSpecial3DFloor", "P_MobjTouchingSectorSpecial\" or \"P_MobjTouchingSectorSpecialFlag");
-	LUA_PushUserdata(L, P_ThingOnSpecial3DFloor(mo), META_SECTOR);
+	LUA_PushSector(L, P_ThingOnSpecial3DFloor(mo));
 	return 1;
 }
 
@@ -2287,7 +2287,7 @@ static int lib_pMobjTouchingSectorSpecialFlag(lua_State *L)
 	INLEVEL
 	if (!mo)
 		return LUA_ErrInvalid(L, "mobj_t");
-	LUA_PushUserdata(L, P_MobjTouchingSectorSpecialFlag(mo, flag), META_SECTOR);
+	LUA_PushSector(L, P_MobjTouchingSectorSpecialFlag(mo, flag));
 	return 1;
 }
 
@@ -2300,7 +2300,7 @@ static int lib_pPlayerTouchingSectorSpecial(lua_State *L)
 	INLEVEL
 	if (!player)
 		return LUA_ErrInvalid(L, "player_t");
-	LUA_PushUserdata(L, P_PlayerTouchingSectorSpecial(player, section, number), META_SECTOR);
+	LUA_PushSector(L, P_PlayerTouchingSectorSpecial(player, section, number));
 	return 1;
 }
 
@@ -2312,7 +2312,7 @@ static int lib_pPlayerTouchingSectorSpecialFlag(lua_State *L)
 	INLEVEL
 	if (!player)
 		return LUA_ErrInvalid(L, "player_t");
-	LUA_PushUserdata(L, P_PlayerTouchingSectorSpecialFlag(player, flag), META_SECTOR);
+	LUA_PushSector(L, P_PlayerTouchingSectorSpecialFlag(player, flag));
 	return 1;
 }
 
@@ -3609,7 +3609,7 @@ static int lib_gAddPlayer(lua_State *L)
 		strlcat(player_names[newplayernum], "\x84[BOT]\x80", sizeof(*player_names));
 	}
 
-	LUA_PushUserdata(L, newplayer, META_PLAYER);
+	LUA_PushPlayer(L, newplayer);
 	return 1;
 }
 
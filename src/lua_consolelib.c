@@ -74,7 +74,7 @@ void Got_Luacmd(UINT8 **cp, INT32 playernum)
 
 	lua_remove(gL, -2); // pop command info table
 
-	LUA_PushUserdata(gL, &players[playernum], META_PLAYER);
+	LUA_PushPlayer(gL, &players[playernum]);
 	for (i = 1; i < argc; i++)
 	{
 		READSTRINGN(*cp, buf, 255);
@@ -172,7 +172,7 @@ void COM_Lua_f(void)
 	I_Assert(lua_isfunction(gL, -1));
 	lua_remove(gL, -2); // pop command info table
 
-	LUA_PushUserdata(gL, &players[playernum], META_PLAYER);
+	LUA_PushPlayer(gL, &players[playernum]);
 	for (i = 1; i < COM_Argc(); i++)
 		lua_pushstring(gL, COM_Argv(i));
 	LUA_Call(gL, (int)COM_Argc(), 0, 1); // COM_Argc is 1-based, so this will cover the player we passed too.
@@ -17,11 +17,15 @@
 #include "r_skins.h"
 #include "b_bot.h"
 #include "z_zone.h"
+#include "p_local.h" // stplyr
+#include "screen.h" // vid
+#include "w_wad.h" // numwadfiles
 
 #include "lua_script.h"
 #include "lua_libs.h"
 #include "lua_hook.h"
 #include "lua_hud.h" // hud_running errors
+#include "lua_profile.h"
 
 #include "m_perfstats.h"
 #include "d_netcmd.h" // for cv_perfstats
@@ -53,8 +57,16 @@ typedef struct {
 
 static hook_t hookIds[HOOK(MAX)];
 static hook_t hudHookIds[HUD_HOOK(MAX)];
+
+// [MT_NULL] holds the generic hooks. Every other list is the complete
+// dispatch list for that type: the generic hooks followed by the
+// type-specific ones, or empty if there are no type-specific hooks.
 static hook_t mobjHookIds[NUMMOBJTYPES][MOBJ_HOOK(MAX)];
 
+// Bit per mobj type, set if any hook of that type would run. The extra
+// bit at NUMMOBJTYPES stands for hooks called without a mobj.
+static UINT8 mobjHookBits[MOBJ_HOOK(MAX)][BIT_ARRAY_SIZE(NUMMOBJTYPES + 1)];
+
 // Lua tables are used to lookup string hook ids.
 static stringhook_t stringHooks[STRING_HOOK(MAX)];
 
@@ -65,15 +77,22 @@ static int   nextid;
 // After a hook errors once, don't print the error again.
 static UINT8 * hooksErrored;
 
+// HUD hooks whose draws are saved and replayed, see LUA_HookHUD.
+static UINT8 * hooksCached;
+
 static int errorRef;
 
 static boolean mobj_hook_available(int hook_type, mobjtype_t mobj_type)
 {
-	return
-		(
-				mobjHookIds [MT_NULL] [hook_type].numHooks > 0 ||
-				(mobj_type < NUMMOBJTYPES && mobjHookIds[mobj_type][hook_type].numHooks > 0)
-		);
+	return in_bit_array(mobjHookBits[hook_type], mobj_type);
+}
+
+static const hook_t * mobj_hook_list(int hook_type, mobjtype_t mobj_type)
+{
+	if (mobj_type < NUMMOBJTYPES && mobjHookIds[mobj_type][hook_type].numHooks > 0)
+		return &mobjHookIds[mobj_type][hook_type];
+	else
+		return &mobjHookIds[MT_NULL][hook_type];
 }
 
 static int hook_in_list
@@ -164,21 +183,65 @@ static void add_hook(hook_t *map)
 	map->ids[map->numHooks++] = nextid;
 }
 
+static void insert_hook(hook_t *map, int n)
+{
+	Z_Realloc(map->ids, (map->numHooks + 1) * sizeof *map->ids,
+			PU_STATIC, &map->ids);
+	memmove(&map->ids[n + 1], &map->ids[n],
+			(map->numHooks - n) * sizeof *map->ids);
+	map->ids[n] = nextid;
+	map->numHooks++;
+}
+
 static void add_mobj_hook(lua_State *L, int hook_type)
 {
 	mobjtype_t   mobj_type = luaL_optnumber(L, 3, MT_NULL);
+	hook_t     * generic = &mobjHookIds[MT_NULL][hook_type];
+	hook_t     * map;
+	int i;
 
 	luaL_argcheck(L, mobj_type < NUMMOBJTYPES, 3, "invalid mobjtype_t");
 
-	add_hook(&mobjHookIds[mobj_type][hook_type]);
+	if (mobj_type == MT_NULL)
+	{
+		// goes after the other generic hooks in every dispatch list
+		for (i = 1; i < NUMMOBJTYPES; ++i)
+		{
+			map = &mobjHookIds[i][hook_type];
+			if (map->numHooks > 0)
+				insert_hook(map, generic->numHooks);
+		}
+		add_hook(generic);
+		memset(mobjHookBits[hook_type], 0xFF, sizeof mobjHookBits[hook_type]);
+	}
+	else
+	{
+		map = &mobjHookIds[mobj_type][hook_type];
+		if (map->numHooks == 0 && generic->numHooks > 0)
+		{
+			map->ids = Z_Malloc(generic->numHooks * sizeof *map->ids,
+					PU_STATIC, &map->ids);
+			M_Memcpy(map->ids, generic->ids, generic->numHooks * sizeof *map->ids);
+			map->numHooks = generic->numHooks;
+		}
+		add_hook(map);
+		set_bit_array(mobjHookBits[hook_type], mobj_type);
+	}
 }
 
 static void add_hud_hook(lua_State *L, int idx)
 {
-	add_hook(&hudHookIds[luaL_checkoption(L,
+	add_hook(&hudHookIds[Lua_checkoption(L,
 				idx, "game", hudHookNames)]);
 }
 
+/* call after add_hook_ref */
+static void set_hud_hook_cached(lua_State *L, int idx)
+{
+	if (lua_toboolean(L, idx))
+		set_bit_array(hooksCached, nextid - 1);
+}
+
 static void add_hook_ref(lua_State *L, int idx)
 {
 	if (!(nextid & 7))
@@ -187,6 +250,11 @@ static void add_hook_ref(lua_State *L, int idx)
 				BIT_ARRAY_SIZE (nextid + 1) * sizeof *hooksErrored,
 				PU_STATIC, &hooksErrored);
 		hooksErrored[nextid >> 3] = 0;
+
+		Z_Realloc(hooksCached,
+				BIT_ARRAY_SIZE (nextid + 1) * sizeof *hooksCached,
+				PU_STATIC, &hooksCached);
+		hooksCached[nextid >> 3] = 0;
 	}
 
 	Z_Realloc(hookRefs, (nextid + 1) * sizeof *hookRefs, PU_STATIC, &hookRefs);
@@ -224,6 +292,9 @@ static int lib_addHook(lua_State *L)
 	else if (strcmp(name, "HUD") == 0)
 	{
 		add_hud_hook(L, 3);
+		add_hook_ref(L, 2);
+		set_hud_hook_cached(L, 4);
+		return 0;
 	}
 	else
 	{
@@ -256,6 +327,7 @@ int lib_hudadd(lua_State *L)
 
 	add_hud_hook(L, 2);
 	add_hook_ref(L, 1);
+	set_hud_hook_cached(L, 3);
 
 	return 0;
 }
@@ -269,6 +341,7 @@ struct Hook_State {
 	int          hook_type;
 	mobjtype_t   mobj_type;/* >0 if mobj hook */
 	const char * string;/* used to fetch table, ran first if set */
+	const char * name;/* hook name, for the profiler */
 	int          top;/* index of last argument passed to hook */
 	int          id;/* id to fetch ref */
 	int          values;/* num arguments passed to hook */
@@ -321,6 +394,9 @@ static boolean init_hook_type
 		hook->hook_type = hook_type;
 		hook->mobj_type = mobj_type;
 		hook->string = string;
+		hook->name = string ? stringHookNames[hook_type]
+			: mobj_type ? mobjHookNames[hook_type]
+			: hookNames[hook_type];
 		return begin_hook_values(hook);
 	}
 	else
@@ -404,7 +480,18 @@ static void get_hook_from_table(Hook_State *hook, int n)
 
 static int call_single_hook_no_copy(Hook_State *hook)
 {
-	if (lua_pcall(gL, hook->values, hook->results, EINDEX) == 0)
+	int error;
+
+	if (lua_profiling)
+	{
+		LUA_ProfileEnter(hook->name, -(hook->values) - 1);
+		error = lua_pcall(gL, hook->values, hook->results, EINDEX);
+		LUA_ProfileLeave();
+	}
+	else
+		error = lua_pcall(gL, hook->values, hook->results, EINDEX);
+
+	if (error == 0)
 	{
 		if (hook->results > 0)
 		{
@@ -467,6 +554,29 @@ static int call_mapped(Hook_State *hook, const hook_t *map)
 	return map->numHooks;
 }
 
+/* same as call_mapped, but the last hook is handed the original
+   arguments instead of a copy, so they are gone afterwards */
+static int call_mapped_consume(Hook_State *hook, const hook_t *map)
+{
+	const int last = map->numHooks - 1;
+	int k;
+
+	for (k = 0; k < last; ++k)
+	{
+		get_hook(hook, map->ids, k);
+		call_single_hook(hook);
+	}
+
+	if (last >= 0)
+	{
+		get_hook(hook, map->ids, last);
+		lua_insert(gL, hook->top - hook->values + 1);
+		call_single_hook_no_copy(hook);
+	}
+
+	return map->numHooks;
+}
+
 static int call_string_hooks(Hook_State *hook)
 {
 	const stringhook_t *map = &stringHooks[hook->hook_type];
@@ -485,11 +595,6 @@ static int call_string_hooks(Hook_State *hook)
 	return calls;
 }
 
-static int call_mobj_type_hooks(Hook_State *hook, mobjtype_t mobj_type)
-{
-	return call_mapped(hook, &mobjHookIds[mobj_type][hook->hook_type]);
-}
-
 static int call_hooks
 (
 		Hook_State * hook,
@@ -506,11 +611,9 @@ static int call_hooks
 	}
 	else if (hook->mobj_type > 0)
 	{
-		/* call generic mobj hooks first */
-		calls += call_mobj_type_hooks(hook, MT_NULL);
-
-		if (hook->mobj_type < NUMMOBJTYPES)
-			calls += call_mobj_type_hooks(hook, hook->mobj_type);
+		/* generic mobj hooks come first in the list */
+		calls += call_mapped_consume(hook,
+				mobj_hook_list(hook->hook_type, hook->mobj_type));
 
 		ps_lua_mobjhooks.value.i += calls;
 	}
@@ -560,7 +663,7 @@ int LUA_HookMobj(mobj_t *mobj, int hook_type)
 	Hook_State hook;
 	if (prepare_mobj_hook(&hook, false, hook_type, mobj))
 	{
-		LUA_PushUserdata(gL, mobj, META_MOBJ);
+		LUA_PushMobj(gL, mobj);
 		call_hooks(&hook, 1, res_true);
 	}
 	return hook.status;
@@ -571,8 +674,8 @@ int LUA_Hook2Mobj(mobj_t *t1, mobj_t *t2, int hook_type)
 	Hook_State hook;
 	if (prepare_mobj_hook(&hook, 0, hook_type, t1))
 	{
-		LUA_PushUserdata(gL, t1, META_MOBJ);
-		LUA_PushUserdata(gL, t2, META_MOBJ);
+		LUA_PushMobj(gL, t1);
+		LUA_PushMobj(gL, t2);
 		call_hooks(&hook, 1, res_force);
 	}
 	return hook.status;
@@ -610,7 +713,7 @@ int LUA_HookPlayer(player_t *player, int hook_type)
 	Hook_State hook;
 	if (prepare_hook(&hook, false, hook_type))
 	{
-		LUA_PushUserdata(gL, player, META_PLAYER);
+		LUA_PushPlayer(gL, player);
 		call_hooks(&hook, 1, res_true);
 	}
 	return hook.status;
@@ -621,7 +724,7 @@ int LUA_HookTiccmd(player_t *player, ticcmd_t *cmd, int hook_type)
 	Hook_State hook;
 	if (prepare_hook(&hook, false, hook_type))
 	{
-		LUA_PushUserdata(gL, player, META_PLAYER);
+		LUA_PushPlayer(gL, player);
 		LUA_PushUserdata(gL, cmd, META_TICCMD);
 
 		if (hook_type == HOOK(PlayerCmd))
@@ -646,20 +749,59 @@ int LUA_HookKey(event_t *event, int hook_type)
 	return hook.status;
 }
 
+static void get_hud_key(huddrawkey_t *key)
+{
+	memset(key, 0, sizeof *key);
+	key->refresh = hud_refreshcount;
+	key->width = vid.width;
+	key->height = vid.height;
+	key->splitscreen = splitscreen;
+	key->player = stplyr ? (INT32)(stplyr - players) : -1;
+	key->gamestate = gamestate;
+	key->gamemap = gamemap;
+	key->numwadfiles = numwadfiles;
+}
+
+/* Hooks added with the cache flag promise that what they draw only
+   changes with the things in huddrawkey_t, or after hud.refresh().
+   Their draws are saved and replayed until then, without calling
+   them at all. */
 void LUA_HookHUD(int hook_type, huddrawlist_h list)
 {
 	const hook_t * map = &hudHookIds[hook_type];
 	Hook_State hook;
+	huddrawkey_t key;
+	int k;
 	if (map->numHooks > 0)
 	{
 		start_hook_stack();
 		begin_hook_values(&hook);
+		hook.name = hudHookNames[hook_type];
 
 		LUA_SetHudHook(hook_type, list);
+		get_hud_key(&key);
 
 		hud_running = true; // local hook
 		init_hook_call(&hook, 0, res_none);
-		call_mapped(&hook, map);
+		for (k = 0; k < map->numHooks; ++k)
+		{
+			const int id = map->ids[k];
+			const boolean cached = LUA_HUD_IsDrawListValid(list) && in_bit_array(hooksCached, id);
+
+			if (cached)
+			{
+				if (LUA_HUD_ReplayCachedDraws(list, id, &key))
+					continue;
+				LUA_HUD_BeginCachedDraws(list);
+			}
+
+			get_hook(&hook, map->ids, k);
+			call_single_hook(&hook);
+
+			// keep running it every tic if it errors
+			if (cached && !in_bit_array(hooksErrored, id))
+				LUA_HUD_EndCachedDraws(list, id, &key);
+		}
 		hud_running = false;
 
 		lua_pushnil(gL);
@@ -719,7 +861,7 @@ int LUA_HookMobjLineCollide(mobj_t *mobj, line_t *line)
 	Hook_State hook;
 	if (prepare_mobj_hook(&hook, 0, MOBJ_HOOK(MobjLineCollide), mobj))
 	{
-		LUA_PushUserdata(gL, mobj, META_MOBJ);
+		LUA_PushMobj(gL, mobj);
 		LUA_PushUserdata(gL, line, META_LINE);
 		call_hooks(&hook, 1, res_force);
 	}
@@ -731,8 +873,8 @@ int LUA_HookTouchSpecial(mobj_t *special, mobj_t *toucher)
 	Hook_State hook;
 	if (prepare_mobj_hook(&hook, false, MOBJ_HOOK(TouchSpecial), special))
 	{
-		LUA_PushUserdata(gL, special, META_MOBJ);
-		LUA_PushUserdata(gL, toucher, META_MOBJ);
+		LUA_PushMobj(gL, special);
+		LUA_PushMobj(gL, toucher);
 		call_hooks(&hook, 1, res_true);
 	}
 	return hook.status;
@@ -751,9 +893,9 @@ static int damage_hook
 	Hook_State hook;
 	if (prepare_mobj_hook(&hook, 0, hook_type, target))
 	{
-		LUA_PushUserdata(gL, target, META_MOBJ);
-		LUA_PushUserdata(gL, inflictor, META_MOBJ);
-		LUA_PushUserdata(gL, source, META_MOBJ);
+		LUA_PushMobj(gL, target);
+		LUA_PushMobj(gL, inflictor);
+		LUA_PushMobj(gL, source);
 		if (hook_type != MOBJ_HOOK(MobjDeath))
 			lua_pushinteger(gL, damage);
 		lua_pushinteger(gL, damagetype);
@@ -785,8 +927,8 @@ int LUA_HookMobjMoveBlocked(mobj_t *t1, mobj_t *t2, line_t *line)
 	Hook_State hook;
 	if (prepare_mobj_hook(&hook, 0, MOBJ_HOOK(MobjMoveBlocked), t1))
 	{
-		LUA_PushUserdata(gL, t1, META_MOBJ);
-		LUA_PushUserdata(gL, t2, META_MOBJ);
+		LUA_PushMobj(gL, t1);
+		LUA_PushMobj(gL, t2);
 		LUA_PushUserdata(gL, line, META_LINE);
 		call_hooks(&hook, 1, res_true);
 	}
@@ -855,8 +997,8 @@ int LUA_HookBotAI(mobj_t *sonic, mobj_t *tails, ticcmd_t *cmd)
 
 	if (prepare_string_hook(&hook, false, STRING_HOOK(BotAI), skin))
 	{
-		LUA_PushUserdata(gL, sonic, META_MOBJ);
-		LUA_PushUserdata(gL, tails, META_MOBJ);
+		LUA_PushMobj(gL, sonic);
+		LUA_PushMobj(gL, tails);
 
 		botai.tails = tails;
 		botai.cmd   = cmd;
@@ -876,8 +1018,8 @@ void LUA_HookLinedefExecute(line_t *line, mobj_t *mo, sector_t *sector)
 			(&hook, 0, STRING_HOOK(LinedefExecute), line->stringargs[0]))
 	{
 		LUA_PushUserdata(gL, line, META_LINE);
-		LUA_PushUserdata(gL, mo, META_MOBJ);
-		LUA_PushUserdata(gL, sector, META_SECTOR);
+		LUA_PushMobj(gL, mo);
+		LUA_PushSector(gL, sector);
 		ps_lua_mobjhooks.value.i += call_hooks(&hook, 0, res_none);
 	}
 }
@@ -887,7 +1029,7 @@ int LUA_HookPlayerMsg(int source, int target, int flags, char *msg)
 	Hook_State hook;
 	if (prepare_hook(&hook, false, HOOK(PlayerMsg)))
 	{
-		LUA_PushUserdata(gL, &players[source], META_PLAYER); // Source player
+		LUA_PushPlayer(gL, &players[source]); // Source player
 		if (flags & 2 /*HU_CSAY*/) { // csay TODO: make HU_CSAY accessible outside hu_stuff.c
 			lua_pushinteger(gL, 3); // type
 			lua_pushnil(gL); // target
@@ -899,7 +1041,7 @@ int LUA_HookPlayerMsg(int source, int target, int flags, char *msg)
 			lua_pushnil(gL); // target
 		} else { // sayto
 			lua_pushinteger(gL, 2); // type
-			LUA_PushUserdata(gL, &players[target-1], META_PLAYER); // target
+			LUA_PushPlayer(gL, &players[target-1]); // target
 		}
 		lua_pushstring(gL, msg); // msg
 		call_hooks(&hook, 1, res_true);
@@ -912,9 +1054,9 @@ int LUA_HookHurtMsg(player_t *player, mobj_t *inflictor, mobj_t *source, UINT8 d
 	Hook_State hook;
 	if (prepare_mobj_hook(&hook, false, MOBJ_HOOK(HurtMsg), inflictor))
 	{
-		LUA_PushUserdata(gL, player, META_PLAYER);
-		LUA_PushUserdata(gL, inflictor, META_MOBJ);
-		LUA_PushUserdata(gL, source, META_MOBJ);
+		LUA_PushPlayer(gL, player);
+		LUA_PushMobj(gL, inflictor);
+		LUA_PushMobj(gL, source);
 		lua_pushinteger(gL, damagetype);
 		call_hooks(&hook, 1, res_true);
 	}
@@ -936,6 +1078,7 @@ void LUA_HookNetArchive(lua_CFunction archFunc)
 		lua_insert(gL, EINDEX);
 
 		begin_hook_values(&hook);
+		hook.name = hookNames[HOOK(NetVars)];
 
 		// tables becomes an upvalue of archFunc
 		lua_pushvalue(gL, -1);
@@ -956,7 +1099,7 @@ int LUA_HookMapThingSpawn(mobj_t *mobj, mapthing_t *mthing)
 	Hook_State hook;
 	if (prepare_mobj_hook(&hook, false, MOBJ_HOOK(MapThingSpawn), mobj))
 	{
-		LUA_PushUserdata(gL, mobj, META_MOBJ);
+		LUA_PushMobj(gL, mobj);
 		LUA_PushUserdata(gL, mthing, META_MAPTHING);
 		call_hooks(&hook, 1, res_true);
 	}
@@ -968,8 +1111,8 @@ int LUA_HookFollowMobj(player_t *player, mobj_t *mobj)
 	Hook_State hook;
 	if (prepare_mobj_hook(&hook, false, MOBJ_HOOK(FollowMobj), mobj))
 	{
-		LUA_PushUserdata(gL, player, META_PLAYER);
-		LUA_PushUserdata(gL, mobj, META_MOBJ);
+		LUA_PushPlayer(gL, player);
+		LUA_PushMobj(gL, mobj);
 		call_hooks(&hook, 1, res_true);
 	}
 	return hook.status;
@@ -980,8 +1123,8 @@ int LUA_HookPlayerCanDamage(player_t *player, mobj_t *mobj)
 	Hook_State hook;
 	if (prepare_hook(&hook, 0, HOOK(PlayerCanDamage)))
 	{
-		LUA_PushUserdata(gL, player, META_PLAYER);
-		LUA_PushUserdata(gL, mobj, META_MOBJ);
+		LUA_PushPlayer(gL, player);
+		LUA_PushMobj(gL, mobj);
 		call_hooks(&hook, 1, res_force);
 	}
 	return hook.status;
@@ -992,7 +1135,7 @@ void LUA_HookPlayerQuit(player_t *plr, kickreason_t reason)
 	Hook_State hook;
 	if (prepare_hook(&hook, 0, HOOK(PlayerQuit)))
 	{
-		LUA_PushUserdata(gL, plr, META_PLAYER); // Player that quit
+		LUA_PushPlayer(gL, plr); // Player that quit
 		lua_pushinteger(gL, reason); // Reason for quitting
 		call_hooks(&hook, 0, res_none);
 	}
@@ -1003,7 +1146,7 @@ int LUA_HookTeamSwitch(player_t *player, int newteam, boolean fromspectators, bo
 	Hook_State hook;
 	if (prepare_hook(&hook, true, HOOK(TeamSwitch)))
 	{
-		LUA_PushUserdata(gL, player, META_PLAYER);
+		LUA_PushPlayer(gL, player);
 		lua_pushinteger(gL, newteam);
 		lua_pushboolean(gL, fromspectators);
 		lua_pushboolean(gL, tryingautobalance);
@@ -1018,8 +1161,8 @@ int LUA_HookViewpointSwitch(player_t *player, player_t *newdisplayplayer, boolea
 	Hook_State hook;
 	if (prepare_hook(&hook, 0, HOOK(ViewpointSwitch)))
 	{
-		LUA_PushUserdata(gL, player, META_PLAYER);
-		LUA_PushUserdata(gL, newdisplayplayer, META_PLAYER);
+		LUA_PushPlayer(gL, player);
+		LUA_PushPlayer(gL, newdisplayplayer);
 		lua_pushboolean(gL, forced);
 
 		hud_running = true; // local hook
@@ -1034,8 +1177,8 @@ int LUA_HookSeenPlayer(player_t *player, player_t *seenfriend)
 	Hook_State hook;
 	if (prepare_hook(&hook, true, HOOK(SeenPlayer)))
 	{
-		LUA_PushUserdata(gL, player, META_PLAYER);
-		LUA_PushUserdata(gL, seenfriend, META_PLAYER);
+		LUA_PushPlayer(gL, player);
+		LUA_PushPlayer(gL, seenfriend);
 
 		hud_running = true; // local hook
 		call_hooks(&hook, 1, res_false);
@@ -1050,7 +1193,7 @@ int LUA_HookShouldJingleContinue(player_t *player, const char *musname)
 	if (prepare_string_hook
 			(&hook, false, STRING_HOOK(ShouldJingleContinue), musname))
 	{
-		LUA_PushUserdata(gL, player, META_PLAYER);
+		LUA_PushPlayer(gL, player);
 		push_string();
 
 		hud_running = true; // local hook
@@ -1166,7 +1309,7 @@ fixed_t LUA_HookPlayerHeight(player_t *player)
 	Hook_State hook;
 	if (prepare_hook(&hook, -1, HOOK(PlayerHeight)))
 	{
-		LUA_PushUserdata(gL, player, META_PLAYER);
+		LUA_PushPlayer(gL, player);
 		call_hooks(&hook, 1, res_playerheight);
 	}
 	return hook.status;
@@ -1177,7 +1320,7 @@ int LUA_HookPlayerCanEnterSpinGaps(player_t *player)
 	Hook_State hook;
 	if (prepare_hook(&hook, 0, HOOK(PlayerCanEnterSpinGaps)))
 	{
-		LUA_PushUserdata(gL, player, META_PLAYER);
+		LUA_PushPlayer(gL, player);
 		call_hooks(&hook, 1, res_force);
 	}
 	return hook.status;
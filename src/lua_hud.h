@@ -49,6 +49,7 @@ enum hud {
 };
 
 extern boolean hud_running;
+extern UINT32 hud_refreshcount;
 
 boolean LUA_HudEnabled(enum hud option);
 
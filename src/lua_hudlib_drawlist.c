@@ -55,13 +55,26 @@ typedef struct drawitem_s {
 	fixed_t sy;
 	INT32 num;
 	INT32 digits;
-	const char *str;
+	size_t str; // offset into the list's strbuf
 	UINT16 color;
 	UINT8 strength;
 	INT32 align;
 } drawitem_t;
 
+// Draws saved by a cached hook, with its strings
+typedef struct drawcache_s {
+	INT32 id;
+	huddrawkey_t key;
+	drawitem_t *items;
+	size_t items_len;
+	char *strbuf;
+	size_t strbuf_len;
+} drawcache_t;
+
 // The internal structure of a drawlist.
+// Items and strings are kept in flat buffers that are emptied, not
+// freed, between tics. Strings are referred to by offset, so growing
+// the string buffer doesn't leave items pointing at the old one.
 struct huddrawlist_s {
 	drawitem_t *items;
 	size_t items_capacity;
@@ -69,6 +82,10 @@ struct huddrawlist_s {
 	char *strbuf;
 	size_t strbuf_capacity;
 	size_t strbuf_len;
+	size_t mark_items; // start of the cached hook being recorded
+	size_t mark_strbuf;
+	drawcache_t *caches;
+	size_t caches_len;
 };
 
 // alignment types for v.drawString
@@ -110,6 +127,10 @@ huddrawlist_h LUA_HUD_CreateDrawList(void)
 	drawlist->strbuf = NULL;
 	drawlist->strbuf_capacity = 0;
 	drawlist->strbuf_len = 0;
+	drawlist->mark_items = 0;
+	drawlist->mark_strbuf = 0;
+	drawlist->caches = NULL;
+	drawlist->caches_len = 0;
 
 	return drawlist;
 }
@@ -118,30 +139,42 @@ void LUA_HUD_ClearDrawList(huddrawlist_h list)
 {
 	// rather than deallocate, we'll just save the existing allocation and empty
 	// it out for reuse
-
-	// this memset probably isn't necessary
-	if (list->items)
-	{
-		memset(list->items, 0, sizeof(drawitem_t) * list->items_capacity);
-	}
-
 	list->items_len = 0;
+	list->mark_items = 0;
 
 	if (list->strbuf)
 	{
 		list->strbuf[0] = 0;
 	}
 	list->strbuf_len = 0;
+	list->mark_strbuf = 0;
 }
 
 void LUA_HUD_DestroyDrawList(huddrawlist_h list)
 {
+	size_t i;
+
 	if (list == NULL) return;
 
 	if (list->items)
 	{
 		Z_Free(list->items);
 	}
+	if (list->strbuf)
+	{
+		Z_Free(list->strbuf);
+	}
+	for (i = 0; i < list->caches_len; i++)
+	{
+		if (list->caches[i].items)
+			Z_Free(list->caches[i].items);
+		if (list->caches[i].strbuf)
+			Z_Free(list->caches[i].strbuf);
+	}
+	if (list->caches)
+	{
+		Z_Free(list->caches);
+	}
 	Z_Free(list);
 }
 
@@ -153,36 +186,78 @@ boolean LUA_HUD_IsDrawListValid(huddrawlist_h list)
 	return true;
 }
 
+static void ReserveDrawItems(huddrawlist_h list, size_t count)
+{
+	if (list->items_capacity >= list->items_len + count)
+		return;
+
+	if (list->items_capacity == 0) list->items_capacity = 128;
+	while (list->items_capacity < list->items_len + count)
+		list->items_capacity *= 2;
+	list->items = (drawitem_t *) Z_ReallocAlign(list->items, sizeof(struct drawitem_s) * list->items_capacity, PU_STATIC, NULL, 64);
+}
+
+static void ReserveStrings(huddrawlist_h list, size_t count)
+{
+	if (list->strbuf_capacity >= list->strbuf_len + count)
+		return;
+
+	if (list->strbuf_capacity == 0) list->strbuf_capacity = 256;
+	while (list->strbuf_capacity < list->strbuf_len + count)
+		list->strbuf_capacity *= 2;
+	list->strbuf = (char*) Z_ReallocAlign(list->strbuf, sizeof(char) * list->strbuf_capacity, PU_STATIC, NULL, 8);
+}
+
 static size_t AllocateDrawItem(huddrawlist_h list)
 {
 	if (!list) I_Error("can't allocate draw item: invalid list");
-	if (list->items_capacity <= list->items_len + 1)
-	{
-		if (list->items_capacity == 0) list->items_capacity = 128;
-		else list->items_capacity *= 2;
-		list->items = (drawitem_t *) Z_ReallocAlign(list->items, sizeof(struct drawitem_s) * list->items_capacity, PU_STATIC, NULL, 64);
-	}
+	ReserveDrawItems(list, 1);
+	memset(&list->items[list->items_len], 0, sizeof(drawitem_t));
 
 	return list->items_len++;
 }
 
+// Drawing the same opaque patch at the same spot twice in a row just
+// paints the same pixels again, so the second draw is dropped.
+// Translucent draws would blend twice, so those are always kept.
+static void CoalescePatchDraw(huddrawlist_h list)
+{
+	const drawitem_t *item, *prev;
+
+	// never look past the start of a cached hook's draws
+	if (list->items_len < list->mark_items + 2)
+		return;
+
+	item = &list->items[list->items_len - 1];
+	prev = &list->items[list->items_len - 2];
+
+	if (item->flags & (V_ALPHAMASK|V_BLENDMASK))
+		return;
+
+	if (item->type == prev->type
+		&& item->patch == prev->patch
+		&& item->colormap == prev->colormap
+		&& item->flags == prev->flags
+		&& item->x == prev->x && item->y == prev->y
+		&& item->scale == prev->scale
+		&& item->hscale == prev->hscale && item->vscale == prev->vscale
+		&& item->sx == prev->sx && item->sy == prev->sy
+		&& item->w == prev->w && item->h == prev->h)
+		list->items_len--;
+}
+
 // copy string to list's internal string buffer
 // lua can deallocate the string before we get to use it, so it's important to
 // keep our own copy
-static const char *CopyString(huddrawlist_h list, const char* str)
+static size_t CopyString(huddrawlist_h list, const char* str)
 {
-	size_t lenstr;
+	size_t lenstr, result;
 
 	if (!list) I_Error("can't allocate string; invalid list");
 	lenstr = strlen(str);
-	if (list->strbuf_capacity <= list->strbuf_len + lenstr + 1)
-	{
-		if (list->strbuf_capacity == 0) list->strbuf_capacity = 256;
-		else list->strbuf_capacity *= 2;
-		list->strbuf = (char*) Z_ReallocAlign(list->strbuf, sizeof(char) * list->strbuf_capacity, PU_STATIC, NULL, 8);
-	}
-	const char *result = (const char *) &list->strbuf[list->strbuf_len];
-	strncpy(&list->strbuf[list->strbuf_len], str, lenstr + 1);
+	ReserveStrings(list, lenstr + 1);
+	result = list->strbuf_len;
+	memcpy(&list->strbuf[list->strbuf_len], str, lenstr + 1);
 	list->strbuf_len += lenstr + 1;
 	return result;
 }
@@ -204,6 +279,7 @@ void LUA_HUD_AddDraw(
 	item->patch = patch;
 	item->flags = flags;
 	item->colormap = colormap;
+	CoalescePatchDraw(list);
 }
 
 void LUA_HUD_AddDrawScaled(
@@ -225,6 +301,7 @@ void LUA_HUD_AddDrawScaled(
 	item->patch = patch;
 	item->flags = flags;
 	item->colormap = colormap;
+	CoalescePatchDraw(list);
 }
 
 void LUA_HUD_AddDrawStretched(
@@ -248,6 +325,7 @@ void LUA_HUD_AddDrawStretched(
 	item->patch = patch;
 	item->flags = flags;
 	item->colormap = colormap;
+	CoalescePatchDraw(list);
 }
 
 void LUA_HUD_AddDrawCropped(
@@ -279,6 +357,7 @@ void LUA_HUD_AddDrawCropped(
 	item->sy = sy;
 	item->w = w;
 	item->h = h;
+	CoalescePatchDraw(list);
 }
 
 void LUA_HUD_AddDrawNum(
@@ -448,6 +527,7 @@ void LUA_HUD_DrawList(huddrawlist_h list)
 	for (i = 0; i < list->items_len; i++)
 	{
 		drawitem_t *item = &list->items[i];
+		const char *str = list->strbuf ? &list->strbuf[item->str] : NULL;
 
 		switch (item->type)
 		{
@@ -477,89 +557,89 @@ void LUA_HUD_DrawList(huddrawlist_h list)
 				{
 				// hu_font
 				case align_left:
-					V_DrawString(item->x, item->y, item->flags, item->str);
+					V_DrawString(item->x, item->y, item->flags, str);
 					break;
 				case align_center:
-					V_DrawCenteredString(item->x, item->y, item->flags, item->str);
+					V_DrawCenteredString(item->x, item->y, item->flags, str);
 					break;
 				case align_right:
-					V_DrawRightAlignedString(item->x, item->y, item->flags, item->str);
+					V_DrawRightAlignedString(item->x, item->y, item->flags, str);
 					break;
 				case align_fixed:
-					V_DrawStringAtFixed(item->x, item->y, item->flags, item->str);
+					V_DrawStringAtFixed(item->x, item->y, item->flags, str);
 					break;
 				case align_fixedcenter:
-					V_DrawCenteredStringAtFixed(item->x, item->y, item->flags, item->str);
+					V_DrawCenteredStringAtFixed(item->x, item->y, item->flags, str);
 					break;
 				case align_fixedright:
-					V_DrawRightAlignedStringAtFixed(item->x, item->y, item->flags, item->str);
+					V_DrawRightAlignedStringAtFixed(item->x, item->y, item->flags, str);
 					break;
 				// hu_font, 0.5x scale
 				case align_small:
-					V_DrawSmallString(item->x, item->y, item->flags, item->str);
+					V_DrawSmallString(item->x, item->y, item->flags, str);
 					break;
 				case align_smallfixed:
-					V_DrawSmallStringAtFixed(item->x, item->y, item->flags, item->str);
+					V_DrawSmallStringAtFixed(item->x, item->y, item->flags, str);
 					break;
 				case align_smallfixedcenter:
-					V_DrawCenteredSmallStringAtFixed(item->x, item->y, item->flags, item->str);
+					V_DrawCenteredSmallStringAtFixed(item->x, item->y, item->flags, str);
 					break;
 				case align_smallfixedright:
-					V_DrawRightAlignedSmallStringAtFixed(item->x, item->y, item->flags, item->str);
+					V_DrawRightAlignedSmallStringAtFixed(item->x, item->y, item->flags, str);
 					break;
 				case align_smallcenter:
-					V_DrawCenteredSmallString(item->x, item->y, item->flags, item->str);
+					V_DrawCenteredSmallString(item->x, item->y, item->flags, str);
 					break;
 				case align_smallright:
-					V_DrawRightAlignedSmallString(item->x, item->y, item->flags, item->str);
+					V_DrawRightAlignedSmallString(item->x, item->y, item->flags, str);
 					break;
 				case align_smallthin:
-					V_DrawSmallThinString(item->x, item->y, item->flags, item->str);
+					V_DrawSmallThinString(item->x, item->y, item->flags, str);
 					break;
 				case align_smallthincenter:
-					V_DrawCenteredSmallThinString(item->x, item->y, item->flags, item->str);
+					V_DrawCenteredSmallThinString(item->x, item->y, item->flags, str);
 					break;
 				case align_smallthinright:
-					V_DrawRightAlignedSmallThinString(item->x, item->y, item->flags, item->str);
+					V_DrawRightAlignedSmallThinString(item->x, item->y, item->flags, str);
 					break;
 				case align_smallthinfixed:
-					V_DrawSmallThinStringAtFixed(item->x, item->y, item->flags, item->str);
+					V_DrawSmallThinStringAtFixed(item->x, item->y, item->flags, str);
 					break;
 				case align_smallthinfixedcenter:
-					V_DrawCenteredSmallThinStringAtFixed(item->x, item->y, item->flags, item->str);
+					V_DrawCenteredSmallThinStringAtFixed(item->x, item->y, item->flags, str);
 					break;
 				case align_smallthinfixedright:
-					V_DrawRightAlignedSmallThinStringAtFixed(item->x, item->y, item->flags, item->str);
+					V_DrawRightAlignedSmallThinStringAtFixed(item->x, item->y, item->flags, str);
 					break;
 				// tny_font
 				case align_thin:
-					V_DrawThinString(item->x, item->y, item->flags, item->str);
+					V_DrawThinString(item->x, item->y, item->flags, str);
 					break;
 				case align_thincenter:
-					V_DrawCenteredThinString(item->x, item->y, item->flags, item->str);
+					V_DrawCenteredThinString(item->x, item->y, item->flags, str);
 					break;
 				case align_thinright:
-					V_DrawRightAlignedThinString(item->x, item->y, item->flags, item->str);
+					V_DrawRightAlignedThinString(item->x, item->y, item->flags, str);
 					break;
 				case align_thinfixed:
-					V_DrawThinStringAtFixed(item->x, item->y, item->flags, item->str);
+					V_DrawThinStringAtFixed(item->x, item->y, item->flags, str);
 					break;
 				case align_thinfixedcenter:
-					V_DrawCenteredThinStringAtFixed(item->x, item->y, item->flags, item->str);
+					V_DrawCenteredThinStringAtFixed(item->x, item->y, item->flags, str);
 					break;
 				case align_thinfixedright:
-					V_DrawRightAlignedThinStringAtFixed(item->x, item->y, item->flags, item->str);
+					V_DrawRightAlignedThinStringAtFixed(item->x, item->y, item->flags, str);
 					break;
 				}
 				break;
 			case DI_DrawNameTag:
-				V_DrawNameTag(item->x, item->y, item->flags, FRACUNIT, item->basecolormap, item->outlinecolormap, item->str);
+				V_DrawNameTag(item->x, item->y, item->flags, FRACUNIT, item->basecolormap, item->outlinecolormap, str);
 				break;
 			case DI_DrawScaledNameTag:
-				V_DrawNameTag(FixedInt(item->x), FixedInt(item->y), item->flags, item->scale, item->basecolormap, item->outlinecolormap, item->str);
+				V_DrawNameTag(FixedInt(item->x), FixedInt(item->y), item->flags, item->scale, item->basecolormap, item->outlinecolormap, str);
 				break;
 			case DI_DrawLevelTitle:
-				V_DrawLevelTitle(item->x, item->y, item->flags, item->str);
+				V_DrawLevelTitle(item->x, item->y, item->flags, str);
 				break;
 			case DI_FadeScreen:
 				V_DrawFadeScreen(item->color, item->strength);
@@ -570,3 +650,81 @@ void LUA_HUD_DrawList(huddrawlist_h list)
 		}
 	}
 }
+
+static drawcache_t *FindDrawCache(huddrawlist_h list, INT32 id)
+{
+	size_t i;
+
+	for (i = 0; i < list->caches_len; i++)
+		if (list->caches[i].id == id)
+			return &list->caches[i];
+	return NULL;
+}
+
+boolean LUA_HUD_ReplayCachedDraws(huddrawlist_h list, INT32 id, const huddrawkey_t *key)
+{
+	drawcache_t *cache = FindDrawCache(list, id);
+	size_t i, stroffset;
+
+	if (!cache || memcmp(&cache->key, key, sizeof *key))
+		return false;
+
+	ReserveDrawItems(list, cache->items_len);
+	ReserveStrings(list, cache->strbuf_len);
+
+	stroffset = list->strbuf_len;
+	if (cache->strbuf_len)
+		memcpy(&list->strbuf[stroffset], cache->strbuf, cache->strbuf_len);
+	list->strbuf_len += cache->strbuf_len;
+
+	for (i = 0; i < cache->items_len; i++)
+	{
+		drawitem_t *item = &list->items[list->items_len++];
+		*item = cache->items[i];
+		item->str += stroffset;
+	}
+
+	return true;
+}
+
+void LUA_HUD_BeginCachedDraws(huddrawlist_h list)
+{
+	list->mark_items = list->items_len;
+	list->mark_strbuf = list->strbuf_len;
+}
+
+void LUA_HUD_EndCachedDraws(huddrawlist_h list, INT32 id, const huddrawkey_t *key)
+{
+	drawcache_t *cache = FindDrawCache(list, id);
+	const size_t numitems = list->items_len - list->mark_items;
+	const size_t numchars = list->strbuf_len - list->mark_strbuf;
+	size_t i;
+
+	if (!cache)
+	{
+		list->caches = (drawcache_t *) Z_Realloc(list->caches, sizeof(drawcache_t) * (list->caches_len + 1), PU_STATIC, NULL);
+		cache = &list->caches[list->caches_len++];
+		memset(cache, 0, sizeof(drawcache_t));
+		cache->id = id;
+	}
+
+	cache->key = *key;
+
+	cache->items_len = numitems;
+	if (numitems)
+	{
+		cache->items = (drawitem_t *) Z_Realloc(cache->items, sizeof(drawitem_t) * numitems, PU_STATIC, NULL);
+		memcpy(cache->items, &list->items[list->mark_items], sizeof(drawitem_t) * numitems);
+		for (i = 0; i < numitems; i++)
+			cache->items[i].str -= list->mark_strbuf;
+	}
+
+	cache->strbuf_len = numchars;
+	if (numchars)
+	{
+		cache->strbuf = (char *) Z_Realloc(cache->strbuf, numchars, PU_STATIC, NULL);
+		memcpy(cache->strbuf, &list->strbuf[list->mark_strbuf], numchars);
+	}
+
+	list->mark_items = list->mark_strbuf = 0;
+}
@@ -145,6 +145,28 @@ void LUA_HUD_AddFadeScreen(
 // Draws the given draw list
 void LUA_HUD_DrawList(huddrawlist_h list);
 
+// Everything the draws of a cached HUD hook may depend on. A cached
+// hook is only skipped while all of this stays the same.
+typedef struct
+{
+	UINT32 refresh; // bumped by hud.refresh()
+	INT32 width;
+	INT32 height;
+	INT32 splitscreen;
+	INT32 player;
+	INT32 gamestate;
+	INT32 gamemap;
+	INT32 numwadfiles;
+} huddrawkey_t;
+
+// Appends the draws saved for the hook with the given id, if they were
+// saved under the same key. Returns false if the hook has to be run.
+boolean LUA_HUD_ReplayCachedDraws(huddrawlist_h list, INT32 id, const huddrawkey_t *key);
+// Call before running a cached hook...
+void LUA_HUD_BeginCachedDraws(huddrawlist_h list);
+// ...and after, to save the draws it added.
+void LUA_HUD_EndCachedDraws(huddrawlist_h list, INT32 id, const huddrawkey_t *key);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
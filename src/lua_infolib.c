@@ -654,7 +654,7 @@ static void A_Lua(mobj_t *actor)
 	}
 	lua_pop(gL, 1); // pop LREG_ACTION
 
-	LUA_PushUserdata(gL, actor, META_MOBJ);
+	LUA_PushMobj(gL, actor);
 	lua_pushinteger(gL, var1);
 	lua_pushinteger(gL, var2);
 	LUA_Call(gL, 3, 0, 1);
@@ -845,7 +845,7 @@ boolean LUA_CallAction(enum actionnum actionnum, mobj_t *actor)
 	// Found a function.
 	// Call it with (actor, var1, var2)
 	I_Assert(lua_isfunction(gL, -1));
-	LUA_PushUserdata(gL, actor, META_MOBJ);
+	LUA_PushMobj(gL, actor);
 	lua_pushinteger(gL, var1);
 	lua_pushinteger(gL, var2);
 
@@ -1321,7 +1321,7 @@ static int lib_setSfxInfo(lua_State *L)
 		if (lua_isnumber(L, 2))
 			i = lua_tointeger(L, 2) - 1; // lua is one based, this enum is zero based.
 		else
-			i = luaL_checkoption(L, 2, NULL, sfxinfo_wopt);
+			i = Lua_checkoption(L, 2, NULL, sfxinfo_wopt);
 
 		switch(i)
 		{
@@ -1356,7 +1356,7 @@ static int lib_sfxlen(lua_State *L)
 static int sfxinfo_get(lua_State *L)
 {
 	sfxinfo_t *sfx = *((sfxinfo_t **)luaL_checkudata(L, 1, META_SFXINFO));
-	enum sfxinfo_read field = luaL_checkoption(L, 2, NULL, sfxinfo_ropt);
+	enum sfxinfo_read field = Lua_checkoption(L, 2, NULL, sfxinfo_ropt);
 
 	I_Assert(sfx != NULL);
 
@@ -1390,7 +1390,7 @@ static int sfxinfo_get(lua_State *L)
 static int sfxinfo_set(lua_State *L)
 {
 	sfxinfo_t *sfx = *((sfxinfo_t **)luaL_checkudata(L, 1, META_SFXINFO));
-	enum sfxinfo_write field = luaL_checkoption(L, 2, NULL, sfxinfo_wopt);
+	enum sfxinfo_write field = Lua_checkoption(L, 2, NULL, sfxinfo_wopt);
 
 	if (hud_running)
 		return luaL_error(L, "Do not alter S_sfx in HUD rendering code!");
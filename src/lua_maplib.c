@@ -405,7 +405,7 @@ static int lib_iterateSectorThinglist(lua_State *L)
 
 	if (thing)
 	{
-		LUA_PushUserdata(L, thing, META_MOBJ);
+		LUA_PushMobj(L, thing);
 		return 1;
 	}
 	return 0;
@@ -508,7 +508,7 @@ static int sectorlines_get(lua_State *L)
 	lua_settop(L, 2);
 	if (!lua_isnumber(L, 2))
 	{
-		int field = luaL_checkoption(L, 2, NULL, valid_opt);
+		int field = Lua_checkoption(L, 2, NULL, valid_opt);
 		if (!seclines || !(*seclines))
 		{
 			if (field == 0) {
@@ -575,7 +575,7 @@ static int sectorlines_num(lua_State *L)
 static int sector_get(lua_State *L)
 {
 	sector_t *sector = *((sector_t **)luaL_checkudata(L, 1, META_SECTOR));
-	enum sector_e field = luaL_checkoption(L, 2, sector_opt[0], sector_opt);
+	enum sector_e field = Lua_checkoption(L, 2, sector_opt[0], sector_opt);
 	INT16 i;
 
 	if (!sector)
@@ -642,18 +642,18 @@ static int sector_get(lua_State *L)
 		return 1;
 	case sector_thinglist: // thinglist
 		lua_pushcfunction(L, lib_iterateSectorThinglist);
-		LUA_PushUserdata(L, sector->thinglist, META_MOBJ);
+		LUA_PushMobj(L, sector->thinglist);
 		lua_pushcclosure(L, sector_iterate, 2); // push lib_iterateSectorThinglist and sector->thinglist as upvalues for the function
 		return 1;
 	case sector_heightsec: // heightsec - fake floor heights
 		if (sector->heightsec < 0)
 			return 0;
-		LUA_PushUserdata(L, &sectors[sector->heightsec], META_SECTOR);
+		LUA_PushSector(L, &sectors[sector->heightsec]);
 		return 1;
 	case sector_camsec: // camsec - camera clipping heights
 		if (sector->camsec < 0)
 			return 0;
-		LUA_PushUserdata(L, &sectors[sector->camsec], META_SECTOR);
+		LUA_PushSector(L, &sectors[sector->camsec]);
 		return 1;
 	case sector_lines: // lines
 		LUA_PushUserdata(L, &sector->lines, META_SECTORLINES); // push the address of the "lines" member in the struct, to allow our hacks in sectorlines_get/_num to work
@@ -697,7 +697,7 @@ static int sector_get(lua_State *L)
 static int sector_set(lua_State *L)
 {
 	sector_t *sector = *((sector_t **)luaL_checkudata(L, 1, META_SECTOR));
-	enum sector_e field = luaL_checkoption(L, 2, sector_opt[0], sector_opt);
+	enum sector_e field = Lua_checkoption(L, 2, sector_opt[0], sector_opt);
 
 	if (!sector)
 		return luaL_error(L, "accessed sector_t doesn't exist anymore.");
@@ -814,7 +814,7 @@ static int sector_num(lua_State *L)
 static int subsector_get(lua_State *L)
 {
 	subsector_t *subsector = *((subsector_t **)luaL_checkudata(L, 1, META_SUBSECTOR));
-	enum subsector_e field = luaL_checkoption(L, 2, subsector_opt[0], subsector_opt);
+	enum subsector_e field = Lua_checkoption(L, 2, subsector_opt[0], subsector_opt);
 
 	if (!subsector)
 	{
@@ -831,7 +831,7 @@ static int subsector_get(lua_State *L)
 		lua_pushboolean(L, 1);
 		return 1;
 	case subsector_sector:
-		LUA_PushUserdata(L, subsector->sector, META_SECTOR);
+		LUA_PushSector(L, subsector->sector);
 		return 1;
 	case subsector_numlines:
 		lua_pushinteger(L, subsector->numlines);
@@ -898,7 +898,7 @@ static int linestringargs_len(lua_State *L)
 static int line_get(lua_State *L)
 {
 	line_t *line = *((line_t **)luaL_checkudata(L, 1, META_LINE));
-	enum line_e field = luaL_checkoption(L, 2, line_opt[0], line_opt);
+	enum line_e field = Lua_checkoption(L, 2, line_opt[0], line_opt);
 
 	if (!line)
 	{
@@ -993,10 +993,10 @@ static int line_get(lua_State *L)
 		}
 		return 1;
 	case line_frontsector:
-		LUA_PushUserdata(L, line->frontsector, META_SECTOR);
+		LUA_PushSector(L, line->frontsector);
 		return 1;
 	case line_backsector:
-		LUA_PushUserdata(L, line->backsector, META_SECTOR);
+		LUA_PushSector(L, line->backsector);
 		return 1;
 	case line_polyobj:
 		LUA_PushUserdata(L, line->polyobj, META_POLYOBJ);
@@ -1029,7 +1029,7 @@ static int sidenum_get(lua_State *L)
 	lua_settop(L, 2);
 	if (!lua_isnumber(L, 2))
 	{
-		int field = luaL_checkoption(L, 2, NULL, valid_opt);
+		int field = Lua_checkoption(L, 2, NULL, valid_opt);
 		if (!sidenum)
 		{
 			if (field == 0) {
@@ -1057,7 +1057,7 @@ static int sidenum_get(lua_State *L)
 static int side_get(lua_State *L)
 {
 	side_t *side = *((side_t **)luaL_checkudata(L, 1, META_SIDE));
-	enum side_e field = luaL_checkoption(L, 2, side_opt[0], side_opt);
+	enum side_e field = Lua_checkoption(L, 2, side_opt[0], side_opt);
 
 	if (!side)
 	{
@@ -1092,7 +1092,7 @@ static int side_get(lua_State *L)
 		LUA_PushUserdata(L, side->line, META_LINE);
 		return 1;
 	case side_sector:
-		LUA_PushUserdata(L, side->sector, META_SECTOR);
+		LUA_PushSector(L, side->sector);
 		return 1;
 	case side_special:
 		lua_pushinteger(L, side->special);
@@ -1110,7 +1110,7 @@ static int side_get(lua_State *L)
 static int side_set(lua_State *L)
 {
 	side_t *side = *((side_t **)luaL_checkudata(L, 1, META_SIDE));
-	enum side_e field = luaL_checkoption(L, 2, side_opt[0], side_opt);
+	enum side_e field = Lua_checkoption(L, 2, side_opt[0], side_opt);
 
 	if (!side)
 	{
@@ -1166,7 +1166,7 @@ static int side_num(lua_State *L)
 static int vertex_get(lua_State *L)
 {
 	vertex_t *vertex = *((vertex_t **)luaL_checkudata(L, 1, META_VERTEX));
-	enum vertex_e field = luaL_checkoption(L, 2, vertex_opt[0], vertex_opt);
+	enum vertex_e field = Lua_checkoption(L, 2, vertex_opt[0], vertex_opt);
 
 	if (!vertex)
 	{
@@ -1220,7 +1220,7 @@ static int vertex_num(lua_State *L)
 static int seg_get(lua_State *L)
 {
 	seg_t *seg = *((seg_t **)luaL_checkudata(L, 1, META_SEG));
-	enum seg_e field = luaL_checkoption(L, 2, seg_opt[0], seg_opt);
+	enum seg_e field = Lua_checkoption(L, 2, seg_opt[0], seg_opt);
 
 	if (!seg)
 	{
@@ -1258,10 +1258,10 @@ static int seg_get(lua_State *L)
 		LUA_PushUserdata(L, seg->linedef, META_LINE);
 		return 1;
 	case seg_frontsector:
-		LUA_PushUserdata(L, seg->frontsector, META_SECTOR);
+		LUA_PushSector(L, seg->frontsector);
 		return 1;
 	case seg_backsector:
-		LUA_PushUserdata(L, seg->backsector, META_SECTOR);
+		LUA_PushSector(L, seg->backsector);
 		return 1;
 	case seg_polyseg:
 		LUA_PushUserdata(L, seg->polyseg, META_POLYOBJ);
@@ -1284,7 +1284,7 @@ static int seg_num(lua_State *L)
 static int node_get(lua_State *L)
 {
 	node_t *node = *((node_t **)luaL_checkudata(L, 1, META_NODE));
-	enum node_e field = luaL_checkoption(L, 2, node_opt[0], node_opt);
+	enum node_e field = Lua_checkoption(L, 2, node_opt[0], node_opt);
 
 	if (!node)
 	{
@@ -1345,7 +1345,7 @@ static int nodebbox_get(lua_State *L)
 	lua_settop(L, 2);
 	if (!lua_isnumber(L, 2))
 	{
-		int field = luaL_checkoption(L, 2, NULL, valid_opt);
+		int field = Lua_checkoption(L, 2, NULL, valid_opt);
 		if (!bbox)
 		{
 			if (field == 0) {
@@ -1378,7 +1378,7 @@ static int nodebbox_call(lua_State *L)
 		return luaL_error(L, "arguments 2 and/or 3 not given (expected node.bbox(child, coord))");
 	// get child
 	if (!lua_isnumber(L, 2)) {
-		enum nodechild_e field = luaL_checkoption(L, 2, nodechild_opt[0], nodechild_opt);
+		enum nodechild_e field = Lua_checkoption(L, 2, nodechild_opt[0], nodechild_opt);
 		switch (field) {
 			case nodechild_right: i = 0; break;
 			case nodechild_left:  i = 1; break;
@@ -1393,7 +1393,7 @@ static int nodebbox_call(lua_State *L)
 	}
 	// get bbox coord
 	if (!lua_isnumber(L, 3)) {
-		enum bbox_e field = luaL_checkoption(L, 3, bbox_opt[0], bbox_opt);
+		enum bbox_e field = Lua_checkoption(L, 3, bbox_opt[0], bbox_opt);
 		switch (field) {
 			case bbox_top:    j = BOXTOP;    break;
 			case bbox_bottom: j = BOXBOTTOM; break;
@@ -1424,7 +1424,7 @@ static int nodechildren_get(lua_State *L)
 	lua_settop(L, 2);
 	if (!lua_isnumber(L, 2))
 	{
-		enum nodechild_e field = luaL_checkoption(L, 2, nodechild_opt[0], nodechild_opt);
+		enum nodechild_e field = Lua_checkoption(L, 2, nodechild_opt[0], nodechild_opt);
 		if (!children)
 		{
 			if (field == nodechild_valid) {
@@ -1464,7 +1464,7 @@ static int bbox_get(lua_State *L)
 	lua_settop(L, 2);
 	if (!lua_isnumber(L, 2))
 	{
-		enum bbox_e field = luaL_checkoption(L, 2, bbox_opt[0], bbox_opt);
+		enum bbox_e field = Lua_checkoption(L, 2, bbox_opt[0], bbox_opt);
 		if (!bbox)
 		{
 			if (field == bbox_valid) {
@@ -1508,7 +1508,7 @@ static int lib_iterateSectors(lua_State *L)
 		i = (size_t)(*((sector_t **)luaL_checkudata(L, 1, META_SECTOR)) - sectors)+1;
 	if (i < numsectors)
 	{
-		LUA_PushUserdata(L, &sectors[i], META_SECTOR);
+		LUA_PushSector(L, &sectors[i]);
 		return 1;
 	}
 	return 0;
@@ -1522,7 +1522,7 @@ static int lib_getSector(lua_State *L)
 		size_t i = lua_tointeger(L, 2);
 		if (i >= numsectors)
 			return 0;
-		LUA_PushUserdata(L, &sectors[i], META_SECTOR);
+		LUA_PushSector(L, &sectors[i]);
 		return 1;
 	}
 	return 0;
@@ -1570,7 +1570,7 @@ static int lib_getSubsector(lua_State *L)
 		LUA_PushUserdata(L, &subsectors[i], META_SUBSECTOR);
 		return 1;
 	}
-	field = luaL_checkoption(L, 1, NULL, array_opt);
+	field = Lua_checkoption(L, 1, NULL, array_opt);
 	switch(field)
 	{
 	case 0: // iterate
@@ -1664,7 +1664,7 @@ static int lib_getSide(lua_State *L)
 		LUA_PushUserdata(L, &sides[i], META_SIDE);
 		return 1;
 	}
-	field = luaL_checkoption(L, 1, NULL, array_opt);
+	field = Lua_checkoption(L, 1, NULL, array_opt);
 	switch(field)
 	{
 	case 0: // iterate
@@ -1716,7 +1716,7 @@ static int lib_getVertex(lua_State *L)
 		LUA_PushUserdata(L, &vertexes[i], META_VERTEX);
 		return 1;
 	}
-	field = luaL_checkoption(L, 1, NULL, array_opt);
+	field = Lua_checkoption(L, 1, NULL, array_opt);
 	switch(field)
 	{
 	case 0: // iterate
@@ -1770,7 +1770,7 @@ static int lib_getSeg(lua_State *L)
 		LUA_PushUserdata(L, &segs[i], META_SEG);
 		return 1;
 	}
-	field = luaL_checkoption(L, 1, NULL, array_opt);
+	field = Lua_checkoption(L, 1, NULL, array_opt);
 	switch(field)
 	{
 	case 0: // iterate
@@ -1822,7 +1822,7 @@ static int lib_getNode(lua_State *L)
 		LUA_PushUserdata(L, &nodes[i], META_NODE);
 		return 1;
 	}
-	field = luaL_checkoption(L, 1, NULL, array_opt);
+	field = Lua_checkoption(L, 1, NULL, array_opt);
 	switch(field)
 	{
 	case 0: // iterate
@@ -1920,7 +1920,7 @@ static INT32 P_GetOldFOFFlags(ffloor_t *fflr)
 static int ffloor_get(lua_State *L)
 {
 	ffloor_t *ffloor = *((ffloor_t **)luaL_checkudata(L, 1, META_FFLOOR));
-	enum ffloor_e field = luaL_checkoption(L, 2, ffloor_opt[0], ffloor_opt);
+	enum ffloor_e field = Lua_checkoption(L, 2, ffloor_opt[0], ffloor_opt);
 	INT16 i;
 
 	if (!ffloor)
@@ -1969,7 +1969,7 @@ static int ffloor_get(lua_State *L)
 		LUA_PushUserdata(L, *ffloor->b_slope, META_SLOPE);
 		return 1;
 	case ffloor_sector:
-		LUA_PushUserdata(L, &sectors[ffloor->secnum], META_SECTOR);
+		LUA_PushSector(L, &sectors[ffloor->secnum]);
 		return 1;
 	case ffloor_fofflags:
 		lua_pushinteger(L, ffloor->fofflags);
@@ -1981,7 +1981,7 @@ static int ffloor_get(lua_State *L)
 		LUA_PushUserdata(L, ffloor->master, META_LINE);
 		return 1;
 	case ffloor_target:
-		LUA_PushUserdata(L, ffloor->target, META_SECTOR);
+		LUA_PushSector(L, ffloor->target);
 		return 1;
 	case ffloor_next:
 		LUA_PushUserdata(L, ffloor->next, META_FFLOOR);
@@ -2102,7 +2102,7 @@ static void P_SetOldFOFFlags(ffloor_t *fflr, oldffloortype_e oldflags)
 static int ffloor_set(lua_State *L)
 {
 	ffloor_t *ffloor = *((ffloor_t **)luaL_checkudata(L, 1, META_FFLOOR));
-	enum ffloor_e field = luaL_checkoption(L, 2, ffloor_opt[0], ffloor_opt);
+	enum ffloor_e field = Lua_checkoption(L, 2, ffloor_opt[0], ffloor_opt);
 
 	if (!ffloor)
 		return luaL_error(L, "accessed ffloor_t doesn't exist anymore.");
@@ -2197,7 +2197,7 @@ static int ffloor_set(lua_State *L)
 static int slope_get(lua_State *L)
 {
 	pslope_t *slope = *((pslope_t **)luaL_checkudata(L, 1, META_SLOPE));
-	enum slope_e field = luaL_checkoption(L, 2, slope_opt[0], slope_opt);
+	enum slope_e field = Lua_checkoption(L, 2, slope_opt[0], slope_opt);
 
 	if (!slope)
 	{
@@ -2241,7 +2241,7 @@ static int slope_get(lua_State *L)
 static int slope_set(lua_State *L)
 {
 	pslope_t *slope = *((pslope_t **)luaL_checkudata(L, 1, META_SLOPE));
-	enum slope_e field = luaL_checkoption(L, 2, slope_opt[0], slope_opt);
+	enum slope_e field = Lua_checkoption(L, 2, slope_opt[0], slope_opt);
 
 	if (!slope)
 		return luaL_error(L, "accessed pslope_t doesn't exist anymore.");
@@ -2331,7 +2331,7 @@ static int slope_set(lua_State *L)
 static int vector2_get(lua_State *L)
 {
 	vector2_t *vec = *((vector2_t **)luaL_checkudata(L, 1, META_VECTOR2));
-	enum vector_e field = luaL_checkoption(L, 2, vector_opt[0], vector_opt);
+	enum vector_e field = Lua_checkoption(L, 2, vector_opt[0], vector_opt);
 
 	if (!vec)
 		return luaL_error(L, "accessed vector2_t doesn't exist anymore.");
@@ -2349,7 +2349,7 @@ static int vector2_get(lua_State *L)
 static int vector3_get(lua_State *L)
 {
 	vector3_t *vec = *((vector3_t **)luaL_checkudata(L, 1, META_VECTOR3));
-	enum vector_e field = luaL_checkoption(L, 2, vector_opt[0], vector_opt);
+	enum vector_e field = Lua_checkoption(L, 2, vector_opt[0], vector_opt);
 
 	if (!vec)
 		return luaL_error(L, "accessed vector3_t doesn't exist anymore.");
@@ -2385,7 +2385,7 @@ static int lib_getMapheaderinfo(lua_State *L)
 		//CONS_Printf(mapheaderinfo[i]->lvlttl);
 		return 1;
 	}/*
-	field = luaL_checkoption(L, 1, NULL, array_opt);
+	field = Lua_checkoption(L, 1, NULL, array_opt);
 	switch(field)
 	{
 	case 0: // iterate
@@ -209,7 +209,7 @@ static int mobj_get(lua_State *L)
 		lua_pushfixed(L, mo->z);
 		break;
 	case mobj_snext:
-		LUA_PushUserdata(L, mo->snext, META_MOBJ);
+		LUA_PushMobj(L, mo->snext);
 		break;
 	case mobj_sprev:
 		// sprev is actually the previous mobj's snext pointer,
@@ -320,7 +320,7 @@ static int mobj_get(lua_State *L)
 		lua_pushinteger(L, mo->blendmode);
 		break;
 	case mobj_bnext:
-		LUA_PushUserdata(L, mo->bnext, META_MOBJ);
+		LUA_PushMobj(L, mo->bnext);
 		break;
 	case mobj_bprev:
 		// bprev -- same deal as sprev above, but for the blockmap.
@@ -331,7 +331,7 @@ static int mobj_get(lua_State *L)
 			P_SetTarget(&mo->hnext, NULL);
 			return 0;
 		}
-		LUA_PushUserdata(L, mo->hnext, META_MOBJ);
+		LUA_PushMobj(L, mo->hnext);
 		break;
 	case mobj_hprev:
 		if (mo->hprev && P_MobjWasRemoved(mo->hprev))
@@ -339,7 +339,7 @@ static int mobj_get(lua_State *L)
 			P_SetTarget(&mo->hprev, NULL);
 			return 0;
 		}
-		LUA_PushUserdata(L, mo->hprev, META_MOBJ);
+		LUA_PushMobj(L, mo->hprev);
 		break;
 	case mobj_type:
 		lua_pushinteger(L, mo->type);
@@ -362,7 +362,7 @@ static int mobj_get(lua_State *L)
 			P_SetTarget(&mo->target, NULL);
 			return 0;
 		}
-		LUA_PushUserdata(L, mo->target, META_MOBJ);
+		LUA_PushMobj(L, mo->target);
 		break;
 	case mobj_reactiontime:
 		lua_pushinteger(L, mo->reactiontime);
@@ -371,7 +371,7 @@ static int mobj_get(lua_State *L)
 		lua_pushinteger(L, mo->threshold);
 		break;
 	case mobj_player:
-		LUA_PushUserdata(L, mo->player, META_PLAYER);
+		LUA_PushPlayer(L, mo->player);
 		break;
 	case mobj_lastlook:
 		lua_pushinteger(L, mo->lastlook);
@@ -385,7 +385,7 @@ static int mobj_get(lua_State *L)
 			P_SetTarget(&mo->tracer, NULL);
 			return 0;
 		}
-		LUA_PushUserdata(L, mo->tracer, META_MOBJ);
+		LUA_PushMobj(L, mo->tracer);
 		break;
 	case mobj_friction:
 		lua_pushfixed(L, mo->friction);
@@ -925,7 +925,7 @@ static int mapthing_get(lua_State *L)
 		return 1;
 	}
 	else if(fastcmp(field,"mobj")) {
-		LUA_PushUserdata(L, mt->mobj, META_MOBJ);
+		LUA_PushMobj(L, mt->mobj);
 		return 1;
 	} else if (devparm)
 		return luaL_error(L, LUA_QL("mapthing_t") " has no field named " LUA_QS, field);
@@ -85,7 +85,7 @@ static int polyobjvertices_get(lua_State *L)
 	lua_settop(L, 2);
 	if (!lua_isnumber(L, 2))
 	{
-		int field = luaL_checkoption(L, 2, NULL, valid_opt);
+		int field = Lua_checkoption(L, 2, NULL, valid_opt);
 		if (!polyverts || !(*polyverts))
 		{
 			if (field == 0) {
@@ -142,7 +142,7 @@ static int polyobjlines_get(lua_State *L)
 	lua_settop(L, 2);
 	if (!lua_isnumber(L, 2))
 	{
-		int field = luaL_checkoption(L, 2, NULL, valid_opt);
+		int field = Lua_checkoption(L, 2, NULL, valid_opt);
 		if (!polylines || !(*polylines))
 		{
 			if (field == 0) {
@@ -262,7 +262,7 @@ static int lib_polyobj_rotate(lua_State *L)
 static int polyobj_get(lua_State *L)
 {
 	polyobj_t *polyobj = *((polyobj_t **)luaL_checkudata(L, 1, META_POLYOBJ));
-	enum polyobj_e field = luaL_checkoption(L, 2, NULL, polyobj_opt);
+	enum polyobj_e field = Lua_checkoption(L, 2, NULL, polyobj_opt);
 
 	if (!polyobj) {
 		if (field == polyobj_valid) {
@@ -291,7 +291,7 @@ static int polyobj_get(lua_State *L)
 		LUA_PushUserdata(L, &polyobj->lines, META_POLYOBJLINES); // push the address of the "lines" member in the struct, to allow our hacks to work
 		break;
 	case polyobj_sector: // shortcut that exists only in Lua!
-		LUA_PushUserdata(L, polyobj->lines[0]->backsector, META_SECTOR);
+		LUA_PushSector(L, polyobj->lines[0]->backsector);
 		break;
 	case polyobj_angle:
 		lua_pushangle(L, polyobj->angle);
@@ -335,7 +335,7 @@ static int polyobj_get(lua_State *L)
 static int polyobj_set(lua_State *L)
 {
 	polyobj_t *polyobj = *((polyobj_t **)luaL_checkudata(L, 1, META_POLYOBJ));
-	enum polyobj_e field = luaL_checkoption(L, 2, NULL, polyobj_opt);
+	enum polyobj_e field = Lua_checkoption(L, 2, NULL, polyobj_opt);
 
 	if (!polyobj)
 		return LUA_ErrInvalid(L, "polyobj_t");
@@ -0,0 +1,378 @@
+// SONIC ROBO BLAST 2
+//-----------------------------------------------------------------------------
+// Copyright (C) 2023 by Sonic Team Junior.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  lua_profile.c
+/// \brief Sampling profiler for Lua hooks and scripts
+///
+///        A count hook on gL fires every few hundred VM instructions. Each
+///        time, the Lua call stack is folded into a "Hook;func src:line;..."
+///        string and the wall time since the previous sample is charged to
+///        it, so time spent in C functions called from Lua lands on the
+///        Lua line that called them. Hook calls are bracketed by
+///        LUA_ProfileEnter and LUA_ProfileLeave, which give the time a
+///        hook takes before its first sample to the hook function itself
+///        and keep engine time between hooks out of the totals.
+///        The result can be dumped in the folded format read by
+///        flamegraph.pl and similar tools.
+
+#include "doomdef.h"
+#include "i_system.h"
+#include "z_zone.h"
+#include "command.h"
+#include "d_main.h" // srb2home
+#include "lua_script.h"
+#include "lua_libs.h"
+#include "lua_profile.h"
+
+#define PROF_DEFAULTINTERVAL 1000 // instructions between samples
+#define PROF_MAXDEPTH 32 // Lua frames kept per sample
+#define PROF_MAXNEST 16 // hooks running hooks
+#define PROF_STACKLEN 2048
+
+typedef struct
+{
+	char *stack; // folded stack, outermost frame first
+	UINT32 hash;
+	UINT32 samples;
+	precise_t time;
+} profentry_t;
+
+typedef struct
+{
+	const char *hookname;
+	char base[LUA_IDSIZE + 64]; // hook name and the hook function itself
+	profentry_t *last; // entry charged by the most recent sample
+} profcall_t;
+
+boolean lua_profiling = false;
+
+static profentry_t **profentries; // open addressing hash table
+static size_t profcapacity;
+static size_t profcount;
+
+static profcall_t profcalls[PROF_MAXNEST];
+static INT32 profdepth;
+static precise_t proflast;
+static precise_t profstart, proftotal;
+
+static UINT32 Prof_Hash(const char *s)
+{
+	UINT32 hash = 2166136261u;
+	while (*s)
+		hash = (hash ^ (UINT8)*s++) * 16777619u;
+	return hash;
+}
+
+static void Prof_Clear(void)
+{
+	size_t i;
+
+	if (!profentries)
+		return;
+	for (i = 0; i < profcapacity; i++)
+		if (profentries[i])
+		{
+			Z_Free(profentries[i]->stack);
+			Z_Free(profentries[i]);
+		}
+	Z_Free(profentries);
+	profentries = NULL;
+	profcapacity = profcount = 0;
+}
+
+static void Prof_Grow(void)
+{
+	profentry_t **old = profentries;
+	const size_t oldcapacity = profcapacity;
+	size_t i, j;
+
+	profcapacity = oldcapacity ? oldcapacity * 2 : 256;
+	profentries = Z_Calloc(profcapacity * sizeof *profentries, PU_STATIC, NULL);
+
+	for (i = 0; i < oldcapacity; i++)
+	{
+		if (!old[i])
+			continue;
+		for (j = old[i]->hash & (profcapacity - 1); profentries[j]; j = (j + 1) & (profcapacity - 1))
+			;
+		profentries[j] = old[i];
+	}
+
+	if (old)
+		Z_Free(old);
+}
+
+// Finds the entry for a folded stack, adding it if needed.
+static profentry_t *Prof_Find(const char *stack)
+{
+	const UINT32 hash = Prof_Hash(stack);
+	size_t i;
+
+	if ((profcount + 1) * 4 > profcapacity * 3)
+		Prof_Grow();
+
+	for (i = hash & (profcapacity - 1); profentries[i]; i = (i + 1) & (profcapacity - 1))
+		if (profentries[i]->hash == hash && !strcmp(profentries[i]->stack, stack))
+			return profentries[i];
+
+	profentries[i] = Z_Calloc(sizeof **profentries, PU_STATIC, NULL);
+	profentries[i]->stack = Z_StrDup(stack);
+	profentries[i]->hash = hash;
+	profcount++;
+	return profentries[i];
+}
+
+// Appends one frame to a folded stack. ';' separates frames in the
+// output format, so it can't appear inside one.
+static void Prof_AddFrame(char *buf, size_t size, const char *frame)
+{
+	size_t len = strlen(buf);
+
+	if (len && len + 1 < size)
+		buf[len++] = ';';
+	for (; *frame && len + 1 < size; frame++)
+		buf[len++] = (*frame == ';') ? ',' : *frame;
+	buf[len] = '\0';
+}
+
+static void Prof_FormatFrame(char *out, size_t size, const lua_Debug *ar)
+{
+	if (ar->what[0] == 'C')
+		snprintf(out, size, "[C] %s", ar->name ? ar->name : "?");
+	else if (ar->currentline > 0)
+		snprintf(out, size, "%s %s:%d", ar->name ? ar->name : "?", ar->short_src, ar->currentline);
+	else
+		snprintf(out, size, "%s %s:%d", ar->name ? ar->name : "?", ar->short_src, ar->linedefined);
+}
+
+static void Prof_Sample(lua_State *L, lua_Debug *unused)
+{
+	char stack[PROF_STACKLEN];
+	char frame[LUA_IDSIZE + 64];
+	lua_Debug ar[PROF_MAXDEPTH];
+	profentry_t *entry;
+	precise_t now = I_GetPreciseTime();
+	const INT32 nest = min(profdepth, PROF_MAXNEST);
+	INT32 depth, i;
+	(void)unused;
+
+	for (depth = 0; depth < PROF_MAXDEPTH && lua_getstack(L, depth, &ar[depth]); depth++)
+		lua_getinfo(L, "Sln", &ar[depth]);
+
+	stack[0] = '\0';
+	Prof_AddFrame(stack, sizeof stack, nest ? profcalls[nest - 1].hookname : "Script");
+	for (i = depth - 1; i >= 0; i--)
+	{
+		Prof_FormatFrame(frame, sizeof frame, &ar[i]);
+		Prof_AddFrame(stack, sizeof stack, frame);
+	}
+
+	entry = Prof_Find(stack);
+	entry->samples++;
+
+	// Outside of hooks we can't tell how much of the time since the
+	// last sample was spent in Lua, so only count the sample.
+	if (nest)
+	{
+		entry->time += now - proflast;
+		profcalls[nest - 1].last = entry;
+	}
+
+	// don't charge the profiler's own work to the next sample
+	proflast = I_GetPreciseTime();
+}
+
+void LUA_ProfileEnter(const char *hookname, int funcidx)
+{
+	profcall_t *call;
+	lua_Debug ar;
+	char frame[LUA_IDSIZE + 64];
+
+	if (profdepth)
+		Prof_Sample(gL, NULL); // charge the caller up to here
+
+	if (profdepth >= PROF_MAXNEST)
+	{
+		profdepth++;
+		return;
+	}
+
+	call = &profcalls[profdepth++];
+	call->hookname = hookname;
+	call->last = NULL;
+
+	lua_pushvalue(gL, funcidx);
+	lua_getinfo(gL, ">S", &ar);
+	ar.name = NULL;
+	ar.currentline = -1;
+	call->base[0] = '\0';
+	Prof_AddFrame(call->base, sizeof call->base, hookname);
+	Prof_FormatFrame(frame, sizeof frame, &ar);
+	Prof_AddFrame(call->base, sizeof call->base, frame);
+
+	proflast = I_GetPreciseTime();
+}
+
+void LUA_ProfileLeave(void)
+{
+	profcall_t *call;
+	profentry_t *entry;
+
+	if (!profdepth)
+		return;
+	if (profdepth-- > PROF_MAXNEST)
+		return;
+
+	call = &profcalls[profdepth];
+	entry = call->last;
+	if (!entry)
+	{
+		// finished before the first sample
+		entry = Prof_Find(call->base);
+		entry->samples++;
+	}
+	entry->time += I_GetPreciseTime() - proflast;
+
+	proflast = I_GetPreciseTime();
+}
+
+static void Prof_Start(INT32 interval)
+{
+	if (!gL)
+	{
+		CONS_Printf(M_GetText("No Lua scripts are loaded.\n"));
+		return;
+	}
+
+	Prof_Clear();
+	profdepth = 0;
+	profstart = I_GetPreciseTime();
+	proftotal = 0;
+
+	lua_sethook(gL, Prof_Sample, LUA_MASKCOUNT, interval);
+	lua_profiling = true;
+	CONS_Printf(M_GetText("Lua profiler started, sampling every %d instructions.\n"), interval);
+}
+
+static int Prof_CompareTime(const void *a, const void *b)
+{
+	const profentry_t *ea = *(const profentry_t * const *)a;
+	const profentry_t *eb = *(const profentry_t * const *)b;
+	if (ea->time != eb->time)
+		return (ea->time < eb->time) ? 1 : -1;
+	return 0;
+}
+
+static void Prof_Stop(void)
+{
+	const UINT64 precision = I_GetPrecisePrecision();
+	profentry_t **sorted;
+	precise_t total = 0;
+	size_t i, n = 0;
+
+	if (!lua_profiling)
+		return;
+
+	if (gL)
+		lua_sethook(gL, NULL, 0, 0);
+	lua_profiling = false;
+	proftotal = I_GetPreciseTime() - profstart;
+
+	if (!profcount)
+	{
+		CONS_Printf(M_GetText("Lua profiler stopped, nothing was sampled.\n"));
+		return;
+	}
+
+	sorted = Z_Malloc(profcount * sizeof *sorted, PU_STATIC, NULL);
+	for (i = 0; i < profcapacity; i++)
+		if (profentries[i])
+		{
+			sorted[n++] = profentries[i];
+			total += profentries[i]->time;
+		}
+	qsort(sorted, n, sizeof *sorted, Prof_CompareTime);
+
+	CONS_Printf(M_GetText("Lua profiler stopped: %.1f ms in hooks over %.1f s, %s stacks.\n"),
+		(double)total * 1000.0 / precision, (double)proftotal / precision, sizeu1(n));
+	for (i = 0; i < n && i < 10; i++)
+	{
+		const char *leaf = strrchr(sorted[i]->stack, ';');
+		CONS_Printf("%8.2f ms  %s\n", (double)sorted[i]->time * 1000.0 / precision,
+			leaf ? leaf + 1 : sorted[i]->stack);
+	}
+
+	Z_Free(sorted);
+}
+
+static void Prof_Dump(const char *name)
+{
+	const precise_t unit = I_GetPrecisePrecision() / 1000000;
+	char path[256];
+	FILE *f;
+	size_t i;
+
+	if (!profcount)
+	{
+		CONS_Printf(M_GetText("There is no Lua profile to dump.\n"));
+		return;
+	}
+
+	// only plain file names, so the dump stays inside srb2home
+	if (!*name || strchr(name, '/') || strchr(name, '\\') || strchr(name, ':') || strstr(name, ".."))
+	{
+		CONS_Alert(CONS_ERROR, M_GetText("Profile dump name must be a plain file name\n"));
+		return;
+	}
+
+	if (snprintf(path, sizeof path, "%s" PATHSEP "%s", srb2home, name) >= (int)sizeof path)
+	{
+		CONS_Alert(CONS_ERROR, M_GetText("Profile dump path is too long\n"));
+		return;
+	}
+
+	f = fopen(path, "w");
+	if (!f)
+	{
+		CONS_Alert(CONS_ERROR, M_GetText("Couldn't open %s for writing\n"), path);
+		return;
+	}
+
+	// folded stacks, one per line, weighted by microseconds
+	for (i = 0; i < profcapacity; i++)
+		if (profentries[i])
+			fprintf(f, "%s %s\n", profentries[i]->stack, sizeu1((size_t)(profentries[i]->time / (unit ? unit : 1))));
+
+	fclose(f);
+	CONS_Printf(M_GetText("Lua profile written to %s\n"), path);
+}
+
+void Command_LuaProfile_f(void)
+{
+	const char *arg = COM_Argv(1);
+
+	if (!stricmp(arg, "start"))
+	{
+		INT32 interval = PROF_DEFAULTINTERVAL;
+		if (COM_Argc() > 2)
+			interval = max(1, atoi(COM_Argv(2)));
+		Prof_Start(interval);
+	}
+	else if (!stricmp(arg, "stop"))
+		Prof_Stop();
+	else if (!stricmp(arg, "dump"))
+		Prof_Dump(COM_Argc() > 2 ? COM_Argv(2) : "luaprofile.txt");
+	else
+	{
+		CONS_Printf(M_GetText("luaprofile start [instructions]: start sampling Lua\n"
+			"luaprofile stop: stop and show the most expensive lines\n"
+			"luaprofile dump [file]: write folded stacks for flamegraph.pl\n"));
+		if (lua_profiling)
+			CONS_Printf(M_GetText("The profiler is running, %s stacks so far.\n"), sizeu1(profcount));
+	}
+}
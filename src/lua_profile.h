@@ -0,0 +1,29 @@
+// SONIC ROBO BLAST 2
+//-----------------------------------------------------------------------------
+// Copyright (C) 2023 by Sonic Team Junior.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  lua_profile.h
+/// \brief Sampling profiler for Lua hooks and scripts
+
+#ifndef __LUA_PROFILE_H__
+#define __LUA_PROFILE_H__
+
+#include "doomtype.h"
+
+extern boolean lua_profiling;
+
+/// Called right before a hook function is run, with the hook's name
+/// and the stack index of the function.
+void LUA_ProfileEnter(const char *hookname, int funcidx);
+
+/// Called right after a hook function returns or errors.
+void LUA_ProfileLeave(void);
+
+/// The luaprofile console command.
+void Command_LuaProfile_f(void);
+
+#endif
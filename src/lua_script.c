@@ -34,6 +34,22 @@
 #include "lua_script.h"
 #include "lua_libs.h"
 #include "lua_hook.h"
+#include "lua_alloc.h" // LUA_Alloc
+
+#include "d_netcmd.h" // cv_luagc*
+#include "i_system.h" // I_GetPreciseTime
+#include "i_time.h" // I_GetTimeToNextTic
+#include "m_perfstats.h"
+#include "m_argv.h" // -noluacache
+#include "md5.h"
+
+#ifdef _WIN32
+#include <process.h> // _getpid
+#define LUA_GetPid _getpid
+#else
+#include <unistd.h> // getpid
+#define LUA_GetPid getpid
+#endif
 
 #include "doomstat.h"
 #include "g_state.h"
@@ -70,18 +86,6 @@ static lua_CFunction liblist[] = {
 	NULL
 };
 
-// Lua asks for memory using this.
-static void *LUA_Alloc(void *ud, void *ptr, size_t osize, size_t nsize)
-{
-	(void)ud;
-	if (nsize == 0) {
-		if (osize != 0)
-			Z_Free(ptr);
-		return NULL;
-	} else
-		return Z_Realloc(ptr, nsize, PU_LUA, NULL);
-}
-
 // Panic function Lua calls when there's an unprotected error.
 // This function cannot return. Lua would kill the application anyway if it did.
 FUNCNORETURN static int LUA_Panic(lua_State *L)
@@ -348,17 +352,17 @@ int LUA_PushGlobals(lua_State *L, const char *word)
 	} else if (fastcmp(word,"consoleplayer")) { // player controlling console (aka local player 1)
 		if (!addedtogame || consoleplayer < 0 || !playeringame[consoleplayer])
 			return 0;
-		LUA_PushUserdata(L, &players[consoleplayer], META_PLAYER);
+		LUA_PushPlayer(L, &players[consoleplayer]);
 		return 1;
 	} else if (fastcmp(word,"displayplayer")) { // player visible on screen (aka display player 1)
 		if (displayplayer < 0 || !playeringame[displayplayer])
 			return 0;
-		LUA_PushUserdata(L, &players[displayplayer], META_PLAYER);
+		LUA_PushPlayer(L, &players[displayplayer]);
 		return 1;
 	} else if (fastcmp(word,"secondarydisplayplayer")) { // local/display player 2, for splitscreen
 		if (!splitscreen || secondarydisplayplayer < 0 || !playeringame[secondarydisplayplayer])
 			return 0;
-		LUA_PushUserdata(L, &players[secondarydisplayplayer], META_PLAYER);
+		LUA_PushPlayer(L, &players[secondarydisplayplayer]);
 		return 1;
 	} else if (fastcmp(word,"isserver")) {
 		lua_pushboolean(L, server);
@@ -370,7 +374,7 @@ int LUA_PushGlobals(lua_State *L, const char *word)
 	} else if (fastcmp(word,"server")) {
 		if ((!multiplayer || !netgame) && !playeringame[serverplayer])
 			return 0;
-		LUA_PushUserdata(L, &players[serverplayer], META_PLAYER);
+		LUA_PushPlayer(L, &players[serverplayer]);
 		return 1;
 	} else if (fastcmp(word,"emeralds")) {
 		lua_pushinteger(L, emeralds);
@@ -839,6 +843,22 @@ static int setglobals(lua_State *L)
 	return luaL_error(L, "Implicit global " LUA_QS " prevented. Create a local variable instead.", csname);
 }
 
+#define MAXOPTIONTABLES 64 // power of two, well above the number of option lists
+
+// Registry references to the tables built by Lua_PushOptionTable,
+// hashed by the address of their name list.
+static struct
+{
+	const char *const *lst;
+	int ref;
+} optiontables[MAXOPTIONTABLES];
+static size_t numoptiontables;
+
+// LUA_Step state: whether it has a collection cycle to finish, and the
+// heap size in KB when the last one it saw through ended
+static boolean gccycleactive;
+static INT32 gcestimate;
+
 // Clear and create a new Lua state, laddo!
 // There's SCRIPTIN to be had!
 static void LUA_ClearState(void)
@@ -851,6 +871,12 @@ static void LUA_ClearState(void)
 		lua_close(gL);
 	gL = NULL;
 
+	// the option tables went with it
+	memset(optiontables, 0, sizeof optiontables);
+	numoptiontables = 0;
+	gccycleactive = false;
+	gcestimate = 0;
+
 	CONS_Printf(M_GetText("Pardon me while I initialize the Lua scripting interface...\n"));
 
 	// allocate state
@@ -885,6 +911,7 @@ static void LUA_ClearState(void)
 
 	// lua state is ready!
 	gL = L;
+	LUA_GCTuning_OnChange();
 }
 
 #ifdef _DEBUG
@@ -902,9 +929,189 @@ void LUA_ClearExtVars(void)
 // (i.e. they were called in hooks or coroutines etc)
 INT32 lua_lumploading = 0;
 
+// Compiled scripts are cached in srb2home/luacache, one file per
+// script named after the MD5 of its source. The file is a small header
+// followed by the lua_dump output. Anything that doesn't match exactly
+// is ignored and overwritten.
+#define LUACACHE_DIR "luacache"
+#define LUACACHE_MAGIC "SRB2LUAC"
+#define LUACACHE_VERSION 1
+
+static boolean luacache_ready = false;
+static boolean luacache_disabled = false;
+
+static const char *LUA_CacheBuildId(void)
+{
+	return va("%s %s %s %d", comprevision, compdate, comptime, (int)sizeof (void *));
+}
+
+static const char *LUA_CachePath(const UINT8 *md5, const char *ext)
+{
+	char hex[33];
+	INT32 i;
+
+	for (i = 0; i < 16; i++)
+		sprintf(&hex[i*2], "%02x", md5[i]);
+	return va("%s" PATHSEP LUACACHE_DIR PATHSEP "%s.%s", srb2home, hex, ext);
+}
+
+static boolean LUA_CacheEnabled(void)
+{
+	if (!luacache_ready)
+	{
+		luacache_ready = true;
+		luacache_disabled = M_CheckParm("-noluacache");
+		if (!luacache_disabled)
+			I_mkdir(va("%s" PATHSEP LUACACHE_DIR, srb2home), 0755);
+	}
+	return !luacache_disabled;
+}
+
+static void LUA_CacheWriteString(FILE *handle, const char *str)
+{
+	const UINT16 len = (UINT16)strlen(str);
+	fwrite(&len, sizeof len, 1, handle);
+	fwrite(str, 1, len, handle);
+}
+
+// Checks a length-prefixed string in the cache header.
+static boolean LUA_CacheReadString(UINT8 **p, const UINT8 *end, const char *expect)
+{
+	const size_t expectlen = strlen(expect);
+	UINT16 len;
+
+	if (end - *p < (ptrdiff_t)sizeof len)
+		return false;
+	memcpy(&len, *p, sizeof len);
+	*p += sizeof len;
+	if (len != expectlen || end - *p < len || memcmp(*p, expect, len))
+		return false;
+	*p += len;
+	return true;
+}
+
+// Pushes the cached function for this source, if there is a valid one.
+static boolean LUA_LoadCachedChunk(const UINT8 *md5, size_t sourcesize, const char *chunkname)
+{
+	FILE *handle;
+	UINT8 *data, *p, *end;
+	long size;
+	UINT32 storedsize;
+	boolean valid = false;
+
+	handle = fopen(LUA_CachePath(md5, "luac"), "rb");
+	if (!handle)
+		return false;
+
+	fseek(handle, 0, SEEK_END);
+	size = ftell(handle);
+	fseek(handle, 0, SEEK_SET);
+	if (size <= 0)
+	{
+		fclose(handle);
+		return false;
+	}
+
+	data = Z_Malloc(size, PU_STATIC, NULL);
+	if (fread(data, 1, size, handle) == (size_t)size)
+	{
+		p = data;
+		end = data + size;
+		if (end - p > (ptrdiff_t)(sizeof LUACACHE_MAGIC + sizeof storedsize)
+			&& !memcmp(p, LUACACHE_MAGIC, sizeof LUACACHE_MAGIC - 1)
+			&& p[sizeof LUACACHE_MAGIC - 1] == LUACACHE_VERSION)
+		{
+			p += sizeof LUACACHE_MAGIC;
+			memcpy(&storedsize, p, sizeof storedsize);
+			p += sizeof storedsize;
+			valid = (storedsize == sourcesize
+				&& LUA_CacheReadString(&p, end, LUA_CacheBuildId())
+				&& LUA_CacheReadString(&p, end, chunkname));
+		}
+	}
+	fclose(handle);
+
+	if (valid)
+	{
+		// lua_dump's own header also checks the blua version and type sizes
+		if (luaL_loadbinarybuffer(gL, (const char *)p, end - p, chunkname))
+		{
+			lua_pop(gL, 1);
+			valid = false;
+		}
+	}
+
+	Z_Free(data);
+	return valid;
+}
+
+// must match lua_Writer
+static int cacheWriter(lua_State *L, const void *p, size_t sz, void *ud)
+{
+	(void)L;
+	if (!sz)
+		return 0;
+	return (fwrite(p, 1, sz, (FILE *)ud) != sz);
+}
+
+// Saves the function on top of the stack to the cache.
+static void LUA_SaveCachedChunk(const UINT8 *md5, size_t sourcesize, const char *chunkname)
+{
+	char tmpext[32], tmppath[256], path[256];
+	const UINT32 storedsize = (UINT32)sourcesize;
+	const UINT8 version = LUACACHE_VERSION;
+	FILE *handle;
+	int error;
+
+	// the temporary name is per process, so servers sharing srb2home
+	// never write into the same file
+	snprintf(tmpext, sizeof tmpext, "tmp%d", (int)LUA_GetPid());
+	strlcpy(tmppath, LUA_CachePath(md5, tmpext), sizeof tmppath);
+	strlcpy(path, LUA_CachePath(md5, "luac"), sizeof path);
+
+	handle = fopen(tmppath, "wb");
+	if (!handle)
+		return;
+
+	fwrite(LUACACHE_MAGIC, 1, sizeof LUACACHE_MAGIC - 1, handle);
+	fwrite(&version, 1, 1, handle);
+	fwrite(&storedsize, sizeof storedsize, 1, handle);
+	LUA_CacheWriteString(handle, LUA_CacheBuildId());
+	LUA_CacheWriteString(handle, chunkname);
+	error = lua_dump(gL, cacheWriter, handle);
+	error |= ferror(handle);
+	fclose(handle);
+
+	// write under a temporary name first so a crash never leaves a
+	// half-written cache file behind
+	remove(path);
+	if (error || rename(tmppath, path))
+		remove(tmppath);
+}
+
+// Pushes the compiled function for a script, from the cache if possible.
+static int LUA_LoadChunk(MYFILE *f, const char *chunkname)
+{
+	UINT8 md5[16];
+	int status;
+
+	if (!LUA_CacheEnabled())
+		return luaL_loadbuffer(gL, f->data, f->size, chunkname);
+
+	md5_buffer(f->data, f->size, md5);
+	if (LUA_LoadCachedChunk(md5, f->size, chunkname))
+		return 0;
+
+	status = luaL_loadbuffer(gL, f->data, f->size, chunkname);
+	if (status == 0)
+		LUA_SaveCachedChunk(md5, f->size, chunkname);
+	return status;
+}
+
 // Load a script from a MYFILE
 static inline void LUA_LoadFile(MYFILE *f, char *name, boolean noresults)
 {
+	char chunkname[MAX_WADPATH + 64];
 	int errorhandlerindex;
 
 	if (!name)
@@ -919,7 +1126,8 @@ static inline void LUA_LoadFile(MYFILE *f, char *name, boolean noresults)
 
 	lua_pushcfunction(gL, LUA_GetErrorMessage);
 	errorhandlerindex = lua_gettop(gL);
-	if (luaL_loadbuffer(gL, f->data, f->size, va("@%s",name)) || lua_pcall(gL, 0, noresults ? 0 : LUA_MULTRET, lua_gettop(gL) - 1)) {
+	snprintf(chunkname, sizeof chunkname, "@%s", name);
+	if (LUA_LoadChunk(f, chunkname) || lua_pcall(gL, 0, noresults ? 0 : LUA_MULTRET, lua_gettop(gL) - 1)) {
 		CONS_Alert(CONS_WARNING,"%s\n",lua_tostring(gL,-1));
 		lua_pop(gL,1);
 	}
@@ -1078,6 +1286,14 @@ fixed_t LUA_EvalMath(const char *word)
 	return res;
 }
 
+// Block behind every userdata made by LUA_RawPushUserdata.
+// data comes first so the usual *((type **)luaL_checkudata(...)) still works.
+typedef struct
+{
+	void *data;
+	INT32 ref; // registry reference handed out by LUA_RawPushHandle, 0 if none
+} luahandle_t;
+
 // Takes a pointer, any pointer, and a metatable name
 // Creates a userdata for that pointer with the given metatable
 // Pushes it to the stack and stores it in the registry.
@@ -1095,7 +1311,7 @@ lpushed_t LUA_RawPushUserdata(lua_State *L, void *data)
 {
 	lpushed_t status = LPUSHED_NIL;
 
-	void **userdata;
+	luahandle_t *userdata;
 
 	if (!data) { // push a NULL
 		lua_pushnil(L);
@@ -1112,8 +1328,9 @@ lpushed_t LUA_RawPushUserdata(lua_State *L, void *data)
 		lua_pop(L, 1); // pop the nil
 
 		// create the userdata
-		userdata = lua_newuserdata(L, sizeof(void *));
-		*userdata = data;
+		userdata = lua_newuserdata(L, sizeof(luahandle_t));
+		userdata->data = data;
+		userdata->ref = 0;
 
 		// Set it in the registry so we can find it again
 		lua_pushlightuserdata(L, data); // k (store the userdata via the data's pointer)
@@ -1132,10 +1349,76 @@ lpushed_t LUA_RawPushUserdata(lua_State *L, void *data)
 	return status;
 }
 
+// Same as LUA_PushUserdata, but remembers the userdata in *ref so the
+// next push of the same object is a single registry array read instead
+// of a lookup in LREG_VALID. *ref lives on the C object and is only a
+// hint: it is checked against data before use, so a stale or copied
+// value just falls back to the slow path.
+void LUA_PushHandle(lua_State *L, void *data, INT32 *ref, const char *meta)
+{
+	if (LUA_RawPushHandle(L, data, ref) == LPUSHED_NEW)
+	{
+		luaL_getmetatable(L, meta);
+		lua_setmetatable(L, -2);
+	}
+}
+
+// Same as LUA_PushHandle but don't set a metatable yet.
+lpushed_t LUA_RawPushHandle(lua_State *L, void *data, INT32 *ref)
+{
+	lpushed_t status;
+	luahandle_t *userdata;
+
+	if (!data)
+	{
+		lua_pushnil(L);
+		return LPUSHED_NIL;
+	}
+
+	if (*ref > 0)
+	{
+		lua_rawgeti(L, LUA_REGISTRYINDEX, *ref);
+		if (lua_type(L, -1) == LUA_TUSERDATA)
+		{
+			userdata = lua_touserdata(L, -1);
+			if (userdata->data == data)
+				return LPUSHED_EXISTING;
+		}
+		lua_pop(L, 1);
+	}
+
+	status = LUA_RawPushUserdata(L, data);
+
+	userdata = lua_touserdata(L, -1);
+	if (!userdata->ref)
+	{
+		lua_pushvalue(L, -1);
+		userdata->ref = luaL_ref(L, LUA_REGISTRYINDEX);
+	}
+	*ref = userdata->ref;
+
+	return status;
+}
+
+void LUA_PushMobj(lua_State *L, mobj_t *mobj)
+{
+	LUA_PushHandle(L, mobj, mobj ? &mobj->luaref : NULL, META_MOBJ);
+}
+
+void LUA_PushPlayer(lua_State *L, player_t *player)
+{
+	LUA_PushHandle(L, player, player ? &player->luaref : NULL, META_PLAYER);
+}
+
+void LUA_PushSector(lua_State *L, sector_t *sector)
+{
+	LUA_PushHandle(L, sector, sector ? &sector->luaref : NULL, META_SECTOR);
+}
+
 // When userdata is freed, use this function to remove it from Lua.
 void LUA_InvalidateUserdata(void *data)
 {
-	void **userdata;
+	luahandle_t *userdata;
 	if (!gL)
 		return;
 
@@ -1159,7 +1442,12 @@ void LUA_InvalidateUserdata(void *data)
 
 			// invalidate the userdata
 			userdata = lua_touserdata(gL, -1);
-			*userdata = NULL;
+			userdata->data = NULL;
+			if (userdata->ref)
+			{
+				luaL_unref(gL, LUA_REGISTRYINDEX, userdata->ref);
+				userdata->ref = 0;
+			}
 		lua_pop(gL, 1);
 
 		// remove it from the registry
@@ -1188,6 +1476,7 @@ void LUA_InvalidateLevel(void)
 	for (i = 0; i < numsectors; i++)
 	{
 		LUA_InvalidateUserdata(&sectors[i]);
+		sectors[i].luaref = 0;
 		LUA_InvalidateUserdata(&sectors[i].lines);
 		LUA_InvalidateUserdata(&sectors[i].tags);
 		if (sectors[i].ffloors)
@@ -1253,20 +1542,32 @@ void LUA_InvalidatePlayer(player_t *player)
 	if (!gL)
 		return;
 	LUA_InvalidateUserdata(player);
+	player->luaref = 0;
 	LUA_InvalidateUserdata(player->powers);
 	LUA_InvalidateUserdata(&player->cmd);
 }
 
+// Bump this whenever the encoding below changes.
+#define LUA_ARCHIVEVERSION 2
+
+// Strings and tables are only written out in full the first time they
+// are seen; after that they are referred to by ID. Both maps live in the
+// tables table on the stack: tables[id] = table and tables[table] = id
+// for tables, tables[string] = id on the archiving side and
+// tables[-id] = string on the unarchiving side for strings.
+// Counts and indexes are written as variable length integers.
+static UINT32 archivetables; // table IDs handed out
+static UINT32 archivestrings; // string IDs handed out
+
 enum
 {
 	ARCH_NULL=0,
 	ARCH_TRUE,
 	ARCH_FALSE,
 	ARCH_INT8,
-	ARCH_INT16,
-	ARCH_INT32,
-	ARCH_SMALLSTRING,
-	ARCH_LARGESTRING,
+	ARCH_VARINT,
+	ARCH_STRING,
+	ARCH_STRINGREF,
 	ARCH_TABLE,
 
 	ARCH_MOBJINFO,
@@ -1340,10 +1641,70 @@ static UINT8 GetUserdataArchType(int index)
 	return ARCH_NULL;
 }
 
+// 7 bits per byte, least significant first, high bit set on all but the last
+static void WriteArchiveVarint(UINT32 value)
+{
+	while (value >= 0x80)
+	{
+		WRITEUINT8(save_p, (value & 0x7F) | 0x80);
+		value >>= 7;
+	}
+	WRITEUINT8(save_p, value);
+}
+
+static UINT32 ReadArchiveVarint(void)
+{
+	UINT32 value = 0;
+	INT32 shift = 0;
+	UINT8 byte;
+
+	do
+	{
+		byte = READUINT8(save_p);
+		if (shift < 32)
+			value |= (UINT32)(byte & 0x7F) << shift;
+		shift += 7;
+	} while (byte & 0x80);
+
+	return value;
+}
+
+// Writes a string the first time it is seen and its ID afterwards.
+static void ArchiveString(int TABLESINDEX, int myindex)
+{
+	size_t len;
+	const char *s;
+
+	lua_pushvalue(gL, myindex);
+	lua_rawget(gL, TABLESINDEX);
+	if (lua_isnumber(gL, -1))
+	{
+		WRITEUINT8(save_p, ARCH_STRINGREF);
+		WriteArchiveVarint((UINT32)lua_tointeger(gL, -1));
+		lua_pop(gL, 1);
+		return;
+	}
+	lua_pop(gL, 1);
+
+	// Lua strings can have embedded zeros, so the length is written
+	// out instead of a terminator.
+	s = lua_tolstring(gL, myindex, &len);
+	WRITEUINT8(save_p, ARCH_STRING);
+	WriteArchiveVarint((UINT32)len);
+	P_SaveBufferReserve(len + 64);
+	M_Memcpy(save_p, s, len);
+	save_p += len;
+
+	lua_pushvalue(gL, myindex);
+	lua_pushinteger(gL, ++archivestrings);
+	lua_rawset(gL, TABLESINDEX);
+}
+
 static UINT8 ArchiveValue(int TABLESINDEX, int myindex)
 {
 	if (myindex < 0)
 		myindex = lua_gettop(gL)+1+myindex;
+	P_SaveBufferReserve(64); // tag, number or string header, table metadata
 	switch (lua_type(gL, myindex))
 	{
 	case LUA_TNONE:
@@ -1361,88 +1722,49 @@ static UINT8 ArchiveValue(int TABLESINDEX, int myindex)
 		break;
 	case LUA_TNUMBER:
 	{
-		lua_Integer number = lua_tointeger(gL, myindex);
+		INT32 number = (INT32)lua_tointeger(gL, myindex);
 		if (number >= INT8_MIN && number <= INT8_MAX)
 		{
 			WRITEUINT8(save_p, ARCH_INT8);
 			WRITESINT8(save_p, number);
 		}
-		else if (number >= INT16_MIN && number <= INT16_MAX)
-		{
-			WRITEUINT8(save_p, ARCH_INT16);
-			WRITEINT16(save_p, number);
-		}
 		else
 		{
-			WRITEUINT8(save_p, ARCH_INT32);
-			WRITEFIXED(save_p, number);
+			// zigzag, so small negative numbers stay short
+			WRITEUINT8(save_p, ARCH_VARINT);
+			WriteArchiveVarint(((UINT32)number << 1) ^ (UINT32)(number >> 31));
 		}
 		break;
 	}
 	case LUA_TSTRING:
-	{
-		UINT32 len = (UINT32)lua_objlen(gL, myindex); // get length of string, including embedded zeros
-		const char *s = lua_tostring(gL, myindex);
-		UINT32 i = 0;
-		// if you're wondering why we're writing a string to save_p this way,
-		// it turns out that Lua can have embedded zeros ('\0') in the strings,
-		// so we can't use WRITESTRING as that cuts off when it finds a '\0'.
-		// Saving the size of the string also allows us to get the size of the string on the other end,
-		// fixing the awful crashes previously encountered for reading strings longer than 1024
-		// (yes I know that's kind of a stupid thing to care about, but it'd be evil to trim or ignore them?)
-		// -- Monster Iestyn 05/08/18
-		if (len < 255)
-		{
-			WRITEUINT8(save_p, ARCH_SMALLSTRING);
-			WRITEUINT8(save_p, len); // save size of string
-		}
-		else
-		{
-			WRITEUINT8(save_p, ARCH_LARGESTRING);
-			WRITEUINT32(save_p, len); // save size of string
-		}
-		while (i < len)
-			WRITECHAR(save_p, s[i++]); // write chars individually, including the embedded zeros
+		ArchiveString(TABLESINDEX, myindex);
 		break;
-	}
 	case LUA_TTABLE:
 	{
-		boolean found = false;
-		INT32 i;
-		UINT16 t = (UINT16)lua_objlen(gL, TABLESINDEX);
+		UINT32 t;
 
-		for (i = 1; i <= t && !found; i++)
+		lua_pushvalue(gL, myindex);
+		lua_rawget(gL, TABLESINDEX);
+		if (lua_isnumber(gL, -1))
 		{
-			lua_rawgeti(gL, TABLESINDEX, i);
-			if (lua_rawequal(gL, myindex, -1))
-			{
-				t = i;
-				found = true;
-			}
+			WRITEUINT8(save_p, ARCH_TABLE);
+			WriteArchiveVarint((UINT32)lua_tointeger(gL, -1));
 			lua_pop(gL, 1);
+			break;
 		}
-		if (!found)
-		{
-			t++;
-
-			if (t == 0)
-			{
-				CONS_Alert(CONS_ERROR, "Too many tables to archive!\n");
-				WRITEUINT8(save_p, ARCH_NULL);
-				return 0;
-			}
-		}
+		lua_pop(gL, 1);
 
+		// new table, ArchiveTables will write its contents
+		t = ++archivetables;
 		WRITEUINT8(save_p, ARCH_TABLE);
-		WRITEUINT16(save_p, t);
+		WriteArchiveVarint(t);
 
-		if (!found)
-		{
-			lua_pushvalue(gL, myindex);
-			lua_rawseti(gL, TABLESINDEX, t);
-			return 1;
-		}
-		break;
+		lua_pushvalue(gL, myindex);
+		lua_rawseti(gL, TABLESINDEX, t);
+		lua_pushvalue(gL, myindex);
+		lua_pushinteger(gL, t);
+		lua_rawset(gL, TABLESINDEX);
+		return 1;
 	}
 	case LUA_TUSERDATA:
 		switch (GetUserdataArchType(myindex))
@@ -1451,14 +1773,14 @@ static UINT8 ArchiveValue(int TABLESINDEX, int myindex)
 		{
 			mobjinfo_t *info = *((mobjinfo_t **)lua_touserdata(gL, myindex));
 			WRITEUINT8(save_p, ARCH_MOBJINFO);
-			WRITEUINT16(save_p, info - mobjinfo);
+			WriteArchiveVarint(info - mobjinfo);
 			break;
 		}
 		case ARCH_STATE:
 		{
 			state_t *state = *((state_t **)lua_touserdata(gL, myindex));
 			WRITEUINT8(save_p, ARCH_STATE);
-			WRITEUINT16(save_p, state - states);
+			WriteArchiveVarint(state - states);
 			break;
 		}
 		case ARCH_MOBJ:
@@ -1468,7 +1790,7 @@ static UINT8 ArchiveValue(int TABLESINDEX, int myindex)
 				WRITEUINT8(save_p, ARCH_NULL);
 			else {
 				WRITEUINT8(save_p, ARCH_MOBJ);
-				WRITEUINT32(save_p, mobj->mobjnum);
+				WriteArchiveVarint(mobj->mobjnum);
 			}
 			break;
 		}
@@ -1490,7 +1812,7 @@ static UINT8 ArchiveValue(int TABLESINDEX, int myindex)
 				WRITEUINT8(save_p, ARCH_NULL);
 			else {
 				WRITEUINT8(save_p, ARCH_MAPTHING);
-				WRITEUINT16(save_p, mapthing - mapthings);
+				WriteArchiveVarint(mapthing - mapthings);
 			}
 			break;
 		}
@@ -1501,7 +1823,7 @@ static UINT8 ArchiveValue(int TABLESINDEX, int myindex)
 				WRITEUINT8(save_p, ARCH_NULL);
 			else {
 				WRITEUINT8(save_p, ARCH_VERTEX);
-				WRITEUINT16(save_p, vertex - vertexes);
+				WriteArchiveVarint(vertex - vertexes);
 			}
 			break;
 		}
@@ -1512,7 +1834,7 @@ static UINT8 ArchiveValue(int TABLESINDEX, int myindex)
 				WRITEUINT8(save_p, ARCH_NULL);
 			else {
 				WRITEUINT8(save_p, ARCH_LINE);
-				WRITEUINT16(save_p, line - lines);
+				WriteArchiveVarint(line - lines);
 			}
 			break;
 		}
@@ -1523,7 +1845,7 @@ static UINT8 ArchiveValue(int TABLESINDEX, int myindex)
 				WRITEUINT8(save_p, ARCH_NULL);
 			else {
 				WRITEUINT8(save_p, ARCH_SIDE);
-				WRITEUINT16(save_p, side - sides);
+				WriteArchiveVarint(side - sides);
 			}
 			break;
 		}
@@ -1534,7 +1856,7 @@ static UINT8 ArchiveValue(int TABLESINDEX, int myindex)
 				WRITEUINT8(save_p, ARCH_NULL);
 			else {
 				WRITEUINT8(save_p, ARCH_SUBSECTOR);
-				WRITEUINT16(save_p, subsector - subsectors);
+				WriteArchiveVarint(subsector - subsectors);
 			}
 			break;
 		}
@@ -1545,7 +1867,7 @@ static UINT8 ArchiveValue(int TABLESINDEX, int myindex)
 				WRITEUINT8(save_p, ARCH_NULL);
 			else {
 				WRITEUINT8(save_p, ARCH_SECTOR);
-				WRITEUINT16(save_p, sector - sectors);
+				WriteArchiveVarint(sector - sectors);
 			}
 			break;
 		}
@@ -1557,7 +1879,7 @@ static UINT8 ArchiveValue(int TABLESINDEX, int myindex)
 				WRITEUINT8(save_p, ARCH_NULL);
 			else {
 				WRITEUINT8(save_p, ARCH_SEG);
-				WRITEUINT16(save_p, seg - segs);
+				WriteArchiveVarint(seg - segs);
 			}
 			break;
 		}
@@ -1568,7 +1890,7 @@ static UINT8 ArchiveValue(int TABLESINDEX, int myindex)
 				WRITEUINT8(save_p, ARCH_NULL);
 			else {
 				WRITEUINT8(save_p, ARCH_NODE);
-				WRITEUINT16(save_p, node - nodes);
+				WriteArchiveVarint(node - nodes);
 			}
 			break;
 		}
@@ -1585,8 +1907,8 @@ static UINT8 ArchiveValue(int TABLESINDEX, int myindex)
 				else
 				{
 					WRITEUINT8(save_p, ARCH_FFLOOR);
-					WRITEUINT16(save_p, rover->target - sectors);
-					WRITEUINT16(save_p, i);
+					WriteArchiveVarint(rover->target - sectors);
+					WriteArchiveVarint(i);
 				}
 			}
 			break;
@@ -1598,7 +1920,7 @@ static UINT8 ArchiveValue(int TABLESINDEX, int myindex)
 				WRITEUINT8(save_p, ARCH_NULL);
 			else {
 				WRITEUINT8(save_p, ARCH_POLYOBJ);
-				WRITEUINT16(save_p, polyobj-PolyObjects);
+				WriteArchiveVarint(polyobj-PolyObjects);
 			}
 			break;
 		}
@@ -1609,7 +1931,7 @@ static UINT8 ArchiveValue(int TABLESINDEX, int myindex)
 				WRITEUINT8(save_p, ARCH_NULL);
 			else {
 				WRITEUINT8(save_p, ARCH_SLOPE);
-				WRITEUINT16(save_p, slope->id);
+				WriteArchiveVarint(slope->id);
 			}
 			break;
 		}
@@ -1620,7 +1942,7 @@ static UINT8 ArchiveValue(int TABLESINDEX, int myindex)
 				WRITEUINT8(save_p, ARCH_NULL);
 			else {
 				WRITEUINT8(save_p, ARCH_MAPHEADER);
-				WRITEUINT16(save_p, header - *mapheaderinfo);
+				WriteArchiveVarint(header - *mapheaderinfo);
 			}
 			break;
 		}
@@ -1628,14 +1950,14 @@ static UINT8 ArchiveValue(int TABLESINDEX, int myindex)
 		{
 			skincolor_t *info = *((skincolor_t **)lua_touserdata(gL, myindex));
 			WRITEUINT8(save_p, ARCH_SKINCOLOR);
-			WRITEUINT16(save_p, info - skincolors);
+			WriteArchiveVarint(info - skincolors);
 			break;
 		}
 		case ARCH_MOUSE:
 		{
 			mouse_t *m = *((mouse_t **)lua_touserdata(gL, myindex));
 			WRITEUINT8(save_p, ARCH_MOUSE);
-			WRITEUINT8(save_p, m == &mouse ? 1 : 2);
+			WriteArchiveVarint(m == &mouse ? 1 : 2);
 			break;
 		}
 		default:
@@ -1654,7 +1976,7 @@ static void ArchiveExtVars(void *pointer, const char *ptype)
 
 	if (!gL) {
 		if (fastcmp(ptype,"player")) // players must always be included, even if no vars
-			WRITEUINT16(save_p, 0);
+			WriteArchiveVarint(0);
 		return;
 	}
 
@@ -1670,7 +1992,7 @@ static void ArchiveExtVars(void *pointer, const char *ptype)
 	{ // no extra values table
 		lua_pop(gL, 1);
 		if (fastcmp(ptype,"player")) // players must always be included, even if no vars
-			WRITEUINT16(save_p, 0);
+			WriteArchiveVarint(0);
 		return;
 	}
 
@@ -1682,19 +2004,21 @@ static void ArchiveExtVars(void *pointer, const char *ptype)
 	if (i == 0)
 	{
 		if (fastcmp(ptype,"player")) // always include players even if they have no extra variables
-			WRITEUINT16(save_p, 0);
+			WriteArchiveVarint(0);
 		lua_pop(gL, 1);
 		return;
 	}
 
+	P_SaveBufferReserve(64);
 	if (fastcmp(ptype,"mobj")) // mobjs must write their mobjnum as a header
-		WRITEUINT32(save_p, ((mobj_t *)pointer)->mobjnum);
-	WRITEUINT16(save_p, i);
+		WriteArchiveVarint(((mobj_t *)pointer)->mobjnum);
+	WriteArchiveVarint(i);
 	lua_pushnil(gL);
 	while (lua_next(gL, -2))
 	{
 		I_Assert(lua_type(gL, -2) == LUA_TSTRING);
-		WRITESTRING(save_p, lua_tostring(gL, -2));
+		// the same few field names show up on every mobj
+		ArchiveValue(TABLESINDEX, -2);
 		if (ArchiveValue(TABLESINDEX, -1) == 2)
 			CONS_Alert(CONS_ERROR, "Type of value for %s entry '%s' (%s) could not be archived!\n", ptype, lua_tostring(gL, -2), luaL_typename(gL, -1));
 		lua_pop(gL, 1);
@@ -1715,7 +2039,7 @@ static int NetArchive(lua_State *L)
 static void ArchiveTables(void)
 {
 	int TABLESINDEX;
-	UINT16 i, n;
+	UINT32 i;
 	UINT8 e;
 
 	if (!gL)
@@ -1723,8 +2047,8 @@ static void ArchiveTables(void)
 
 	TABLESINDEX = lua_gettop(gL);
 
-	n = (UINT16)lua_objlen(gL, TABLESINDEX);
-	for (i = 1; i <= n; i++)
+	// archivetables grows as tables inside these tables are found
+	for (i = 1; i <= archivetables; i++)
 	{
 		lua_rawgeti(gL, TABLESINDEX, i);
 		lua_pushnil(gL);
@@ -1736,13 +2060,12 @@ static void ArchiveTables(void)
 				CONS_Alert(CONS_ERROR, "Index '%s' (%s) of table %d could not be archived!\n", lua_tostring(gL, -2), luaL_typename(gL, -2), i);
 			// Write value
 			e = ArchiveValue(TABLESINDEX, -1);
-			if (e == 1)
-				n++; // the table contained a new table we'll have to archive. :(
-			else if (e == 2) // invalid value type
+			if (e == 2) // invalid value type
 				CONS_Alert(CONS_ERROR, "Type of value for table %d entry '%s' (%s) could not be archived!\n", i, lua_tostring(gL, -2), luaL_typename(gL, -1));
 
 			lua_pop(gL, 1);
 		}
+		P_SaveBufferReserve(64);
 		WRITEUINT8(save_p, ARCH_TEND);
 
 		// Write metatable ID
@@ -1752,11 +2075,11 @@ static void ArchiveTables(void)
 			lua_getfield(gL, LUA_REGISTRYINDEX, LREG_METATABLES);
 			lua_pushvalue(gL, -2);
 			lua_gettable(gL, -2);
-			WRITEUINT16(save_p, lua_isnil(gL, -1) ? 0 : lua_tointeger(gL, -1));
+			WriteArchiveVarint(lua_isnil(gL, -1) ? 0 : (UINT32)lua_tointeger(gL, -1));
 			lua_pop(gL, 3);
 		}
 		else
-			WRITEUINT16(save_p, 0);
+			WriteArchiveVarint(0);
 
 		lua_pop(gL, 1);
 	}
@@ -1779,38 +2102,27 @@ static UINT8 UnArchiveValue(int TABLESINDEX)
 	case ARCH_INT8:
 		lua_pushinteger(gL, READSINT8(save_p));
 		break;
-	case ARCH_INT16:
-		lua_pushinteger(gL, READINT16(save_p));
-		break;
-	case ARCH_INT32:
-		lua_pushinteger(gL, READFIXED(save_p));
+	case ARCH_VARINT:
+	{
+		UINT32 zigzag = ReadArchiveVarint();
+		lua_pushinteger(gL, (INT32)(zigzag >> 1) ^ -(INT32)(zigzag & 1));
 		break;
-	case ARCH_SMALLSTRING:
-	case ARCH_LARGESTRING:
-	{
-		UINT32 len;
-		char *value;
-		UINT32 i = 0;
-
-		// See my comments in the ArchiveValue function;
-		// it's much the same for reading strings as writing them!
-		// (i.e. we can't use READSTRING either)
-		// -- Monster Iestyn 05/08/18
-		if (type == ARCH_SMALLSTRING)
-			len = READUINT8(save_p); // length of string, including embedded zeros
-		else
-			len = READUINT32(save_p); // length of string, including embedded zeros
-		value = malloc(len); // make temp buffer of size len
-		// now read the actual string
-		while (i < len)
-			value[i++] = READCHAR(save_p); // read chars individually, including the embedded zeros
-		lua_pushlstring(gL, value, len); // push the string (note: this function supports embedded zeros)
-		free(value); // free the buffer
+	}
+	case ARCH_STRING:
+	{
+		UINT32 len = ReadArchiveVarint();
+		lua_pushlstring(gL, (const char *)save_p, len);
+		save_p += len;
+		lua_pushvalue(gL, -1);
+		lua_rawseti(gL, TABLESINDEX, -(int)++archivestrings);
 		break;
 	}
+	case ARCH_STRINGREF:
+		lua_rawgeti(gL, TABLESINDEX, -(int)ReadArchiveVarint());
+		break;
 	case ARCH_TABLE:
 	{
-		UINT16 tid = READUINT16(save_p);
+		UINT32 tid = ReadArchiveVarint();
 		lua_rawgeti(gL, TABLESINDEX, tid);
 		if (lua_isnil(gL, -1))
 		{
@@ -1818,71 +2130,73 @@ static UINT8 UnArchiveValue(int TABLESINDEX)
 			lua_newtable(gL);
 			lua_pushvalue(gL, -1);
 			lua_rawseti(gL, TABLESINDEX, tid);
+			if (tid > archivetables)
+				archivetables = tid;
 			return 2;
 		}
 		break;
 	}
 	case ARCH_MOBJINFO:
-		LUA_PushUserdata(gL, &mobjinfo[READUINT16(save_p)], META_MOBJINFO);
+		LUA_PushUserdata(gL, &mobjinfo[ReadArchiveVarint()], META_MOBJINFO);
 		break;
 	case ARCH_STATE:
-		LUA_PushUserdata(gL, &states[READUINT16(save_p)], META_STATE);
+		LUA_PushUserdata(gL, &states[ReadArchiveVarint()], META_STATE);
 		break;
 	case ARCH_MOBJ:
-		LUA_PushUserdata(gL, P_FindNewPosition(READUINT32(save_p)), META_MOBJ);
+		LUA_PushMobj(gL, P_FindNewPosition(ReadArchiveVarint()));
 		break;
 	case ARCH_PLAYER:
-		LUA_PushUserdata(gL, &players[READUINT8(save_p)], META_PLAYER);
+		LUA_PushPlayer(gL, &players[READUINT8(save_p)]);
 		break;
 	case ARCH_MAPTHING:
-		LUA_PushUserdata(gL, &mapthings[READUINT16(save_p)], META_MAPTHING);
+		LUA_PushUserdata(gL, &mapthings[ReadArchiveVarint()], META_MAPTHING);
 		break;
 	case ARCH_VERTEX:
-		LUA_PushUserdata(gL, &vertexes[READUINT16(save_p)], META_VERTEX);
+		LUA_PushUserdata(gL, &vertexes[ReadArchiveVarint()], META_VERTEX);
 		break;
 	case ARCH_LINE:
-		LUA_PushUserdata(gL, &lines[READUINT16(save_p)], META_LINE);
+		LUA_PushUserdata(gL, &lines[ReadArchiveVarint()], META_LINE);
 		break;
 	case ARCH_SIDE:
-		LUA_PushUserdata(gL, &sides[READUINT16(save_p)], META_SIDE);
+		LUA_PushUserdata(gL, &sides[ReadArchiveVarint()], META_SIDE);
 		break;
 	case ARCH_SUBSECTOR:
-		LUA_PushUserdata(gL, &subsectors[READUINT16(save_p)], META_SUBSECTOR);
+		LUA_PushUserdata(gL, &subsectors[ReadArchiveVarint()], META_SUBSECTOR);
 		break;
 	case ARCH_SECTOR:
-		LUA_PushUserdata(gL, &sectors[READUINT16(save_p)], META_SECTOR);
+		LUA_PushSector(gL, &sectors[ReadArchiveVarint()]);
 		break;
 #ifdef HAVE_LUA_SEGS
 	case ARCH_SEG:
-		LUA_PushUserdata(gL, &segs[READUINT16(save_p)], META_SEG);
+		LUA_PushUserdata(gL, &segs[ReadArchiveVarint()], META_SEG);
 		break;
 	case ARCH_NODE:
-		LUA_PushUserdata(gL, &nodes[READUINT16(save_p)], META_NODE);
+		LUA_PushUserdata(gL, &nodes[ReadArchiveVarint()], META_NODE);
 		break;
 #endif
 	case ARCH_FFLOOR:
 	{
-		sector_t *sector = &sectors[READUINT16(save_p)];
-		UINT16 id = READUINT16(save_p);
+		sector_t *sector = &sectors[ReadArchiveVarint()];
+		UINT16 id = ReadArchiveVarint();
 		ffloor_t *rover = P_GetFFloorByID(sector, id);
 		if (rover)
 			LUA_PushUserdata(gL, rover, META_FFLOOR);
 		break;
 	}
 	case ARCH_POLYOBJ:
-		LUA_PushUserdata(gL, &PolyObjects[READUINT16(save_p)], META_POLYOBJ);
+		LUA_PushUserdata(gL, &PolyObjects[ReadArchiveVarint()], META_POLYOBJ);
 		break;
 	case ARCH_SLOPE:
-		LUA_PushUserdata(gL, P_SlopeById(READUINT16(save_p)), META_SLOPE);
+		LUA_PushUserdata(gL, P_SlopeById(ReadArchiveVarint()), META_SLOPE);
 		break;
 	case ARCH_MAPHEADER:
-		LUA_PushUserdata(gL, mapheaderinfo[READUINT16(save_p)], META_MAPHEADER);
+		LUA_PushUserdata(gL, mapheaderinfo[ReadArchiveVarint()], META_MAPHEADER);
 		break;
 	case ARCH_SKINCOLOR:
-		LUA_PushUserdata(gL, &skincolors[READUINT16(save_p)], META_SKINCOLOR);
+		LUA_PushUserdata(gL, &skincolors[ReadArchiveVarint()], META_SKINCOLOR);
 		break;
 	case ARCH_MOUSE:
-		LUA_PushUserdata(gL, READUINT16(save_p) == 1 ? &mouse : &mouse2, META_MOUSE);
+		LUA_PushUserdata(gL, ReadArchiveVarint() == 1 ? &mouse : &mouse2, META_MOUSE);
 		break;
 	case ARCH_TEND:
 		return 1;
@@ -1893,9 +2207,8 @@ static UINT8 UnArchiveValue(int TABLESINDEX)
 static void UnArchiveExtVars(void *pointer)
 {
 	int TABLESINDEX;
-	UINT16 field_count = READUINT16(save_p);
-	UINT16 i;
-	char field[1024];
+	UINT32 field_count = ReadArchiveVarint();
+	UINT32 i;
 
 	if (field_count == 0)
 		return;
@@ -1906,9 +2219,16 @@ static void UnArchiveExtVars(void *pointer)
 
 	for (i = 0; i < field_count; i++)
 	{
-		READSTRING(save_p, field);
+		UnArchiveValue(TABLESINDEX); // field name
 		UnArchiveValue(TABLESINDEX);
-		lua_setfield(gL, -2, field);
+		lua_rawset(gL, -3);
+	}
+
+	if (!pointer)
+	{
+		// the mobj these belonged to is gone
+		lua_pop(gL, 1);
+		return;
 	}
 
 	lua_getfield(gL, LUA_REGISTRYINDEX, LREG_EXTVARS);
@@ -1931,24 +2251,23 @@ static int NetUnArchive(lua_State *L)
 static void UnArchiveTables(void)
 {
 	int TABLESINDEX;
-	UINT16 i, n;
-	UINT16 metatableid;
+	UINT32 i;
+	UINT32 metatableid;
 
 	if (!gL)
 		return;
 
 	TABLESINDEX = lua_gettop(gL);
 
-	n = (UINT16)lua_objlen(gL, TABLESINDEX);
-	for (i = 1; i <= n; i++)
+	// archivetables grows as new tables are read
+	for (i = 1; i <= archivetables; i++)
 	{
 		lua_rawgeti(gL, TABLESINDEX, i);
 		while (true)
 		{
 			if (UnArchiveValue(TABLESINDEX) == 1) // read key
 				break;
-			if (UnArchiveValue(TABLESINDEX) == 2) // read value
-				n++;
+			UnArchiveValue(TABLESINDEX); // read value
 			if (lua_isnil(gL, -2)) // if key is nil (if a function etc was accidentally saved)
 			{
 				CONS_Alert(CONS_ERROR, "A nil key in table %d was found! (Invalid key type or corrupted save?)\n", i);
@@ -1958,7 +2277,7 @@ static void UnArchiveTables(void)
 				lua_rawset(gL, -3);
 		}
 
-		metatableid = READUINT16(save_p);
+		metatableid = ReadArchiveVarint();
 		if (metatableid)
 		{
 			// setmetatable(table, registry.metatables[metatableid])
@@ -1974,12 +2293,70 @@ static void UnArchiveTables(void)
 	}
 }
 
+void LUA_GCTuning_OnChange(void)
+{
+	// Called once more when the state is created; the cvars
+	// may not be registered yet if that happens early.
+	if (!gL || !cv_luagcpause.value)
+		return;
+	lua_gc(gL, LUA_GCSETPAUSE, cv_luagcpause.value);
+	lua_gc(gL, LUA_GCSETSTEPMUL, cv_luagcstepmul.value);
+}
+
+// Does incremental collection work between tics, so the collector
+// rarely has to step inside a tic when allocations cross its threshold.
+// A cycle is only started once the heap has grown by luagc_pause percent
+// since the last one, the same point the collector would start it on its
+// own; an explicit step would otherwise begin a new cycle every frame.
+// Steps until the cycle finishes, the luagc_budget runs out, or the
+// next tic is due, whichever comes first. At least one step is always
+// taken so collection keeps up even on a loaded machine.
 void LUA_Step(void)
 {
+	precise_t start, budget, left;
+	INT32 steps = 0;
+
 	if (!gL)
 		return;
 	lua_settop(gL, 0);
-	lua_gc(gL, LUA_GCSTEP, 1);
+
+	if (!gccycleactive)
+	{
+		INT32 count = lua_gc(gL, LUA_GCCOUNT, 0);
+
+		// a smaller heap means the collector finished a cycle by itself
+		if (count < gcestimate)
+			gcestimate = count;
+
+		if ((INT64)count * 100 < (INT64)gcestimate * cv_luagcpause.value)
+		{
+			ps_lua_gctime.value.p = 0;
+			ps_lua_gcsteps.value.i = 0;
+			return;
+		}
+		gccycleactive = true;
+	}
+
+	start = I_GetPreciseTime();
+	budget = (precise_t)cv_luagcbudget.value * (I_GetPrecisePrecision() / 1000000);
+	left = I_GetTimeToNextTic();
+	if (left < budget)
+		budget = left;
+
+	do
+	{
+		steps++;
+		if (lua_gc(gL, LUA_GCSTEP, cv_luagcstepsize.value))
+		{
+			ps_lua_gccycles.value.i++;
+			gccycleactive = false;
+			gcestimate = lua_gc(gL, LUA_GCCOUNT, 0);
+			break;
+		}
+	} while (I_GetPreciseTime() - start < budget);
+
+	ps_lua_gctime.value.p = I_GetPreciseTime() - start;
+	ps_lua_gcsteps.value.i = steps;
 }
 
 void LUA_Archive(void)
@@ -1987,6 +2364,10 @@ void LUA_Archive(void)
 	INT32 i;
 	thinker_t *th;
 
+	P_SaveBufferReserve(1);
+	WRITEUINT8(save_p, LUA_ARCHIVEVERSION);
+
+	archivetables = archivestrings = 0;
 	if (gL)
 		lua_newtable(gL); // tables to be archived.
 
@@ -2008,7 +2389,8 @@ void LUA_Archive(void)
 		ArchiveExtVars(th, "mobj");
 	}
 
-	WRITEUINT32(save_p, UINT32_MAX); // end of mobjs marker, replaces mobjnum.
+	P_SaveBufferReserve(8);
+	WriteArchiveVarint(UINT32_MAX); // end of mobjs marker, replaces mobjnum.
 
 	LUA_HookNetArchive(NetArchive); // call the NetArchive hook in archive mode
 	ArchiveTables();
@@ -2017,12 +2399,20 @@ void LUA_Archive(void)
 		lua_pop(gL, 1); // pop tables
 }
 
-void LUA_UnArchive(void)
+boolean LUA_UnArchive(void)
 {
 	UINT32 mobjnum;
 	INT32 i;
-	thinker_t *th;
+	thinker_t *th, *start;
+	UINT8 version = READUINT8(save_p);
+
+	if (version != LUA_ARCHIVEVERSION)
+	{
+		CONS_Alert(CONS_ERROR, M_GetText("Lua archive version %d does not match this build's (%d)\n"), version, LUA_ARCHIVEVERSION);
+		return false;
+	}
 
+	archivetables = archivestrings = 0;
 	if (gL)
 		lua_newtable(gL); // tables to be read
 
@@ -2033,35 +2423,109 @@ void LUA_UnArchive(void)
 		UnArchiveExtVars(&players[i]);
 	}
 
-	do {
-		mobjnum = READUINT32(save_p); // read a mobjnum
-		for (th = thlist[THINK_MOBJ].next; th != &thlist[THINK_MOBJ]; th = th->next)
+	// Mobjs were written in thinker order, so each search picks up where
+	// the last one stopped instead of starting over from the list head.
+	th = &thlist[THINK_MOBJ];
+	while ((mobjnum = ReadArchiveVarint()) != UINT32_MAX) // until end of mobjs marker
+	{
+		start = th;
+		do
 		{
-			if (th->function.acp1 == (actionf_p1)P_RemoveThinkerDelayed)
+			th = th->next;
+			if (th == &thlist[THINK_MOBJ])
 				continue;
-			if (((mobj_t *)th)->mobjnum != mobjnum) // find matching mobj
+			if (th->function.acp1 == (actionf_p1)P_RemoveThinkerDelayed)
 				continue;
+			if (((mobj_t *)th)->mobjnum == mobjnum) // find matching mobj
+				break;
+		} while (th != start);
+
+		if (th != &thlist[THINK_MOBJ] && ((mobj_t *)th)->mobjnum == mobjnum)
 			UnArchiveExtVars(th); // apply variables
-		}
-	} while(mobjnum != UINT32_MAX); // repeat until end of mobjs marker.
+		else
+			UnArchiveExtVars(NULL); // mobj is gone, skip its variables
+	}
 
 	LUA_HookNetArchive(NetUnArchive); // call the NetArchive hook in unarchive mode
 	UnArchiveTables();
 
 	if (gL)
 		lua_pop(gL, 1); // pop tables
+	return true;
+}
+
+// Pushes a table mapping each name in lst to its index.
+// It is built the first time and kept in the registry, so looking a
+// field up is a hash of the already interned key string instead of a
+// string compare against every name.
+static void Lua_PushOptionTable(lua_State *L, const char *const lst[])
+{
+	size_t slot = ((uintptr_t)lst >> 3) & (MAXOPTIONTABLES - 1);
+	int i;
+
+	for (; optiontables[slot].lst; slot = (slot + 1) & (MAXOPTIONTABLES - 1))
+		if (optiontables[slot].lst == lst)
+		{
+			lua_rawgeti(L, LUA_REGISTRYINDEX, optiontables[slot].ref);
+			return;
+		}
+
+	for (i = 0; lst[i]; i++)
+		;
+	lua_createtable(L, 0, i);
+	while (i--) // backwards, so the first of duplicate names wins
+	{
+		lua_pushstring(L, lst[i]);
+		lua_pushinteger(L, i);
+		lua_rawset(L, -3);
+	}
+
+	// always leave a free slot to end the search on
+	if (numoptiontables < MAXOPTIONTABLES - 1)
+	{
+		lua_pushvalue(L, -1);
+		optiontables[slot].ref = luaL_ref(L, LUA_REGISTRYINDEX);
+		optiontables[slot].lst = lst;
+		numoptiontables++;
+	}
 }
 
 // For mobj_t, player_t, etc. to take custom variables.
+// Returns -1 if the name is not in lst.
 int Lua_optoption(lua_State *L, int narg,
 	const char *def, const char *const lst[])
 {
-	const char *name = (def) ? luaL_optstring(L, narg, def) :  luaL_checkstring(L, narg);
-	int i;
-	for (i=0; lst[i]; i++)
-		if (fastcmp(lst[i], name))
-			return i;
-	return -1;
+	int i = -1;
+
+	if (narg < 0)
+		narg = lua_gettop(L) + narg + 1;
+	if (def && lua_isnoneornil(L, narg))
+		lua_pushstring(L, def);
+	else
+	{
+		luaL_checkstring(L, narg);
+		lua_pushvalue(L, narg);
+	}
+
+	Lua_PushOptionTable(L, lst);
+	lua_pushvalue(L, -2);
+	lua_rawget(L, -2);
+	if (lua_isnumber(L, -1))
+		i = (int)lua_tointeger(L, -1);
+	lua_pop(L, 3);
+	return i;
+}
+
+// Same as luaL_checkoption, without comparing against every name.
+int Lua_checkoption(lua_State *L, int narg,
+	const char *def, const char *const lst[])
+{
+	int i = Lua_optoption(L, narg, def, lst);
+
+	if (i == -1)
+		return luaL_argerror(L, narg,
+			lua_pushfstring(L, "invalid option " LUA_QS, luaL_optstring(L, narg, def)));
+	return i;
 }
 
 void LUA_PushTaggableObjectArray
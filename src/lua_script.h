@@ -51,14 +51,17 @@ void LUA_DumpFile(const char *filename);
 #endif
 fixed_t LUA_EvalMath(const char *word);
 void LUA_Step(void);
+void LUA_GCTuning_OnChange(void);
 void LUA_Archive(void);
-void LUA_UnArchive(void);
+boolean LUA_UnArchive(void);
 int LUA_PushGlobals(lua_State *L, const char *word);
 int LUA_CheckGlobals(lua_State *L, const char *word);
 void Got_Luacmd(UINT8 **cp, INT32 playernum); // lua_consolelib.c
 void LUA_CVarChanged(void *cvar); // lua_consolelib.c
 int Lua_optoption(lua_State *L, int narg,
 	const char *def, const char *const lst[]);
+int Lua_checkoption(lua_State *L, int narg,
+	const char *def, const char *const lst[]);
 void LUA_HookNetArchive(lua_CFunction archFunc);
 
 void LUA_PushTaggableObjectArray
@@ -89,6 +92,13 @@ typedef enum {
 
 void LUA_PushUserdata(lua_State *L, void *data, const char *meta);
 lpushed_t LUA_RawPushUserdata(lua_State *L, void *data);
+void LUA_PushHandle(lua_State *L, void *data, INT32 *ref, const char *meta);
+lpushed_t LUA_RawPushHandle(lua_State *L, void *data, INT32 *ref);
+
+struct sector_s;
+void LUA_PushMobj(lua_State *L, mobj_t *mobj);
+void LUA_PushPlayer(lua_State *L, player_t *player);
+void LUA_PushSector(lua_State *L, struct sector_s *sector);
 
 void LUA_InvalidateUserdata(void *data);
 
@@ -98,7 +98,7 @@ static const char *const skin_opt[] = {
 static int skin_get(lua_State *L)
 {
 	skin_t *skin = *((skin_t **)luaL_checkudata(L, 1, META_SKIN));
-	enum skin field = luaL_checkoption(L, 2, NULL, skin_opt);
+	enum skin field = Lua_checkoption(L, 2, NULL, skin_opt);
 
 	// skins are always valid, only added, never removed
 	I_Assert(skin != NULL);
@@ -351,7 +351,7 @@ static int lib_numSkinsSprites(lua_State *L)
 static int sprite_get(lua_State *L)
 {
 	spritedef_t *sprite = *(spritedef_t **)luaL_checkudata(L, 1, META_SKINSPRITESLIST);
-	enum spritesopt field = luaL_checkoption(L, 2, NULL, sprites_opt);
+	enum spritesopt field = Lua_checkoption(L, 2, NULL, sprites_opt);
 
 	switch (field)
 	{
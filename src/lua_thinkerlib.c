@@ -29,6 +29,8 @@ static const actionf_p1 iter_funcs[] = {
 
 struct iterationState {
 	actionf_p1 filter;
+	mobjtype_t type; // MT_NULL matches any type
+	UINT32 flags; // all of these must be set
 	int next;
 };
 
@@ -45,11 +47,28 @@ static int iterationState_gc(lua_State *L)
 
 #define push_thinker(th) {\
 	if ((th)->function.acp1 == (actionf_p1)P_MobjThinker) \
-		LUA_PushUserdata(L, (th), META_MOBJ); \
+		LUA_PushMobj(L, (mobj_t *)(th)); \
 	else \
 		lua_pushlightuserdata(L, (th)); \
 }
 
+// Checked in C so that objects the script isn't interested in
+// never have to be pushed to Lua.
+static boolean iterationState_match(const struct iterationState *it, thinker_t *th)
+{
+	mobj_t *mo;
+
+	if (it->filter && th->function.acp1 != it->filter)
+		return false;
+	if (it->filter != (actionf_p1)P_MobjThinker)
+		return true;
+
+	mo = (mobj_t *)th;
+	if (it->type != MT_NULL && mo->type != it->type)
+		return false;
+	return (mo->flags & it->flags) == it->flags;
+}
+
 static int lib_iterateThinkers(lua_State *L)
 {
 	thinker_t *th = NULL, *next = NULL;
@@ -93,35 +112,137 @@ static int lib_iterateThinkers(lua_State *L)
 		return luaL_error(L, "next thinker invalidated during iteration");
 
 	for (; next != &thlist[THINK_MOBJ]; next = next->next)
-		if (!it->filter || next->function.acp1 == it->filter)
+		if (iterationState_match(it, next))
 		{
+			thinker_t *after;
+
 			push_thinker(next);
-			if (next->next != &thlist[THINK_MOBJ])
-			{
-				push_thinker(next->next);
-				it->next = luaL_ref(L, LUA_REGISTRYINDEX);
-			}
+
+			// Hold on to the next match in case this one
+			// is removed before the script asks for it.
+			for (after = next->next; after != &thlist[THINK_MOBJ]; after = after->next)
+				if (iterationState_match(it, after))
+				{
+					push_thinker(after);
+					it->next = luaL_ref(L, LUA_REGISTRYINDEX);
+					break;
+				}
 			return 1;
 		}
 	return 0;
 }
 
+// mobjs.iterate([type, [flags]])
+// Older scripts pass a thinker list name such as "mobj" first; that is
+// skipped, as it always has been.
 static int lib_startIterate(lua_State *L)
 {
 	struct iterationState *it;
+	const int arg = (lua_type(L, 1) == LUA_TSTRING) ? 2 : 1;
+	lua_Integer type = luaL_optinteger(L, arg, MT_NULL);
+	UINT32 flags = (UINT32)luaL_optinteger(L, arg + 1, 0);
 
 	INLEVEL
 
+	if (type < MT_NULL || type >= NUMMOBJTYPES)
+		return luaL_error(L, "mobj type %d out of range (0 - %d)", (int)type, NUMMOBJTYPES-1);
+
 	lua_pushvalue(L, lua_upvalueindex(1));
 	it = lua_newuserdata(L, sizeof(struct iterationState));
 	luaL_getmetatable(L, META_ITERATIONSTATE);
 	lua_setmetatable(L, -2);
 
-	it->filter = (actionf_p1)P_MobjThinker; //iter_funcs[luaL_checkoption(L, 1, "mobj", iter_opt)];
+	it->filter = (actionf_p1)P_MobjThinker; //iter_funcs[Lua_checkoption(L, 1, "mobj", iter_opt)];
+	it->type = (mobjtype_t)type;
+	it->flags = flags;
 	it->next = LUA_REFNIL;
 	return 2;
 }
 
+// Iterator for mobjs.iterateRadius. The matches were gathered up front,
+// so the loop body is free to move or remove objects; removed ones are
+// skipped. The state table keeps its read position in slot 0.
+static int lib_iterateRadius(lua_State *L)
+{
+	lua_Integer i, count;
+
+	luaL_checktype(L, 1, LUA_TTABLE);
+	count = (lua_Integer)lua_objlen(L, 1);
+
+	lua_rawgeti(L, 1, 0);
+	i = lua_tointeger(L, -1);
+	lua_pop(L, 1);
+
+	while (++i <= count)
+	{
+		lua_rawgeti(L, 1, (int)i);
+		if (*(mobj_t **)lua_touserdata(L, -1))
+		{
+			lua_pushinteger(L, i);
+			lua_rawseti(L, 1, 0);
+			return 1;
+		}
+		lua_pop(L, 1);
+	}
+
+	lua_pushinteger(L, count);
+	lua_rawseti(L, 1, 0);
+	return 0;
+}
+
+// mobjs.iterateRadius(x, y, radius, [type, [flags]])
+// Walks only the blockmap cells around the point and returns objects
+// whose centers are within radius of it. Objects with MF_NOBLOCKMAP
+// aren't linked into the blockmap, so they are never found.
+static int lib_startIterateRadius(lua_State *L)
+{
+	fixed_t x = luaL_checkfixed(L, 1);
+	fixed_t y = luaL_checkfixed(L, 2);
+	fixed_t radius = luaL_checkfixed(L, 3);
+	lua_Integer type = luaL_optinteger(L, 4, MT_NULL);
+	UINT32 flags = (UINT32)luaL_optinteger(L, 5, 0);
+	INT32 xl, xh, yl, yh, bx, by;
+	int count = 0;
+	mobj_t *mo;
+
+	INLEVEL
+
+	if (radius < 0)
+		return luaL_argerror(L, 3, "radius must not be negative");
+	if (type < MT_NULL || type >= NUMMOBJTYPES)
+		return luaL_error(L, "mobj type %d out of range (0 - %d)", (int)type, NUMMOBJTYPES-1);
+
+	lua_pushvalue(L, lua_upvalueindex(1));
+	lua_newtable(L);
+
+	// 64-bit so a huge radius can't wrap around
+	xl = (INT32)(((INT64)x - radius - bmaporgx) >> MAPBLOCKSHIFT);
+	xh = (INT32)(((INT64)x + radius - bmaporgx) >> MAPBLOCKSHIFT);
+	yl = (INT32)(((INT64)y - radius - bmaporgy) >> MAPBLOCKSHIFT);
+	yh = (INT32)(((INT64)y + radius - bmaporgy) >> MAPBLOCKSHIFT);
+
+	xl = max(xl, 0);
+	yl = max(yl, 0);
+	xh = min(xh, bmapwidth - 1);
+	yh = min(yh, bmapheight - 1);
+
+	for (by = yl; by <= yh; by++)
+		for (bx = xl; bx <= xh; bx++)
+			for (mo = blocklinks[by*bmapwidth + bx]; mo; mo = mo->bnext)
+			{
+				if (type != MT_NULL && mo->type != (mobjtype_t)type)
+					continue;
+				if ((mo->flags & flags) != flags)
+					continue;
+				if (FixedHypot(mo->x - x, mo->y - y) > radius)
+					continue;
+				LUA_PushMobj(L, mo);
+				lua_rawseti(L, -2, ++count);
+			}
+
+	return 2;
+}
+
 #undef push_thinker
 
 int LUA_ThinkerLib(lua_State *L)
@@ -131,10 +252,14 @@ int LUA_ThinkerLib(lua_State *L)
 	lua_setfield(L, -2, "__gc");
 	lua_pop(L, 1);
 
-	lua_createtable(L, 0, 1);
+	lua_createtable(L, 0, 2);
 		lua_pushcfunction(L, lib_iterateThinkers);
 		lua_pushcclosure(L, lib_startIterate, 1);
 		lua_setfield(L, -2, "iterate");
+
+		lua_pushcfunction(L, lib_iterateRadius);
+		lua_pushcclosure(L, lib_startIterateRadius, 1);
+		lua_setfield(L, -2, "iterateRadius");
 	lua_setglobal(L, "mobjs");
 	return 0;
 }
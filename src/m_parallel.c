@@ -0,0 +1,157 @@
+// SONIC ROBO BLAST 2
+//-----------------------------------------------------------------------------
+// Copyright (C) 2023 by Sonic Team Junior.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  m_parallel.c
+/// \brief Persistent worker pool for splitting independent loops across threads
+///
+///        Workers are spawned lazily the first time a loop is big enough to
+///        be split, then sleep on a condition variable between jobs. Only one
+///        job is in flight at a time and the caller always runs the first
+///        slice itself, so a pool of N workers uses N+1 threads.
+
+#include "doomdef.h"
+#include "i_system.h"
+#include "i_threads.h"
+#include "m_parallel.h"
+
+static CV_PossibleValue_t workerthreads_cons_t[] = {{0, "MIN"}, {MAXWORKERTHREADS, "MAX"}, {0, NULL}};
+consvar_t cv_workerthreads = CVAR_INIT ("workerthreads", "3", CV_SAVE, workerthreads_cons_t, NULL);
+consvar_t cv_parallelcheck = CVAR_INIT ("parallelcheck", "Off", CV_NOSHOWHELP, CV_OnOff, NULL);
+
+#ifdef HAVE_THREADS
+typedef struct
+{
+	parallelfunc_t func;
+	void *userdata;
+	size_t count;
+	INT32 slices;
+} paralleljob_t;
+
+static I_mutex pool_mutex;
+static I_cond pool_wake_cond;
+static I_cond pool_done_cond;
+
+static paralleljob_t pool_job;
+static UINT32 pool_generation; // bumped for every new job
+static INT32 pool_pending; // slices still running on workers
+static INT32 pool_spawned; // workers started so far
+static boolean pool_stopping;
+
+static void M_RunSlice(const paralleljob_t *job, INT32 slice)
+{
+	const size_t start = (job->count * slice) / job->slices;
+	const size_t end = (job->count * (slice + 1)) / job->slices;
+
+	if (start < end)
+		job->func(job->userdata, start, end);
+}
+
+static void M_ParallelWorker(void *userdata)
+{
+	const INT32 index = (INT32)(intptr_t)userdata;
+	UINT32 seen = 0;
+
+	for (;;)
+	{
+		paralleljob_t job;
+
+		I_lock_mutex(&pool_mutex);
+		while (!pool_stopping && pool_generation == seen)
+			I_hold_cond(&pool_wake_cond, pool_mutex);
+		if (pool_stopping)
+		{
+			I_unlock_mutex(pool_mutex);
+			return;
+		}
+		seen = pool_generation;
+		job = pool_job;
+		I_unlock_mutex(pool_mutex);
+
+		// Slice 0 belongs to the caller; idle workers beyond the
+		// current slice count just go back to sleep.
+		if (index + 1 >= job.slices)
+			continue;
+
+		M_RunSlice(&job, index + 1);
+
+		I_lock_mutex(&pool_mutex);
+		if (--pool_pending == 0)
+			I_wake_all_cond(&pool_done_cond);
+		I_unlock_mutex(pool_mutex);
+	}
+}
+
+static void M_StopParallelWorkers(void)
+{
+	if (!pool_spawned)
+		return;
+
+	I_lock_mutex(&pool_mutex);
+	pool_stopping = true;
+	I_wake_all_cond(&pool_wake_cond);
+	I_unlock_mutex(pool_mutex);
+}
+
+static void M_SpawnParallelWorkers(INT32 count)
+{
+	if (pool_spawned == 0 && count > 0)
+		I_AddExitFunc(M_StopParallelWorkers); // runs before I_stop_threads joins them
+
+	for (; pool_spawned < count; pool_spawned++)
+		I_spawn_thread("parallel-worker", M_ParallelWorker, (void *)(intptr_t)pool_spawned);
+}
+#endif
+
+INT32 M_ParallelThreads(void)
+{
+#ifdef HAVE_THREADS
+	return 1 + cv_workerthreads.value;
+#else
+	return 1;
+#endif
+}
+
+void M_ParallelFor(size_t count, size_t mincount, parallelfunc_t func, void *userdata)
+{
+#ifdef HAVE_THREADS
+	INT32 slices = M_ParallelThreads();
+
+	if (count < mincount || count < 2 || slices <= 1 || pool_stopping)
+	{
+		if (count)
+			func(userdata, 0, count);
+		return;
+	}
+
+	if ((size_t)slices > count)
+		slices = (INT32)count;
+
+	M_SpawnParallelWorkers(slices - 1);
+
+	I_lock_mutex(&pool_mutex);
+	pool_job.func = func;
+	pool_job.userdata = userdata;
+	pool_job.count = count;
+	pool_job.slices = slices;
+	pool_pending = slices - 1;
+	pool_generation++;
+	I_wake_all_cond(&pool_wake_cond);
+	I_unlock_mutex(pool_mutex);
+
+	M_RunSlice(&pool_job, 0);
+
+	I_lock_mutex(&pool_mutex);
+	while (pool_pending > 0)
+		I_hold_cond(&pool_done_cond, pool_mutex);
+	I_unlock_mutex(pool_mutex);
+#else
+	(void)mincount;
+	if (count)
+		func(userdata, 0, count);
+#endif
+}
@@ -0,0 +1,38 @@
+// SONIC ROBO BLAST 2
+//-----------------------------------------------------------------------------
+// Copyright (C) 2023 by Sonic Team Junior.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  m_parallel.h
+/// \brief Persistent worker pool for splitting independent loops across threads
+
+#ifndef __M_PARALLEL_H__
+#define __M_PARALLEL_H__
+
+#include "doomtype.h"
+#include "command.h"
+
+#define MAXWORKERTHREADS 8
+
+/// Processes items [start, end) of a parallel loop.
+/// Must not touch the zone allocator, Lua, the RNG or any shared game state.
+typedef void (*parallelfunc_t)(void *userdata, size_t start, size_t end);
+
+extern consvar_t cv_workerthreads;
+
+/// Debugging aid: when on, every parallel phase is run again serially on
+/// copies of the objects it updated and any difference is reported.
+extern consvar_t cv_parallelcheck;
+
+/// Runs func over [0, count) split into contiguous slices, one per thread.
+/// Returns once every slice has finished. Falls back to a single call on
+/// the calling thread if threads are unavailable or count < mincount.
+void M_ParallelFor(size_t count, size_t mincount, parallelfunc_t func, void *userdata);
+
+/// Number of threads (including the caller) M_ParallelFor will currently use.
+INT32 M_ParallelThreads(void);
+
+#endif
@@ -18,6 +18,7 @@
 #include "z_zone.h"
 #include "p_local.h"
 #include "r_fps.h"
+#include "lua_alloc.h"
 
 #ifdef HWRENDER
 #include "hardware/hw_main.h"
@@ -70,6 +71,16 @@ ps_metric_t ps_checkposition_calls = {0};
 ps_metric_t ps_lua_thinkframe_time = {0};
 ps_metric_t ps_lua_mobjhooks = {0};
 
+static ps_metric_t ps_lua_heapsize = {0};
+static ps_metric_t ps_lua_poolsize = {0};
+static ps_metric_t ps_lua_allocs = {0};
+static ps_metric_t ps_lua_frees = {0};
+static ps_metric_t ps_lua_allockb = {0};
+
+ps_metric_t ps_lua_gctime = {0};
+ps_metric_t ps_lua_gcsteps = {0};
+ps_metric_t ps_lua_gccycles = {0};
+
 ps_metric_t ps_otherlogictime = {0};
 
 // Columns for perfstats pages.
@@ -184,6 +195,20 @@ perfstatrow_t misc_calls_rows[] = {
 	{0}
 };
 
+// Lua stats columns
+
+perfstatrow_t luamemory_rows[] = {
+	{"heap kb", "Lua heap (KB):  ", &ps_lua_heapsize, 0},
+	{"pool kb", "Pool size (KB): ", &ps_lua_poolsize, 0},
+	{"allocs ", "Allocs per tic: ", &ps_lua_allocs, 0},
+	{"frees  ", "Frees per tic:  ", &ps_lua_frees, 0},
+	{"allockb", "Alloc KB/tic:   ", &ps_lua_allockb, 0},
+	{"gctime ", "GC step time:   ", &ps_lua_gctime, PS_TIME},
+	{"gcsteps", "GC steps:       ", &ps_lua_gcsteps, 0},
+	{"gccycle", "GC cycles:      ", &ps_lua_gccycles, 0},
+	{0}
+};
+
 // Sample collection status for averaging.
 // Maximum of these two is shown to user if nonzero to tell that
 // the reported averages are not correct yet.
@@ -578,6 +603,17 @@ void PS_UpdateTickStats(void)
 			PS_UpdateRowHistories(misc_calls_rows, false);
 		}
 	}
+	if (cv_perfstats.value == 3)
+	{
+		ps_lua_heapsize.value.i = (INT32)(lua_allocstats.heapsize >> 10);
+		ps_lua_poolsize.value.i = (INT32)(lua_allocstats.poolsize >> 10);
+		ps_lua_allocs.value.i = (INT32)lua_allocstats.allocs;
+		ps_lua_frees.value.i = (INT32)lua_allocstats.frees;
+		ps_lua_allockb.value.i = (INT32)(lua_allocstats.allocbytes >> 10);
+
+		if (cv_ps_samplesize.value > 1)
+			PS_UpdateRowHistories(luamemory_rows, false);
+	}
 	if (cv_perfstats.value == 3 && cv_ps_samplesize.value > 1 && PS_IsLevelActive())
 	{
 		int i;
@@ -586,6 +622,7 @@ void PS_UpdateTickStats(void)
 			PS_UpdateMetricHistory(&thinkframe_hooks[i].time_taken, true, false, false);
 		}
 	}
+	LUA_ResetAllocCounters();
 	if (cv_perfstats.value && cv_ps_samplesize.value > 1)
 	{
 		ps_tick_index++;
@@ -713,6 +750,8 @@ static void PS_DrawThinkFrameStats(void)
 
 	PS_DrawDescriptorHeader();
 
+	y = PS_DrawPerfRows(x, y, V_BLUEMAP, luamemory_rows) + 4;
+
 	for (i = 0; i < thinkframe_hooks_length; i++)
 	{
 
@@ -833,6 +872,7 @@ static void PS_ClearHistory(void)
 
 void PS_PerfStats_OnChange(void)
 {
+	LUA_ResetAllocCounters();
 	if (cv_perfstats.value && cv_ps_samplesize.value > 1)
 		PS_ClearHistory();
 }
@@ -46,6 +46,10 @@ extern ps_metric_t ps_checkposition_calls;
 extern ps_metric_t ps_lua_thinkframe_time;
 extern ps_metric_t ps_lua_mobjhooks;
 
+extern ps_metric_t ps_lua_gctime;
+extern ps_metric_t ps_lua_gcsteps;
+extern ps_metric_t ps_lua_gccycles;
+
 extern ps_metric_t ps_otherlogictime;
 
 void PS_SetThinkFrameHookInfo(int index, precise_t time_taken, char* short_src);
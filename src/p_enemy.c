@@ -792,6 +792,47 @@ boolean P_LookForPlayers(mobj_t *actor, boolean allaround, boolean tracer, fixed
 	//return false;
 }
 
+// Which players P_LookForShield inspects from each starting lastlook,
+// and where lastlook is left when none of them qualify. This only
+// depends on which slots are in game, so instead of walking every slot
+// for every ring on every tic, the walk is done once and reused until
+// someone joins or leaves.
+static struct
+{
+	boolean ingame[MAXPLAYERS];
+	UINT8 check[MAXPLAYERS][2];
+	UINT8 numcheck[MAXPLAYERS];
+	UINT8 end[MAXPLAYERS];
+	boolean valid;
+} shieldlook;
+
+static void P_BuildShieldLook(void)
+{
+	INT32 start, look, stop;
+
+	for (start = 0; start < MAXPLAYERS; start++)
+	{
+		shieldlook.numcheck[start] = 0;
+		stop = (start - 1) & PLAYERSMASK;
+
+		for (look = start; look != stop; look = (look + 1) & PLAYERSMASK)
+		{
+			if (!playeringame[look])
+				continue;
+
+			if (shieldlook.numcheck[start] == 2)
+				break;
+
+			shieldlook.check[start][shieldlook.numcheck[start]++] = (UINT8)look;
+		}
+
+		shieldlook.end[start] = (UINT8)look;
+	}
+
+	memcpy(shieldlook.ingame, playeringame, sizeof(shieldlook.ingame));
+	shieldlook.valid = true;
+}
+
 /** Looks for a player with a ring shield.
   * Used by rings.
   *
@@ -801,7 +842,7 @@ boolean P_LookForPlayers(mobj_t *actor, boolean allaround, boolean tracer, fixed
   */
 static boolean P_LookForShield(mobj_t *actor)
 {
-	INT32 c = 0, stop;
+	INT32 i, start;
 	player_t *player;
 
 	// BP: first time init, this allow minimum lastlook changes
@@ -810,21 +851,14 @@ static boolean P_LookForShield(mobj_t *actor)
 
 	actor->lastlook %= MAXPLAYERS;
 
-	stop = (actor->lastlook - 1) & PLAYERSMASK;
-
-	for (; ; actor->lastlook = ((actor->lastlook + 1) & PLAYERSMASK))
-	{
-		// done looking
-		if (actor->lastlook == stop)
-			return false;
-
-		if (!playeringame[actor->lastlook])
-			continue;
+	if (!shieldlook.valid || memcmp(shieldlook.ingame, playeringame, sizeof(shieldlook.ingame)))
+		P_BuildShieldLook();
 
-		if (c++ == 2)
-			return false;
+	start = actor->lastlook;
 
-		player = &players[actor->lastlook];
+	for (i = 0; i < shieldlook.numcheck[start]; i++)
+	{
+		player = &players[shieldlook.check[start][i]];
 
 		if (!player->mo || player->mo->health <= 0)
 			continue; // dead
@@ -837,6 +871,7 @@ static boolean P_LookForShield(mobj_t *actor)
 		if ((player->powers[pw_shield] & SH_PROTECTELECTRIC)
 			&& (P_AproxDistance(P_AproxDistance(actor->x-player->mo->x, actor->y-player->mo->y), actor->z-player->mo->z) < FixedMul(RING_DIST, player->mo->scale)))
 		{
+			actor->lastlook = shieldlook.check[start][i];
 			P_SetTarget(&actor->tracer, player->mo);
 
 			if (actor->hnext)
@@ -848,7 +883,9 @@ static boolean P_LookForShield(mobj_t *actor)
 		}
 	}
 
-	//return false;
+	// done looking
+	actor->lastlook = shieldlook.end[start];
+	return false;
 }
 
 #ifdef WEIGHTEDRECYCLER
@@ -2253,8 +2253,8 @@ boolean P_CheckPosition(mobj_t *thing, fixed_t x, fixed_t y)
 
 						po->validcount = validcount;
 
-						if (!P_BBoxInsidePolyobj(po, tmbbox)
-							|| !(po->flags & POF_SOLID))
+						if (!(po->flags & POF_SOLID)
+							|| !P_BBoxInsidePolyobj(po, tmbbox))
 						{
 							plink = (polymaplink_t *)(plink->link.next);
 							continue;
@@ -2483,7 +2483,7 @@ boolean P_CheckCameraPosition(fixed_t x, fixed_t y, camera_t *thiscam)
 
 						po->validcount = validcount;
 
-						if (!P_PointInsidePolyobj(po, x, y) || !(po->flags & POF_SOLID))
+						if (!(po->flags & POF_SOLID) || !P_PointInsidePolyobj(po, x, y))
 						{
 							plink = (polymaplink_t *)(plink->link.next);
 							continue;
@@ -3326,8 +3326,7 @@ static boolean P_IsClimbingValid(player_t *player, angle_t angle)
 
 	glidesector = R_PointInSubsector(mo->x + platx, mo->y + platy)->sector;
 
-	floorz   = P_GetSectorFloorZAt  (glidesector, mo->x, mo->y);
-	ceilingz = P_GetSectorCeilingZAt(glidesector, mo->x, mo->y);
+	P_GetSectorZsAt(glidesector, mo->x, mo->y, &floorz, &ceilingz);
 
 	if (glidesector != mo->subsector->sector)
 	{
@@ -3339,8 +3338,7 @@ static boolean P_IsClimbingValid(player_t *player, angle_t angle)
 			if (!(rover->fofflags & FOF_EXISTS) || !(rover->fofflags & FOF_BLOCKPLAYER))
 				continue;
 
-			topheight    = P_GetFFloorTopZAt   (rover, mo->x, mo->y);
-			bottomheight = P_GetFFloorBottomZAt(rover, mo->x, mo->y);
+			P_GetFFloorZsAt(rover, mo->x, mo->y, &topheight, &bottomheight);
 
 			floorclimb = true;
 
@@ -3455,8 +3453,7 @@ static void PTR_GlideClimbTraverse(line_t *li)
 			if (!(rover->fofflags & FOF_EXISTS) || !(rover->fofflags & FOF_BLOCKPLAYER) || ((rover->fofflags & FOF_BUSTUP) && (slidemo->player->charflags & SF_CANBUSTWALLS)))
 				continue;
 
-			topheight    = P_GetFFloorTopZAt   (rover, slidemo->x, slidemo->y);
-			bottomheight = P_GetFFloorBottomZAt(rover, slidemo->x, slidemo->y);
+			P_GetFFloorZsAt(rover, slidemo->x, slidemo->y, &topheight, &bottomheight);
 
 			if (topheight < slidemo->z)
 				continue;
@@ -4353,12 +4350,86 @@ static boolean PIT_ChangeSector(mobj_t *thing, boolean realcrush)
 	return true;
 }
 
+// Bumped whenever a node is linked into or unlinked from a sector's
+// thing list, so P_ChangeSectorThings knows when it has to rescan.
+static UINT32 secnodechanges = 0;
+
+//
+// P_ResetSectorThings
+//
+// Marks every thing touching the sector as unprocessed.
+//
+static void P_ResetSectorThings(sector_t *sec)
+{
+	msecnode_t *n;
+
+	for (n = sec->touching_thinglist; n; n = n->m_thinglist_next)
+		n->visited = false;
+
+	// A nested pass over a sector the caller is walking must force a rescan.
+	secnodechanges++;
+}
+
+//
+// P_ChangeSectorThings
+//
+// Runs PIT_ChangeSector on the first unprocessed thing in the sector's
+// list, over and over until every thing has been processed. The list can
+// change arbitrarily while things are being clipped or crushed, which is
+// why this used to restart from the head after every single thing. That
+// is only needed if the list was actually touched; otherwise the next
+// unprocessed thing is simply the next node, so carry on from there. The
+// order things are processed in is the same either way.
+//
+// Returns false once the caller should stop: something didn't fit, or
+// when crushing for real, the first thing has been crushed.
+//
+static boolean P_ChangeSectorThings(sector_t *sec, boolean realcrush)
+{
+	msecnode_t *n = sec->touching_thinglist;
+	UINT32 changes;
+
+	while (n)
+	{
+		if (n->visited)
+		{
+			n = n->m_thinglist_next;
+			continue;
+		}
+
+		n->visited = true; // mark thing as processed
+
+		if (!(n->m_thing->flags & MF_NOBLOCKMAP)) //jff 4/7/98 don't do these
+		{
+			if (realcrush)
+			{
+				PIT_ChangeSector(n->m_thing, true);
+				return false;
+			}
+
+			changes = secnodechanges;
+
+			if (!PIT_ChangeSector(n->m_thing, false)) // process it
+				return false;
+
+			if (changes != secnodechanges)
+			{
+				n = sec->touching_thinglist; // start over
+				continue;
+			}
+		}
+
+		n = n->m_thinglist_next;
+	}
+
+	return true;
+}
+
 //
 // P_CheckSector
 //
 boolean P_CheckSector(sector_t *sector, boolean crunch)
 {
-	msecnode_t *n;
 	size_t i;
 
 	nofit = false;
@@ -4371,6 +4442,9 @@ boolean P_CheckSector(sector_t *sector, boolean crunch)
 	// Things can arbitrarily be inserted and removed and it won't mess up.
 	//
 	// killough 4/7/98: simplified to avoid using complicated counter
+	//
+	// The restart only happens when the list actually changed now,
+	// see P_ChangeSectorThings.
 
 
 	// First, let's see if anything will keep it from crushing.
@@ -4429,8 +4503,7 @@ boolean P_CheckSector(sector_t *sector, boolean crunch)
 		for (i = 0; i < sector->numattached; i++)
 		{
 			sec = &sectors[sector->attached[i]];
-			for (n = sec->touching_thinglist; n; n = n->m_thinglist_next)
-				n->visited = false;
+			P_ResetSectorThings(sec);
 
 			sec->moved = true;
 
@@ -4439,49 +4512,24 @@ boolean P_CheckSector(sector_t *sector, boolean crunch)
 			if (!sector->attachedsolid[i])
 				continue;
 
-			do
+			if (!P_ChangeSectorThings(sec, false))
 			{
-				for (n = sec->touching_thinglist; n; n = n->m_thinglist_next)
-				if (!n->visited)
-				{
-					n->visited = true;
-					if (!(n->m_thing->flags & MF_NOBLOCKMAP))
-					{
-						if (!PIT_ChangeSector(n->m_thing, false))
-						{
-							nofit = true;
-							return nofit;
-						}
-					}
-					break;
-				}
-			} while (n);
+				nofit = true;
+				return nofit;
+			}
 		}
 	}
 
 	// Mark all things invalid
 	sector->moved = true;
 
-	for (n = sector->touching_thinglist; n; n = n->m_thinglist_next)
-		n->visited = false;
+	P_ResetSectorThings(sector);
 
-	do
+	if (!P_ChangeSectorThings(sector, false))
 	{
-		for (n = sector->touching_thinglist; n; n = n->m_thinglist_next) // go through list
-			if (!n->visited) // unprocessed thing found
-			{
-				n->visited = true; // mark thing as processed
-				if (!(n->m_thing->flags & MF_NOBLOCKMAP)) //jff 4/7/98 don't do these
-				{
-					if (!PIT_ChangeSector(n->m_thing, false)) // process it
-					{
-						nofit = true;
-						return nofit;
-					}
-				}
-				break; // exit and start over
-			}
-	} while (n); // repeat from scratch until all things left are marked valid
+		nofit = true;
+		return nofit;
+	}
 
 	// Nothing blocked us, so lets crush for real!
 
@@ -4535,8 +4583,7 @@ boolean P_CheckSector(sector_t *sector, boolean crunch)
 		for (i = 0; i < sector->numattached; i++)
 		{
 			sec = &sectors[sector->attached[i]];
-			for (n = sec->touching_thinglist; n; n = n->m_thinglist_next)
-				n->visited = false;
+			P_ResetSectorThings(sec);
 
 			sec->moved = true;
 
@@ -4545,43 +4592,16 @@ boolean P_CheckSector(sector_t *sector, boolean crunch)
 			if (!sector->attachedsolid[i])
 				continue;
 
-			do
-			{
-				for (n = sec->touching_thinglist; n; n = n->m_thinglist_next)
-				if (!n->visited)
-				{
-					n->visited = true;
-					if (!(n->m_thing->flags & MF_NOBLOCKMAP))
-					{
-						PIT_ChangeSector(n->m_thing, true);
-						return nofit;
-					}
-					break;
-				}
-			} while (n);
+			if (!P_ChangeSectorThings(sec, true))
+				return nofit;
 		}
 	}
 
 	// Mark all things invalid
 	sector->moved = true;
 
-	for (n = sector->touching_thinglist; n; n = n->m_thinglist_next)
-		n->visited = false;
-
-	do
-	{
-		for (n = sector->touching_thinglist; n; n = n->m_thinglist_next) // go through list
-			if (!n->visited) // unprocessed thing found
-			{
-				n->visited = true; // mark thing as processed
-				if (!(n->m_thing->flags & MF_NOBLOCKMAP)) //jff 4/7/98 don't do these
-				{
-					PIT_ChangeSector(n->m_thing, true); // process it
-					return nofit;
-				}
-				break; // exit and start over
-			}
-	} while (n); // repeat from scratch until all things left are marked valid
+	P_ResetSectorThings(sector);
+	P_ChangeSectorThings(sector, true);
 
 	return nofit;
 }
@@ -4688,6 +4708,7 @@ static msecnode_t *P_AddSecnode(sector_t *s, mobj_t *thing, msecnode_t *nextnode
 	if (s->touching_thinglist)
 		node->m_thinglist_next->m_thinglist_prev = node;
 	s->touching_thinglist = node;
+	secnodechanges++;
 	return node;
 }
 
@@ -4767,6 +4788,7 @@ static msecnode_t *P_DelSecnode(msecnode_t *node)
 		node->m_sector->touching_thinglist = sn;
 	if (sn)
 		sn->m_thinglist_prev = sp;
+	secnodechanges++;
 
 	// Return this node to the freelist
 
@@ -5091,8 +5113,7 @@ fixed_t P_FloorzAtPos(fixed_t x, fixed_t y, fixed_t z, fixed_t height)
 			if ((!(rover->fofflags & FOF_SOLID || rover->fofflags & FOF_QUICKSAND) || (rover->fofflags & FOF_SWIMMABLE)))
 				continue;
 
-			topheight    = P_GetFFloorTopZAt   (rover, x, y);
-			bottomheight = P_GetFFloorBottomZAt(rover, x, y);
+			P_GetFFloorZsAt(rover, x, y, &topheight, &bottomheight);
 
 			if (rover->fofflags & FOF_QUICKSAND)
 			{
@@ -5135,8 +5156,7 @@ fixed_t P_CeilingzAtPos(fixed_t x, fixed_t y, fixed_t z, fixed_t height)
 			if ((!(rover->fofflags & FOF_SOLID || rover->fofflags & FOF_QUICKSAND) || (rover->fofflags & FOF_SWIMMABLE)))
 				continue;
 
-			topheight    = P_GetFFloorTopZAt   (rover, x, y);
-			bottomheight = P_GetFFloorBottomZAt(rover, x, y);
+			P_GetFFloorZsAt(rover, x, y, &topheight, &bottomheight);
 
 			if (rover->fofflags & FOF_QUICKSAND)
 			{
@@ -305,15 +305,13 @@ void P_CameraLineOpening(line_t *linedef)
 	if (front->camsec >= 0)
 	{
 		// SRB2CBTODO: ESLOPE (sectors[front->heightsec].f_slope)
-		frontfloor   = P_GetSectorFloorZAt  (&sectors[front->camsec], camera.x, camera.y);
-		frontceiling = P_GetSectorCeilingZAt(&sectors[front->camsec], camera.x, camera.y);
+		P_GetSectorZsAt(&sectors[front->camsec], camera.x, camera.y, &frontfloor, &frontceiling);
 
 	}
 	else if (front->heightsec >= 0)
 	{
 		// SRB2CBTODO: ESLOPE (sectors[front->heightsec].f_slope)
-		frontfloor   = P_GetSectorFloorZAt  (&sectors[front->heightsec], camera.x, camera.y);
-		frontceiling = P_GetSectorCeilingZAt(&sectors[front->heightsec], camera.x, camera.y);
+		P_GetSectorZsAt(&sectors[front->heightsec], camera.x, camera.y, &frontfloor, &frontceiling);
 	}
 	else
 	{
@@ -323,14 +321,12 @@ void P_CameraLineOpening(line_t *linedef)
 	if (back->camsec >= 0)
 	{
 		// SRB2CBTODO: ESLOPE (sectors[back->heightsec].f_slope)
-		backfloor   = P_GetSectorFloorZAt  (&sectors[back->camsec], camera.x, camera.y);
-		backceiling = P_GetSectorCeilingZAt(&sectors[back->camsec], camera.x, camera.y);
+		P_GetSectorZsAt(&sectors[back->camsec], camera.x, camera.y, &backfloor, &backceiling);
 	}
 	else if (back->heightsec >= 0)
 	{
 		// SRB2CBTODO: ESLOPE (sectors[back->heightsec].f_slope)
-		backfloor   = P_GetSectorFloorZAt  (&sectors[back->heightsec], camera.x, camera.y);
-		backceiling = P_GetSectorCeilingZAt(&sectors[back->heightsec], camera.x, camera.y);
+		P_GetSectorZsAt(&sectors[back->heightsec], camera.x, camera.y, &backfloor, &backceiling);
 	}
 	else
 	{
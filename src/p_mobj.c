@@ -968,8 +968,7 @@ boolean P_InsideANonSolidFFloor(mobj_t *mobj, ffloor_t *rover)
 		|| ((rover->fofflags & FOF_BLOCKOTHERS) && !mobj->player)))
 		return false;
 
-	topheight    = P_GetFFloorTopZAt   (rover, mobj->x, mobj->y);
-	bottomheight = P_GetFFloorBottomZAt(rover, mobj->x, mobj->y);
+	P_GetFFloorZsAt(rover, mobj->x, mobj->y, &topheight, &bottomheight);
 
 	if (mobj->z > topheight)
 		return false;
@@ -1072,16 +1071,19 @@ static fixed_t HighestOnLine(fixed_t radius, fixed_t x, fixed_t y, line_t *line,
 				);*/
 
 	// Return the higher of the two points
-	if (actuallylowest)
-		return min(
-			P_GetSlopeZAt(slope, v1.x, v1.y),
-			P_GetSlopeZAt(slope, v2.x, v2.y)
-		);
-	else
-		return max(
-			P_GetSlopeZAt(slope, v1.x, v1.y),
-			P_GetSlopeZAt(slope, v2.x, v2.y)
-		);
+	// (evaluated once up front; min/max would sample each point twice)
+	{
+		const fixed_t px[2] = {v1.x, v2.x};
+		const fixed_t py[2] = {v1.y, v2.y};
+		fixed_t pz[2];
+
+		P_GetSlopeZsAt(slope, px, py, pz, 2);
+
+		if (actuallylowest)
+			return min(pz[0], pz[1]);
+		else
+			return max(pz[0], pz[1]);
+	}
 }
 
 fixed_t P_MobjFloorZ(mobj_t *mobj, sector_t *sector, sector_t *boundsec, fixed_t x, fixed_t y, line_t *line, boolean lowest, boolean perfect)
@@ -2220,7 +2222,7 @@ static void P_AdjustMobjFloorZ_PolyObjs(mobj_t *mo, subsector_t *subsec)
 
 	while(po)
 	{
-		if (!P_MobjInsidePolyobj(po, mo) || !(po->flags & POF_SOLID))
+		if (!(po->flags & POF_SOLID) || !P_MobjInsidePolyobj(po, mo))
 		{
 			po = (polyobj_t *)(po->link.next);
 			continue;
@@ -3490,8 +3492,7 @@ static void P_SceneryCheckWater(mobj_t *mobj)
 			if (!(rover->fofflags & FOF_EXISTS) || !(rover->fofflags & FOF_SWIMMABLE) || rover->fofflags & FOF_BLOCKOTHERS)
 				continue;
 
-			topheight    = P_GetFFloorTopZAt   (rover, mobj->x, mobj->y);
-			bottomheight = P_GetFFloorBottomZAt(rover, mobj->x, mobj->y);
+			P_GetFFloorZsAt(rover, mobj->x, mobj->y, &topheight, &bottomheight);
 
 			if (topheight <= mobj->z
 				|| bottomheight > (mobj->z + (mobj->height>>1)))
@@ -4051,6 +4052,34 @@ void P_RainThinker(precipmobj_t *mobj)
 	P_SetPrecipMobjState(mobj, S_SPLASH1);
 }
 
+//
+// P_PrecipThinkerIsLocal
+//
+// Returns true if running this precipitation thinker this tic can
+// only touch the precipmobj itself: no state change into S_NULL
+// (which unlinks and frees it) or into an FF_RANDOMANIM state
+// (which advances the RNG). Such thinkers may run on worker threads.
+//
+static boolean P_PrecipStateIsLocal(statenum_t state)
+{
+	return state != S_NULL && !(states[state].frame & FF_RANDOMANIM);
+}
+
+boolean P_PrecipThinkerIsLocal(precipmobj_t *mobj)
+{
+	actionf_p1 think = mobj->thinker.function.acp1;
+
+	if (think == (actionf_p1)P_SnowThinker || think == (actionf_p1)P_NullPrecipThinker)
+		return true;
+
+	if (think == (actionf_p1)P_RainThinker)
+		return P_PrecipStateIsLocal(mobj->state->nextstate)
+			&& P_PrecipStateIsLocal(S_RAIN1)
+			&& P_PrecipStateIsLocal(S_SPLASH1);
+
+	return false;
+}
+
 static void P_KillRingsInLava(mobj_t *mo)
 {
 	msecnode_t *node;
@@ -11700,8 +11729,7 @@ void P_MovePlayerToSpawn(INT32 playernum, mapthing_t *mthing)
 	// set Z height
 	sector = R_PointInSubsector(x, y)->sector;
 
-	floor   = P_GetSectorFloorZAt  (sector, x, y);
-	ceiling = P_GetSectorCeilingZAt(sector, x, y);
+	P_GetSectorZsAt(sector, x, y, &floor, &ceiling);
 	ceilingspawn = ceiling - mobjinfo[MT_PLAYER].height;
 
 	if (mthing)
@@ -11771,8 +11799,7 @@ void P_MovePlayerToStarpost(INT32 playernum)
 	P_SetThingPosition(mobj);
 	sector = R_PointInSubsector(mobj->x, mobj->y)->sector;
 
-	floor   = P_GetSectorFloorZAt  (sector, mobj->x, mobj->y);
-	ceiling = P_GetSectorCeilingZAt(sector, mobj->x, mobj->y);
+	P_GetSectorZsAt(sector, mobj->x, mobj->y, &floor, &ceiling);
 
 	z = p->starpostz << FRACBITS;
 
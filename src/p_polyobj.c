@@ -673,6 +673,75 @@ static void Polyobj_putLink(polymaplink_t *l)
 	bmap_freelist = l;
 }
 
+// Computes the polyobject's map-space bounding box from its vertices, and
+// the range of blockmap cells it covers.
+static void Polyobj_calcBoxes(polyobj_t *po, fixed_t *blockbox)
+{
+	fixed_t *bbox = po->bbox;
+	size_t i;
+
+	// 2/26/06: start line box with values of first vertex, not INT32_MIN/INT32_MAX
+	bbox[BOXLEFT]   = bbox[BOXRIGHT] = po->vertices[0]->x;
+	bbox[BOXBOTTOM] = bbox[BOXTOP]   = po->vertices[0]->y;
+
+	// add all vertices to the bounding box
+	for (i = 1; i < po->numVertices; ++i)
+		M_AddToBox(bbox, po->vertices[i]->x, po->vertices[i]->y);
+
+	// adjust bounding box relative to blockmap
+	blockbox[BOXRIGHT]  = (unsigned)(bbox[BOXRIGHT]  - bmaporgx) >> MAPBLOCKSHIFT;
+	blockbox[BOXLEFT]   = (unsigned)(bbox[BOXLEFT]   - bmaporgx) >> MAPBLOCKSHIFT;
+	blockbox[BOXTOP]    = (unsigned)(bbox[BOXTOP]    - bmaporgy) >> MAPBLOCKSHIFT;
+	blockbox[BOXBOTTOM] = (unsigned)(bbox[BOXBOTTOM] - bmaporgy) >> MAPBLOCKSHIFT;
+
+	// vertices moved, so the renderer has to re-sort the segs
+	po->segsorted = false;
+}
+
+static inline boolean Polyobj_cellInBox(const fixed_t *blockbox, INT32 x, INT32 y)
+{
+	return x >= blockbox[BOXLEFT] && x <= blockbox[BOXRIGHT]
+		&& y >= blockbox[BOXBOTTOM] && y <= blockbox[BOXTOP];
+}
+
+// Links a polyobject into one blockmap cell.
+static void Polyobj_linkToCell(polyobj_t *po, INT32 x, INT32 y)
+{
+	polymaplink_t *l;
+
+	if (x < 0 || y < 0 || x >= bmapwidth || y >= bmapheight)
+		return;
+
+	l = Polyobj_getLink();
+	l->po = po;
+
+	M_DLListInsert(&l->link,
+				(mdllistitem_t **)(&polyblocklinks[y*bmapwidth + x]));
+}
+
+// Unlinks a polyobject from one blockmap cell and returns
+// its polymaplink object to the free list.
+static void Polyobj_removeFromCell(polyobj_t *po, INT32 x, INT32 y)
+{
+	polymaplink_t *rover;
+
+	if (x < 0 || y < 0 || x >= bmapwidth || y >= bmapheight)
+		return;
+
+	rover = polyblocklinks[y * bmapwidth + x];
+
+	while (rover && rover->po != po)
+		rover = (polymaplink_t *)(rover->link.next);
+
+	// polyobject not in this cell? go on to next.
+	if (!rover)
+		return;
+
+	// remove this link from the blockmap and put it on the freelist
+	M_DLListRemove(&rover->link);
+	Polyobj_putLink(rover);
+}
+
 // Inserts a polyobject into the polyobject blockmap. Unlike, mobj_t's,
 // polyobjects need to be linked into every blockmap cell which their
 // bounding box intersects. This ensures the accurate level of clipping
@@ -680,83 +749,55 @@ static void Polyobj_putLink(polymaplink_t *l)
 static void Polyobj_linkToBlockmap(polyobj_t *po)
 {
 	fixed_t *blockbox = po->blockbox;
-	size_t i;
 	fixed_t x, y;
 
 	// never link a bad polyobject or a polyobject already linked
 	if (po->isBad || po->linked)
 		return;
 
-	// 2/26/06: start line box with values of first vertex, not INT32_MIN/INT32_MAX
-	blockbox[BOXLEFT]   = blockbox[BOXRIGHT] = po->vertices[0]->x;
-	blockbox[BOXBOTTOM] = blockbox[BOXTOP]   = po->vertices[0]->y;
-
-	// add all vertices to the bounding box
-	for (i = 1; i < po->numVertices; ++i)
-		M_AddToBox(blockbox, po->vertices[i]->x, po->vertices[i]->y);
-
-	// adjust bounding box relative to blockmap
-	blockbox[BOXRIGHT]  = (unsigned)(blockbox[BOXRIGHT]  - bmaporgx) >> MAPBLOCKSHIFT;
-	blockbox[BOXLEFT]   = (unsigned)(blockbox[BOXLEFT]   - bmaporgx) >> MAPBLOCKSHIFT;
-	blockbox[BOXTOP]    = (unsigned)(blockbox[BOXTOP]    - bmaporgy) >> MAPBLOCKSHIFT;
-	blockbox[BOXBOTTOM] = (unsigned)(blockbox[BOXBOTTOM] - bmaporgy) >> MAPBLOCKSHIFT;
+	Polyobj_calcBoxes(po, blockbox);
 
 	// link polyobject to every block its bounding box intersects
 	for (y = blockbox[BOXBOTTOM]; y <= blockbox[BOXTOP]; ++y)
-	{
 		for (x = blockbox[BOXLEFT]; x <= blockbox[BOXRIGHT]; ++x)
-		{
-			if (!(x < 0 || y < 0 || x >= bmapwidth || y >= bmapheight))
-			{
-				polymaplink_t  *l = Polyobj_getLink();
-
-				l->po = po;
-
-				M_DLListInsert(&l->link,
-							(mdllistitem_t **)(&polyblocklinks[y*bmapwidth + x]));
-			}
-		}
-	}
+			Polyobj_linkToCell(po, x, y);
 
 	po->linked = true;
 }
 
-// Unlinks a polyobject from all blockmap cells it intersects and returns
-// its polymaplink objects to the free list.
-static void Polyobj_removeFromBlockmap(polyobj_t *po)
+// Updates the blockmap links of a polyobject that has just moved or rotated.
+// Only the cells it actually entered or left are touched; a polyobject
+// moving within the same cells (the common case) costs nothing here.
+static void Polyobj_relinkToBlockmap(polyobj_t *po)
 {
-	polymaplink_t *rover;
-	fixed_t *blockbox = po->blockbox;
+	fixed_t *oldbox = po->blockbox;
+	fixed_t newbox[4];
 	INT32 x, y;
 
-	// don't bother trying to unlink one that's not linked
 	if (!po->linked)
+	{
+		Polyobj_linkToBlockmap(po);
 		return;
+	}
 
-	// search all cells the polyobject touches
-	for (y = blockbox[BOXBOTTOM]; y <= blockbox[BOXTOP]; ++y)
-	{
-		for (x = blockbox[BOXLEFT]; x <= blockbox[BOXRIGHT]; ++x)
-		{
-			if (!(x < 0 || y < 0 || x >= bmapwidth || y >= bmapheight))
-			{
-				rover = polyblocklinks[y * bmapwidth + x];
+	Polyobj_calcBoxes(po, newbox);
 
-				while (rover && rover->po != po)
-					rover = (polymaplink_t *)(rover->link.next);
+	if (!memcmp(newbox, oldbox, sizeof newbox))
+		return;
 
-				// polyobject not in this cell? go on to next.
-				if (!rover)
-					continue;
+	// leave cells no longer covered
+	for (y = oldbox[BOXBOTTOM]; y <= oldbox[BOXTOP]; ++y)
+		for (x = oldbox[BOXLEFT]; x <= oldbox[BOXRIGHT]; ++x)
+			if (!Polyobj_cellInBox(newbox, x, y))
+				Polyobj_removeFromCell(po, x, y);
 
-				// remove this link from the blockmap and put it on the freelist
-				M_DLListRemove(&rover->link);
-				Polyobj_putLink(rover);
-			}
-		}
-	}
+	// enter newly covered cells
+	for (y = newbox[BOXBOTTOM]; y <= newbox[BOXTOP]; ++y)
+		for (x = newbox[BOXLEFT]; x <= newbox[BOXRIGHT]; ++x)
+			if (!Polyobj_cellInBox(oldbox, x, y))
+				Polyobj_linkToCell(po, x, y);
 
-	po->linked = false;
+	M_Memcpy(oldbox, newbox, sizeof newbox);
 }
 
 // Movement functions
@@ -1024,9 +1065,8 @@ boolean Polyobj_moveXY(polyobj_t *po, fixed_t x, fixed_t y, boolean checkmobjs)
 
 		if (checkmobjs)
 			Polyobj_carryThings(po, x, y);
-		Polyobj_removeFromBlockmap(po); // unlink it from the blockmap
 		Polyobj_removeFromSubsec(po);   // unlink it from its subsector
-		Polyobj_linkToBlockmap(po);     // relink to blockmap
+		Polyobj_relinkToBlockmap(po);   // move blockmap links
 		Polyobj_attachToSubsec(po);     // relink to subsector
 	}
 
@@ -1226,9 +1266,8 @@ boolean Polyobj_rotate(polyobj_t *po, angle_t delta, boolean turnplayers, boolea
 		// update polyobject's angle
 		po->angle += delta;
 
-		Polyobj_removeFromBlockmap(po); // unlink it from the blockmap
 		Polyobj_removeFromSubsec(po);   // remove from subsector
-		Polyobj_linkToBlockmap(po);     // relink to blockmap
+		Polyobj_relinkToBlockmap(po);   // move blockmap links
 		Polyobj_attachToSubsec(po);     // relink to subsector
 	}
 
@@ -2479,9 +2518,8 @@ void T_PolyObjFlag(polymove_t *th)
 	for (i = 0; i < po->numLines; i++)
 		Polyobj_rotateLine(po->lines[i]);
 
-	Polyobj_removeFromBlockmap(po); // unlink it from the blockmap
 	Polyobj_removeFromSubsec(po);   // unlink it from its subsector
-	Polyobj_linkToBlockmap(po);     // relink to blockmap
+	Polyobj_relinkToBlockmap(po);   // move blockmap links
 	Polyobj_attachToSubsec(po);     // relink to subsector
 }
 
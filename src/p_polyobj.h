@@ -97,6 +97,7 @@ typedef struct polyobj_s
 	UINT8 attached;         // if true, is attached to a subsector
 
 	fixed_t blockbox[4]; // bounding box for clipping
+	fixed_t bbox[4];     // map-space bounding box, for culling whole polyobjects
 	UINT8 linked;         // is linked to blockmap
 	size_t validcount;   // for clipping: prevents multiple checks
 	INT32 damage;        // damage to inflict on stuck things
@@ -111,6 +112,11 @@ typedef struct polyobj_s
 
 	struct visplane_s *visplane; // polyobject's visplane, for ease of putting into the list later
 
+	// renderer: segs are already sorted front-to-back for this viewpoint
+	boolean segsorted;
+	fixed_t sortviewx, sortviewy;
+	angle_t sortviewangle;
+
 	// these are saved for netgames, so do not let Lua touch these!
 	INT32 spawnflags; // Flags the polyobject originally spawned with
 	INT32 spawntrans; // Translucency the polyobject originally spawned with
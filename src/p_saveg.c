@@ -39,6 +39,14 @@
 savedata_t savedata;
 UINT8 *save_p;
 
+// Growable buffer used for netgame saves, see P_SaveBufferAlloc
+static UINT8 *savebuffer_start = NULL;
+static UINT8 *savebuffer_end = NULL;
+
+// Worst case size of any single fixed-size record (one player, sector,
+// line, thinker...) written between two P_SaveBufferReserve calls.
+#define SAVEBUFFERSLACK (16*1024)
+
 // Block UINT32s to attempt to ensure that the correct data is
 // being sent and received
 #define ARCHIVEBLOCK_MISC     0x7FEEDEED
@@ -134,6 +142,7 @@ static void P_NetArchivePlayers(void)
 
 	for (i = 0; i < MAXPLAYERS; i++)
 	{
+		P_SaveBufferReserve(SAVEBUFFERSLACK);
 		WRITESINT8(save_p, (SINT8)adminplayers[i]);
 
 		if (!playeringame[i])
@@ -674,6 +683,7 @@ static void P_NetArchiveColormaps(void)
 		if (!exc)
 			exc = R_CreateDefaultColormap(false);
 
+		P_SaveBufferReserve(SAVEBUFFERSLACK);
 		WRITEUINT8(save_p, exc->fadestart);
 		WRITEUINT8(save_p, exc->fadeend);
 		WRITEUINT8(save_p, exc->flags);
@@ -802,6 +812,7 @@ static void P_NetArchiveWaypoints(void)
 
 	for (i = 0; i < NUMWAYPOINTSEQUENCES; i++)
 	{
+		P_SaveBufferReserve(sizeof(UINT16) + numwaypoints[i]*sizeof(UINT32));
 		WRITEUINT16(save_p, numwaypoints[i]);
 		for (j = 0; j < numwaypoints[i]; j++)
 			WRITEUINT32(save_p, waypoints[i][j] ? waypoints[i][j]->mobjnum : 0);
@@ -1004,6 +1015,7 @@ static void ArchiveSectors(void)
 
 	for (i = 0; i < numsectors; i++, ss++, spawnss++)
 	{
+		P_SaveBufferReserve(SAVEBUFFERSLACK + ss->tags.count*sizeof(mtag_t));
 		diff = diff2 = diff3 = diff4 = 0;
 		if (ss->floorheight != spawnss->floorheight)
 			diff |= SD_FLOORHT;
@@ -1277,6 +1289,7 @@ static void ArchiveLines(void)
 
 	for (i = 0; i < numlines; i++, spawnli++, li++)
 	{
+		P_SaveBufferReserve(SAVEBUFFERSLACK);
 		diff = diff2 = 0;
 
 		if (li->special != spawnli->special)
@@ -1377,6 +1390,7 @@ static void ArchiveLines(void)
 					}
 
 					len = strlen(li->stringargs[j]);
+					P_SaveBufferReserve(sizeof(INT32) + len);
 					WRITEINT32(save_p, len);
 					for (k = 0; k < len; k++)
 						WRITECHAR(save_p, li->stringargs[j][k]);
@@ -2483,6 +2497,8 @@ static void P_NetArchiveThinkers(void)
 		// save off the current thinkers
 		for (th = thlist[i].next; th != &thlist[i]; th = th->next)
 		{
+			P_SaveBufferReserve(SAVEBUFFERSLACK);
+
 			if (!(th->function.acp1 == (actionf_p1)P_RemoveThinkerDelayed
 			 || th->function.acp1 == (actionf_p1)P_NullPrecipThinker))
 				numsaved++;
@@ -3556,6 +3572,7 @@ static inline thinker_t* LoadDynamicVertexSlopeThinker(actionf_p1 thinker)
 	READMEM(save_p, ht->origsecheights, sizeof(ht->origsecheights));
 	READMEM(save_p, ht->origvecheights, sizeof(ht->origvecheights));
 	ht->relative = READUINT8(save_p);
+	ht->cached = false;
 	return &ht->thinker;
 }
 
@@ -3995,7 +4012,10 @@ static inline void P_ArchivePolyObjects(void)
 	WRITEINT32(save_p, numPolyObjects);
 
 	for (i = 0; i < numPolyObjects; ++i)
+	{
+		P_SaveBufferReserve(SAVEBUFFERSLACK);
 		P_ArchivePolyObj(&PolyObjects[i]);
+	}
 }
 
 static inline void P_UnArchivePolyObjects(void)
@@ -4126,6 +4146,7 @@ static inline void P_NetArchiveSpecials(void)
 {
 	size_t i, z;
 
+	P_SaveBufferReserve(SAVEBUFFERSLACK + ITEMQUESIZE*2*sizeof(UINT32));
 	WRITEUINT32(save_p, ARCHIVEBLOCK_SPECIALS);
 
 	// itemrespawn queue for deathmatch
@@ -4483,6 +4504,75 @@ static inline boolean P_UnArchiveLuabanksAndConsistency(void)
 	return true;
 }
 
+//
+// P_SaveBufferAlloc
+//
+// Allocates a save buffer that grows as P_SaveNetGame writes to it,
+// and points save_p at its start. Returns NULL if out of memory.
+//
+UINT8 *P_SaveBufferAlloc(size_t initsize)
+{
+	if (initsize < SAVEBUFFERSLACK)
+		initsize = SAVEBUFFERSLACK;
+
+	savebuffer_start = malloc(initsize);
+	if (!savebuffer_start)
+	{
+		savebuffer_end = NULL;
+		return NULL;
+	}
+
+	savebuffer_end = savebuffer_start + initsize;
+	save_p = savebuffer_start;
+	return savebuffer_start;
+}
+
+//
+// P_SaveBufferReserve
+//
+// Makes sure at least size bytes can be written at save_p, moving
+// the buffer if needed. Does nothing for fixed buffers.
+//
+void P_SaveBufferReserve(size_t size)
+{
+	size_t used, cap;
+	UINT8 *newbuffer;
+
+	if (!savebuffer_start || (size_t)(savebuffer_end - save_p) >= size)
+		return;
+
+	used = save_p - savebuffer_start;
+	cap = savebuffer_end - savebuffer_start;
+	while (cap - used < size)
+		cap *= 2;
+
+	newbuffer = realloc(savebuffer_start, cap);
+	if (!newbuffer)
+		I_Error("No more free memory for savegame (%s bytes)", sizeu1(cap));
+
+	savebuffer_start = newbuffer;
+	savebuffer_end = newbuffer + cap;
+	save_p = newbuffer + used;
+}
+
+//
+// P_SaveBufferFinish
+//
+// Stops growing the buffer from P_SaveBufferAlloc and hands it back
+// to the caller, who must free() it.
+//
+UINT8 *P_SaveBufferFinish(size_t *length)
+{
+	UINT8 *buffer = savebuffer_start;
+
+	if (length)
+		*length = buffer ? (size_t)(save_p - buffer) : 0;
+
+	savebuffer_start = savebuffer_end = NULL;
+	save_p = NULL;
+	return buffer;
+}
+
 void P_SaveGame(INT16 mapnum)
 {
 	P_ArchiveMisc(mapnum);
@@ -4496,7 +4586,9 @@ void P_SaveNetGame(boolean resending)
 	mobj_t *mobj;
 	INT32 i = 1; // don't start from 0, it'd be confused with a blank pointer otherwise
 
+	P_SaveBufferReserve(4*SAVEBUFFERSLACK); // netvars and misc
 	CV_SaveNetVars(&save_p);
+	P_SaveBufferReserve(SAVEBUFFERSLACK);
 	P_NetArchiveMisc(resending);
 
 	// Assign the mobjnumber for pointer tracking
@@ -4521,8 +4613,10 @@ void P_SaveNetGame(boolean resending)
 		P_NetArchiveColormaps();
 		P_NetArchiveWaypoints();
 	}
+	P_SaveBufferReserve(SAVEBUFFERSLACK);
 	LUA_Archive();
 
+	P_SaveBufferReserve(SAVEBUFFERSLACK);
 	P_ArchiveLuabanksAndConsistency();
 }
 
@@ -4562,7 +4656,8 @@ boolean P_LoadNetGame(boolean reloading)
 		P_RelinkPointers();
 		P_FinishMobjs();
 	}
-	LUA_UnArchive();
+	if (!LUA_UnArchive())
+		return false;
 
 	// This is stupid and hacky, but maybe it'll work!
 	P_SetRandSeed(P_GetInitSeed());
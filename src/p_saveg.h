@@ -44,4 +44,8 @@ typedef struct
 extern savedata_t savedata;
 extern UINT8 *save_p;
 
+UINT8 *P_SaveBufferAlloc(size_t initsize);
+void P_SaveBufferReserve(size_t size);
+UINT8 *P_SaveBufferFinish(size_t *length);
+
 #endif
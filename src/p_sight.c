@@ -259,10 +259,8 @@ static boolean P_CrossSubsector(size_t num, register los_t *los)
 		fracx = los->strace.x + FixedMul(los->strace.dx, frac);
 		fracy = los->strace.y + FixedMul(los->strace.dy, frac);
 		// calculate sector heights
-		frontf = P_GetSectorFloorZAt  (front, fracx, fracy);
-		frontc = P_GetSectorCeilingZAt(front, fracx, fracy);
-		backf  = P_GetSectorFloorZAt  (back , fracx, fracy);
-		backc  = P_GetSectorCeilingZAt(back , fracx, fracy);
+		P_GetSectorZsAt(front, fracx, fracy, &frontf, &frontc);
+		P_GetSectorZsAt(back, fracx, fracy, &backf, &backc);
 		// crosses a two sided line
 		// no wall to block sight with?
 		if (frontf == backf && frontc == backc
@@ -312,8 +310,7 @@ static boolean P_CrossSubsector(size_t num, register los_t *los)
 					continue;
 				}
 
-				topz    = P_GetFFloorTopZAt   (rover, fracx, fracy);
-				bottomz = P_GetFFloorBottomZAt(rover, fracx, fracy);
+				P_GetFFloorZsAt(rover, fracx, fracy, &topz, &bottomz);
 				topslope    = FixedDiv(   topz - los->sightzstart, frac);
 				bottomslope = FixedDiv(bottomz - los->sightzstart, frac);
 				if (topslope >= los->topslope && bottomslope <= los->bottomslope)
@@ -328,8 +325,7 @@ static boolean P_CrossSubsector(size_t num, register los_t *los)
 					continue;
 				}
 
-				topz    = P_GetFFloorTopZAt   (rover, fracx, fracy);
-				bottomz = P_GetFFloorBottomZAt(rover, fracx, fracy);
+				P_GetFFloorZsAt(rover, fracx, fracy, &topz, &bottomz);
 				topslope    = FixedDiv(   topz - los->sightzstart, frac);
 				bottomslope = FixedDiv(bottomz - los->sightzstart, frac);
 				if (topslope >= los->topslope && bottomslope <= los->bottomslope)
@@ -131,7 +131,7 @@ void T_DynamicSlopeLine (dynlineplanethink_t* th)
 	pslope_t* slope = th->slope;
 	line_t* srcline = th->sourceline;
 
-	fixed_t zdelta;
+	fixed_t zdelta, newzdelta;
 
 	switch(th->type) {
 	case DP_FRONTFLOOR:
@@ -158,30 +158,58 @@ void T_DynamicSlopeLine (dynlineplanethink_t* th)
 		return;
 	}
 
-	if (slope->zdelta != FixedDiv(zdelta, th->extent)) {
-		slope->zdelta = FixedDiv(zdelta, th->extent);
+	newzdelta = FixedDiv(zdelta, th->extent);
+
+	if (slope->zdelta != newzdelta) {
+		slope->zdelta = newzdelta;
 		slope->zangle = R_PointToAngle2(0, 0, th->extent, -zdelta);
 		P_CalculateSlopeNormal(slope);
 	}
 }
 
+// True if nothing (including Lua) has touched the slope's plane since it was cached.
+static boolean SlopePlaneMatches(const pslope_t *slope, const pslope_t *cached)
+{
+	return slope->o.x == cached->o.x && slope->o.y == cached->o.y && slope->o.z == cached->o.z
+		&& slope->normal.x == cached->normal.x && slope->normal.y == cached->normal.y && slope->normal.z == cached->normal.z
+		&& slope->d.x == cached->d.x && slope->d.y == cached->d.y
+		&& slope->zdelta == cached->zdelta
+		&& slope->zangle == cached->zangle && slope->xydirection == cached->xydirection;
+}
+
 /// Mapthing-defined
 void T_DynamicSlopeVert (dynvertexplanethink_t* th)
 {
 	size_t i;
+	boolean moved = !th->cached;
 
 	for (i = 0; i < 3; i++)
 	{
+		fixed_t z;
+
 		if (!th->secs[i])
 			continue;
 
 		if (th->relative & (1 << i))
-			th->vex[i].z = th->origvecheights[i] + (th->secs[i]->floorheight - th->origsecheights[i]);
+			z = th->origvecheights[i] + (th->secs[i]->floorheight - th->origsecheights[i]);
 		else
-			th->vex[i].z = th->secs[i]->floorheight;
+			z = th->secs[i]->floorheight;
+
+		if (th->vex[i].z != z)
+		{
+			th->vex[i].z = z;
+			moved = true;
+		}
 	}
 
+	// Reconfiguring is expensive (several divisions and angle lookups),
+	// so only do it when a vertex actually moved this tic.
+	if (!moved && SlopePlaneMatches(th->slope, &th->cachedplane))
+		return;
+
 	ReconfigureViaVertexes(th->slope, th->vex[0], th->vex[1], th->vex[2]);
+	th->cachedplane = *th->slope;
+	th->cached = true;
 }
 
 static inline void P_AddDynLineSlopeThinker (pslope_t* slope, dynplanetype_t type, line_t* sourceline, fixed_t extent)
@@ -755,12 +783,37 @@ void P_InitSlopes(void)
 // Returns the height of the sloped plane at (x, y) as a fixed_t
 fixed_t P_GetSlopeZAt(const pslope_t *slope, fixed_t x, fixed_t y)
 {
-	fixed_t dist = FixedMul(x - slope->o.x, slope->d.x) +
-	               FixedMul(y - slope->o.y, slope->d.y);
+	fixed_t dist;
+
+	// Dynamic slopes spend most of their time flat
+	if (!slope->zdelta)
+		return slope->o.z;
+
+	dist = FixedMul(x - slope->o.x, slope->d.x) +
+	       FixedMul(y - slope->o.y, slope->d.y);
 
 	return slope->o.z + FixedMul(dist, slope->zdelta);
 }
 
+// Evaluates the sloped plane at count points in one pass.
+// Results are identical to calling P_GetSlopeZAt for each point.
+void P_GetSlopeZsAt(const pslope_t *slope, const fixed_t *x, const fixed_t *y, fixed_t *z, size_t count)
+{
+	const fixed_t ox = slope->o.x, oy = slope->o.y, oz = slope->o.z;
+	const fixed_t dx = slope->d.x, dy = slope->d.y, zdelta = slope->zdelta;
+	size_t i;
+
+	if (!zdelta)
+	{
+		for (i = 0; i < count; i++)
+			z[i] = oz;
+		return;
+	}
+
+	for (i = 0; i < count; i++)
+		z[i] = oz + FixedMul(FixedMul(x[i] - ox, dx) + FixedMul(y[i] - oy, dy), zdelta);
+}
+
 // Like P_GetSlopeZAt but falls back to z if slope is NULL
 fixed_t P_GetZAt(const pslope_t *slope, fixed_t x, fixed_t y, fixed_t z)
 {
@@ -779,6 +832,13 @@ fixed_t P_GetSectorCeilingZAt(const sector_t *sector, fixed_t x, fixed_t y)
 	return sector->c_slope ? P_GetSlopeZAt(sector->c_slope, x, y) : sector->ceilingheight;
 }
 
+// Returns the heights of both sector planes at (x, y)
+void P_GetSectorZsAt(const sector_t *sector, fixed_t x, fixed_t y, fixed_t *floorz, fixed_t *ceilingz)
+{
+	*floorz   = sector->f_slope ? P_GetSlopeZAt(sector->f_slope, x, y) : sector->floorheight;
+	*ceilingz = sector->c_slope ? P_GetSlopeZAt(sector->c_slope, x, y) : sector->ceilingheight;
+}
+
 // Returns the height of the FOF top at (x, y)
 fixed_t P_GetFFloorTopZAt(const ffloor_t *ffloor, fixed_t x, fixed_t y)
 {
@@ -791,6 +851,15 @@ fixed_t P_GetFFloorBottomZAt(const ffloor_t *ffloor, fixed_t x, fixed_t y)
 	return *ffloor->b_slope ? P_GetSlopeZAt(*ffloor->b_slope, x, y) : *ffloor->bottomheight;
 }
 
+// Returns the heights of both FOF planes at (x, y)
+void P_GetFFloorZsAt(const ffloor_t *ffloor, fixed_t x, fixed_t y, fixed_t *topz, fixed_t *bottomz)
+{
+	const pslope_t *t_slope = *ffloor->t_slope, *b_slope = *ffloor->b_slope;
+
+	*topz    = t_slope ? P_GetSlopeZAt(t_slope, x, y) : *ffloor->topheight;
+	*bottomz = b_slope ? P_GetSlopeZAt(b_slope, x, y) : *ffloor->bottomheight;
+}
+
 // Returns the height of the light list at (x, y)
 fixed_t P_GetLightZAt(const lightlist_t *light, fixed_t x, fixed_t y)
 {
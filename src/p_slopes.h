@@ -69,13 +69,18 @@ fixed_t P_GetSlopeZAt(const pslope_t *slope, fixed_t x, fixed_t y);
 // Like P_GetSlopeZAt but falls back to z if slope is NULL
 fixed_t P_GetZAt(const pslope_t *slope, fixed_t x, fixed_t y, fixed_t z);
 
+// Evaluates the sloped plane at count points in one pass
+void P_GetSlopeZsAt(const pslope_t *slope, const fixed_t *x, const fixed_t *y, fixed_t *z, size_t count);
+
 // Returns the height of the sector at (x, y)
 fixed_t P_GetSectorFloorZAt  (const sector_t *sector, fixed_t x, fixed_t y);
 fixed_t P_GetSectorCeilingZAt(const sector_t *sector, fixed_t x, fixed_t y);
+void    P_GetSectorZsAt      (const sector_t *sector, fixed_t x, fixed_t y, fixed_t *floorz, fixed_t *ceilingz);
 
 // Returns the height of the FOF at (x, y)
 fixed_t P_GetFFloorTopZAt   (const ffloor_t *ffloor, fixed_t x, fixed_t y);
 fixed_t P_GetFFloorBottomZAt(const ffloor_t *ffloor, fixed_t x, fixed_t y);
+void    P_GetFFloorZsAt     (const ffloor_t *ffloor, fixed_t x, fixed_t y, fixed_t *topz, fixed_t *bottomz);
 
 // Returns the height of the light list at (x, y)
 fixed_t P_GetLightZAt(const lightlist_t *light, fixed_t x, fixed_t y);
@@ -117,6 +122,10 @@ typedef struct
 	fixed_t origsecheights[3];
 	fixed_t origvecheights[3];
 	UINT8 relative;
+
+	// Plane as of the last reconfigure; not archived, rebuilt on first run.
+	pslope_t cachedplane;
+	boolean cached;
 } dynvertexplanethink_t;
 
 void T_DynamicSlopeLine (dynlineplanethink_t* th);
@@ -23,6 +23,7 @@
 #include "lua_hook.h"
 #include "m_perfstats.h"
 #include "i_system.h" // I_GetPreciseTime
+#include "m_parallel.h"
 #include "r_main.h"
 #include "r_fps.h"
 #include "i_video.h" // rendermode
@@ -343,12 +344,101 @@ if ((*mop = targ) != NULL) // Set new target and if non-NULL, increase its count
 // Rewritten to delete nodes implicitly, by making currentthinker
 // external and using P_RemoveThinkerDelayed() implicitly.
 //
+
+// Precipitation thinkers that passed P_PrecipThinkerIsLocal this tic
+static precipmobj_t **localprecip = NULL;
+static size_t localprecip_capacity = 0;
+
+// Copies of them for cv_parallelcheck
+static precipmobj_t *checkprecip = NULL;
+static size_t checkprecip_capacity = 0;
+
+static void P_RunLocalPrecipSlice(void *userdata, size_t start, size_t end)
+{
+	precipmobj_t **list = userdata;
+	size_t i;
+
+	for (i = start; i < end; i++)
+		list[i]->thinker.function.acp1(&list[i]->thinker);
+}
+
+//
+// P_RunPrecipThinkers
+//
+// Precipitation never interacts with other objects, so this list is
+// split into a serial pass and a parallel "local update" phase.
+// Thinkers that may free themselves or touch the RNG run serially,
+// in list order, exactly as before; everything else is deferred and
+// spread over the worker pool. Results are identical either way.
+//
+static void P_RunPrecipThinkers(void)
+{
+	size_t numlocal = 0;
+
+	for (currentthinker = thlist[THINK_PRECIP].next; currentthinker != &thlist[THINK_PRECIP]; currentthinker = currentthinker->next)
+	{
+#ifdef PARANOIA
+		I_Assert(currentthinker->function.acp1 != NULL);
+#endif
+		if (currentthinker->function.acp1 == (actionf_p1)P_RemoveThinkerDelayed
+			|| !P_PrecipThinkerIsLocal((precipmobj_t *)currentthinker))
+		{
+			currentthinker->function.acp1(currentthinker);
+			continue;
+		}
+
+		if (numlocal >= localprecip_capacity)
+		{
+			localprecip_capacity = localprecip_capacity ? localprecip_capacity * 2 : 1024;
+			localprecip = Z_Realloc(localprecip, sizeof (*localprecip) * localprecip_capacity, PU_STATIC, NULL);
+		}
+		localprecip[numlocal++] = (precipmobj_t *)currentthinker;
+	}
+
+	if (cv_parallelcheck.value && numlocal)
+	{
+		size_t i, mismatches = 0;
+
+		if (numlocal > checkprecip_capacity)
+		{
+			checkprecip_capacity = localprecip_capacity;
+			checkprecip = Z_Realloc(checkprecip, sizeof (*checkprecip) * checkprecip_capacity, PU_STATIC, NULL);
+		}
+		for (i = 0; i < numlocal; i++)
+			checkprecip[i] = *localprecip[i];
+
+		M_ParallelFor(numlocal, 256, P_RunLocalPrecipSlice, localprecip);
+
+		// Local thinkers only touch the object itself, so running
+		// them on the copies must give exactly the same result
+		for (i = 0; i < numlocal; i++)
+		{
+			checkprecip[i].thinker.function.acp1(&checkprecip[i].thinker);
+			if (memcmp(&checkprecip[i], localprecip[i], sizeof (*checkprecip)))
+				mismatches++;
+		}
+
+		if (mismatches)
+			CONS_Alert(CONS_WARNING, "parallelcheck: %s of %s precipitation thinkers differ from a serial run on tic %u\n",
+				sizeu1(mismatches), sizeu2(numlocal), gametic);
+		return;
+	}
+
+	M_ParallelFor(numlocal, 256, P_RunLocalPrecipSlice, localprecip);
+}
+
 static inline void P_RunThinkers(void)
 {
 	size_t i;
 	for (i = 0; i < NUM_THINKERLISTS; i++)
 	{
 		PS_START_TIMING(ps_thlist_times[i]);
+		if (i == THINK_PRECIP)
+		{
+			P_RunPrecipThinkers();
+			PS_STOP_TIMING(ps_thlist_times[i]);
+			continue;
+		}
 		for (currentthinker = thlist[i].next; currentthinker != &thlist[i]; currentthinker = currentthinker->next)
 		{
 #ifdef PARANOIA
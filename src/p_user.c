@@ -10334,7 +10334,7 @@ boolean P_MoveChaseCamera(player_t *player, camera_t *thiscam, boolean resetcall
 
 						po->validcount = validcount;
 
-						if (!P_PointInsidePolyobj(po, x, y) || !(po->flags & POF_SOLID))
+						if (!(po->flags & POF_SOLID) || !P_PointInsidePolyobj(po, x, y))
 						{
 							plink = (polymaplink_t *)(plink->link.next);
 							continue;
@@ -719,26 +719,35 @@ void R_SortPolyObjects(subsector_t *sub)
 	}
 }
 
+// Polyobject seg with its vertices' view distances precomputed,
+// so sorting doesn't redo the trig for every comparison.
+typedef struct
+{
+	seg_t *seg;
+	fixed_t dist1, dist2;
+} polysegsort_t;
+
+static polysegsort_t *polysegsort = NULL;
+static size_t polysegsort_alloc = 0;
+
+// TODO might be a better way to get distance?
+static fixed_t R_PolysegViewDist(fixed_t x, fixed_t y)
+{
+	return FixedMul(R_PointToDist(x, y), FINECOSINE((R_PointToAngle(x, y)-viewangle)>>ANGLETOFINESHIFT))+0xFFFFFFF;
+}
+
 //
 // R_PolysegCompare
 //
-// Callback for qsort to sort the segs of a polyobject. Returns such that the
+// Compares two polyobject segs. Returns such that the
 // closer one is sorted first. I sure hope this doesn't break anything. -Red
 //
-static int R_PolysegCompare(const void *p1, const void *p2)
+static int R_PolysegCompare(const polysegsort_t *p1, const polysegsort_t *p2)
 {
-	const seg_t *seg1 = *(const seg_t * const *)p1;
-	const seg_t *seg2 = *(const seg_t * const *)p2;
-	fixed_t dist1v1, dist1v2, dist2v1, dist2v2;
-
-	// TODO might be a better way to get distance?
-#define pdist(x, y) (FixedMul(R_PointToDist(x, y), FINECOSINE((R_PointToAngle(x, y)-viewangle)>>ANGLETOFINESHIFT))+0xFFFFFFF)
-#define vxdist(v) pdist(v->x, v->y)
-
-	dist1v1 = vxdist(seg1->v1);
-	dist1v2 = vxdist(seg1->v2);
-	dist2v1 = vxdist(seg2->v1);
-	dist2v2 = vxdist(seg2->v2);
+	const seg_t *seg1 = p1->seg;
+	const seg_t *seg2 = p2->seg;
+	const fixed_t dist1v1 = p1->dist1, dist1v2 = p1->dist2;
+	const fixed_t dist2v1 = p2->dist1, dist2v2 = p2->dist2;
 
 	if (min(dist1v1, dist1v2) != min(dist2v1, dist2v2))
 		return min(dist1v1, dist1v2) - min(dist2v1, dist2v2);
@@ -781,10 +790,57 @@ static int R_PolysegCompare(const void *p1, const void *p2)
 		x2 = near2->x + FixedMul(far2->x-near2->x, delta2);
 		y2 = near2->y + FixedMul(far2->y-near2->y, delta2);
 
-		return pdist(x1, y1)-pdist(x2, y2);
+		return R_PolysegViewDist(x1, y1)-R_PolysegViewDist(x2, y2);
 	}
-#undef vxdist
-#undef pdist
+}
+
+//
+// R_SortPolysegs
+//
+// Sorts a polyobject's segs front-to-back for the current viewpoint.
+// The order is kept on the polyobject between frames: nothing is done
+// while neither the view nor the polyobject has moved, and otherwise the
+// previous order is usually nearly sorted already, which insertion sort
+// handles in close to linear time.
+//
+static void R_SortPolysegs(polyobj_t *po)
+{
+	size_t i, j;
+
+	if (po->segsorted && po->sortviewx == viewx && po->sortviewy == viewy && po->sortviewangle == viewangle)
+		return;
+
+	if (polysegsort_alloc < po->segCount)
+	{
+		polysegsort_alloc = po->segCount*2;
+		polysegsort = Z_Realloc(polysegsort, polysegsort_alloc * sizeof(*polysegsort), PU_STATIC, NULL);
+	}
+
+	for (i = 0; i < po->segCount; ++i)
+	{
+		seg_t *seg = po->segs[i];
+		polysegsort[i].seg = seg;
+		polysegsort[i].dist1 = R_PolysegViewDist(seg->v1->x, seg->v1->y);
+		polysegsort[i].dist2 = R_PolysegViewDist(seg->v2->x, seg->v2->y);
+	}
+
+	for (i = 1; i < po->segCount; ++i)
+	{
+		polysegsort_t cur = polysegsort[i];
+
+		for (j = i; j > 0 && R_PolysegCompare(&polysegsort[j-1], &cur) > 0; --j)
+			polysegsort[j] = polysegsort[j-1];
+
+		polysegsort[j] = cur;
+	}
+
+	for (i = 0; i < po->segCount; ++i)
+		po->segs[i] = polysegsort[i].seg;
+
+	po->segsorted = true;
+	po->sortviewx = viewx;
+	po->sortviewy = viewy;
+	po->sortviewangle = viewangle;
 }
 
 //
@@ -816,9 +872,15 @@ static void R_AddPolyObjects(subsector_t *sub)
 	// render polyobjects
 	for (i = 0; i < numpolys; ++i)
 	{
-		qsort(po_ptrs[i]->segs, po_ptrs[i]->segCount, sizeof(seg_t *), R_PolysegCompare);
-		for (j = 0; j < po_ptrs[i]->segCount; ++j)
-			R_AddLine(po_ptrs[i]->segs[j]);
+		po = po_ptrs[i];
+
+		// R_AddLine would reject every seg anyway
+		if (!(po->flags & POF_RENDERSIDES) || !R_CheckBBox(po->bbox))
+			continue;
+
+		R_SortPolysegs(po);
+		for (j = 0; j < po->segCount; ++j)
+			R_AddLine(po->segs[j]);
 	}
 }
 
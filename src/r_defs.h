@@ -499,6 +499,8 @@ typedef struct sector_s
 
 	// colormap structure
 	extracolormap_t *spawn_extra_colormap;
+
+	INT32 luaref; // Registry reference to this sector's Lua userdata, 0 if none
 } sector_t;
 
 //
@@ -23,6 +23,7 @@
 #include "z_zone.h"
 #include "console.h" // con_startup_loadprogress
 #include "m_perfstats.h" // ps_metric_t
+#include "m_parallel.h"
 #ifdef HWRENDER
 #include "hardware/hw_main.h" // for cv_glshearing
 #endif
@@ -529,6 +530,9 @@ void R_UpdateLevelInterpolators(void)
 {
 	size_t i;
 
+	if (dedicated)
+		return; // Nothing is ever drawn
+
 	for (i = 0; i < levelinterpolators_len; i++)
 	{
 		levelinterpolator_t *interp = levelinterpolators[i];
@@ -747,17 +751,67 @@ void R_InitMobjInterpolators(void)
 	interpolated_mobjs_capacity = 0;
 }
 
-void R_UpdateMobjInterpolators(void)
+static void R_UpdateMobjInterpolatorSlice(void *userdata, size_t start, size_t end)
 {
+	mobj_t **list = userdata;
 	size_t i;
-	for (i = 0; i < interpolated_mobjs_len; i++)
+	for (i = start; i < end; i++)
 	{
-		mobj_t *mobj = interpolated_mobjs[i];
+		mobj_t *mobj = list[i];
 		if (!P_MobjWasRemoved(mobj))
 			R_ResetMobjInterpolationState(mobj);
 	}
 }
 
+// Each mobj only copies its own fields here, so the list is split
+// across the worker pool.
+// Compares a parallel interpolator update against a serial one on copies
+// of the mobjs, for cv_parallelcheck. The copies are updated without their
+// player, so the player's drawangle history is not covered.
+static void R_CheckMobjInterpolators(void)
+{
+	static mobj_t *copies = NULL;
+	static size_t copies_capacity = 0;
+	size_t i, mismatches = 0;
+
+	if (interpolated_mobjs_len > copies_capacity)
+	{
+		copies_capacity = interpolated_mobjs_capacity;
+		copies = Z_Realloc(copies, sizeof (*copies) * copies_capacity, PU_STATIC, NULL);
+	}
+	for (i = 0; i < interpolated_mobjs_len; i++)
+		copies[i] = *interpolated_mobjs[i];
+
+	M_ParallelFor(interpolated_mobjs_len, 1024, R_UpdateMobjInterpolatorSlice, interpolated_mobjs);
+
+	for (i = 0; i < interpolated_mobjs_len; i++)
+	{
+		if (P_MobjWasRemoved(interpolated_mobjs[i]))
+			continue;
+		copies[i].player = NULL;
+		R_ResetMobjInterpolationState(&copies[i]);
+		copies[i].player = interpolated_mobjs[i]->player;
+		if (memcmp(&copies[i], interpolated_mobjs[i], sizeof (*copies)))
+			mismatches++;
+	}
+
+	if (mismatches)
+		CONS_Alert(CONS_WARNING, "parallelcheck: %s of %s interpolated mobjs differ from a serial update on tic %u\n",
+			sizeu1(mismatches), sizeu2(interpolated_mobjs_len), gametic);
+}
+
+void R_UpdateMobjInterpolators(void)
+{
+	if (dedicated)
+		return; // Nothing is ever drawn
+	if (cv_parallelcheck.value)
+	{
+		R_CheckMobjInterpolators();
+		return;
+	}
+	M_ParallelFor(interpolated_mobjs_len, 1024, R_UpdateMobjInterpolatorSlice, interpolated_mobjs);
+}
+
 //
 // P_ResetMobjInterpolationState
 //
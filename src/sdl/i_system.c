@@ -400,7 +400,6 @@ static void I_ReportSignal(int num, int coredumped)
 FUNCNORETURN static ATTRNORETURN void signal_handler(INT32 num)
 {
 	D_QuitNetGame(); // Fix server freezes
-	CL_AbortDownloadResume();
 #ifdef UNIXBACKTRACE
 	write_backtrace(num);
 #endif
@@ -2390,7 +2389,6 @@ void I_Quit(void)
 		G_StopMetalRecording(false);
 
 	D_QuitNetGame();
-	CL_AbortDownloadResume();
 	M_FreePlayerSetupColors();
 	I_ShutdownMusic();
 	I_ShutdownSound();
@@ -2517,7 +2515,6 @@ void I_Error(const char *error, ...)
 		G_StopMetalRecording(false);
 
 	D_QuitNetGame();
-	CL_AbortDownloadResume();
 	M_FreePlayerSetupColors();
 	I_ShutdownMusic();
 	I_ShutdownSound();
@@ -3124,6 +3121,31 @@ UINT32 I_GetFreeMem(UINT32 *total)
 #endif
 }
 
+size_t I_GetResidentMem(void)
+{
+#if defined (__linux__)
+	char buf[128];
+	unsigned long pages = 0;
+	INT32 n;
+	INT32 statm_fd = open("/proc/self/statm", O_RDONLY);
+
+	if (statm_fd == -1)
+		return 0;
+	n = read(statm_fd, buf, sizeof (buf) - 1);
+	close(statm_fd);
+	if (n <= 0)
+		return 0;
+	buf[n] = '\0';
+
+	// Total program size, then resident set size, in pages
+	if (sscanf(buf, "%*u %lu", &pages) != 1)
+		return 0;
+	return (size_t)pages * (size_t)sysconf(_SC_PAGESIZE);
+#else
+	return 0;
+#endif
+}
+
 const CPUInfoFlags *I_CPUInfo(void)
 {
 #if defined (_WIN32)